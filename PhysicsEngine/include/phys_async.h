@@ -0,0 +1,37 @@
+#ifndef PHYS_ASYNC_H
+#define PHYS_ASYNC_H
+
+#include <phys_engine.h>
+
+#if defined(__cpp_impl_coroutine) || (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L)
+#include <coroutine>
+
+namespace physic
+{
+	// co_await StepAwaitable{ engine, dt } runs step on engine worker thread,
+	// coroutine is resumed on that thread once the step is done. Result is false if no step
+	// was run because simulation thread is running, coroutine is not suspended then.
+	struct StepAwaitable
+	{
+		IEngine& engine;
+		double dt;
+		bool stepped = true;
+
+		bool await_ready() const noexcept { return false; }
+
+		bool await_suspend(std::coroutine_handle<> handle)
+		{
+			// Coroutine may be resumed and this destroyed before StepAsync returns true
+			if (engine.StepAsync(dt, [handle]() { handle.resume(); }))
+				return true;
+
+			stepped = false;
+			return false;
+		}
+
+		bool await_resume() const noexcept { return stepped; }
+	};
+} // namespace physic
+#endif
+
+#endif // PHYS_ASYNC_H
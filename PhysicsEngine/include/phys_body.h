@@ -4,6 +4,7 @@
 #include <phys_platform.h>
 #include <phys_utils.h>
 
+#include <cstdint>
 #include <memory>
 
 namespace physic
@@ -11,9 +12,39 @@ namespace physic
 	class IBody;
 	using BodyPtr = std::shared_ptr<IBody>;
 
+	// Unique for every created body, never reused
+	using BodyId = uint32_t;
+
+	// Bodies collide if category of each one is in mask of another.
+	// Bodies of same non-zero group always collide if group is positive and never if negative.
+	struct CollisionFilter
+	{
+		uint16_t category;
+		uint16_t mask;
+		int16_t group;
+	};
+
+	const CollisionFilter kDefaultCollisionFilter = { 0x0001, 0xFFFF, 0 };
+
+	inline bool ShouldCollide(const CollisionFilter& a, const CollisionFilter& b)
+	{
+		if (a.group == b.group && a.group != 0)
+			return a.group > 0;
+
+		return (a.mask & b.category) != 0 && (b.mask & a.category) != 0;
+	}
+
+	struct BodyState;
+
 	class IShape;
 	using ShapePtr = std::shared_ptr<IShape>;
 
+	// Index of registered shape, bodies of same geometry share one shape
+	using ShapeId = uint32_t;
+
+	// Circle of kDefaultBodyRadius, registered before any other shape
+	const ShapeId kDefaultShapeId = 0;
+
 	class PHYS_API IShape
 	{
 	public:
@@ -28,17 +59,39 @@ namespace physic
 		IShape() = default;
 		virtual ~IShape() = default;
 
+		// Shapes are immutable and keep only geometry in body local space,
+		// position of body is its transform
 		virtual ShapeType GetShapeType() const = 0;
 		virtual Point GetCenter() const = 0;
 		virtual int GetRadius() const = 0;
 		virtual fVec2D GetNormalVector() const = 0;
 		virtual bool Collide(IShape*) = 0;
+
+		// Same geometry registered again gets the same id. Shapes are never unregistered.
+		// Ids depend on order of registration, processes exchanging bodies must register shapes in the same order.
+		static ShapeId RegisterCircle(int radius);
+
+		// Shape of registered id, nullptr for unknown one
+		static ShapePtr GetShape(ShapeId);
 	};
 
 	class PHYS_API IBody
 	{
 	public:
 
+		enum class BodyType
+		{
+			// Moved by forces and collisions
+			Dynamic,
+			// Never moves, e.g. level geometry
+			Static,
+			// Moved only by its velocity, has infinite mass
+			Kinematic
+		};
+
+		virtual BodyId GetId() const = 0;
+		virtual BodyType GetBodyType() const = 0;
+
 		virtual Point GetPosition() const = 0;
 		virtual void SetPosition(const Point&) = 0;
 
@@ -48,23 +101,81 @@ namespace physic
 		virtual Mass GetMass() const = 0;
 		virtual void SetMass(const Mass&) = 0;
 
-		virtual float GetBounceFactor() const = 0;
-		virtual void SetBounceFactor(float) = 0;
+		virtual Scalar GetBounceFactor() const = 0;
+		virtual void SetBounceFactor(Scalar) = 0;
+
+		// Sensor bodies report contacts but don't collide
+		virtual bool IsSensor() const = 0;
+		virtual void SetSensor(bool) = 0;
+
+		virtual CollisionFilter GetCollisionFilter() const = 0;
+		virtual void SetCollisionFilter(const CollisionFilter&) = 0;
 
 		virtual void ApplyForce(const fVec2D&) = 0;
 		virtual void ApplyImpulse(const fVec2D&) = 0;
 
-		// TODO change time type from float to dedicated
-		virtual void Update(float dt) = 0;
+		// Sums of forces and impulses applied since last Update, e.g. to be saved along with state
+		virtual fVec2D GetPendingForce() const = 0;
+		virtual fVec2D GetPendingImpulse() const = 0;
+		virtual void SetPending(const fVec2D& force, const fVec2D& impulse) = 0;
+
+		// TODO change time type from Scalar to dedicated
+		// Same as IntegrateVelocity followed by IntegratePosition
+		virtual void Update(Scalar dt) = 0;
+		// Step split in two, so constraints can correct velocity before body moves:
+		// forces and impulses change velocity, then body moves along the path of its old velocity
+		// and the forces, or by the new velocity if it was set in between, e.g. by joints
+		virtual void IntegrateVelocity(Scalar dt) = 0;
+		virtual void IntegratePosition(Scalar dt) = 0;
 
 		// TODO move this to entity
 		virtual ShapePtr GetShape() const = 0;
+		virtual ShapeId GetShapeId() const = 0;
+		// Radius of shape cached in body, so hot paths don't look up the shape
+		virtual Scalar GetRadius() const = 0;
+
+		virtual BodyState GetState() const = 0;
+
+		// Grows on every change of position or collision filter, so copies of them,
+		// e.g. entries of spatial index, can tell they are stale
+		virtual uint32_t GetRevision() const = 0;
 
-		static BodyPtr CreateBody(IShape::ShapeType shape, const Point& position, const fVec2D& velocity, float mass);
+		// Mass is ignored for static and kinematic bodies
+		static BodyPtr CreateBody(IShape::ShapeType shape, const Point& position, const fVec2D& velocity, Scalar mass,
+			BodyType type = BodyType::Dynamic);
+
+		// Body of registered shape, unknown shape is replaced by the default one
+		static BodyPtr CreateBody(ShapeId shape, const Point& position, const fVec2D& velocity, Scalar mass,
+			BodyType type = BodyType::Dynamic);
+
+		// Recreate body saved by GetState with the same id
+		static BodyPtr CreateBody(const BodyState& state);
+
+		// New bodies get ids from [first, last) only, e.g. separate range for every process
+		// of distributed world. Recreated bodies with ids out of range don't affect it.
+		static void SetIdRange(BodyId first, BodyId last);
 
 		IBody() = default;
 		virtual ~IBody() = default;
 	};
+
+	// Everything needed to recreate body, pending forces and impulses are not kept.
+	// Trivially copyable, so it can be written to file or socket as is.
+	struct BodyState
+	{
+		BodyId id;
+		IBody::BodyType type;
+		IShape::ShapeType shape;
+		ShapeId shape_id;
+		Point position;
+		fVec2D velocity;
+		Scalar mass;
+		Scalar bounce_factor;
+		bool sensor;
+		CollisionFilter filter;
+	};
+
+	static_assert(std::is_trivially_copyable<BodyState>::value, "BodyState must be trivially copyable");
 }
 
 #endif // PHYS_BODY_H
\ No newline at end of file
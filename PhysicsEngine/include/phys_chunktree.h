@@ -0,0 +1,187 @@
+#ifndef PHYS_CHUNKTREE_H
+#define PHYS_CHUNKTREE_H
+
+#include <phys_quadtree.h>
+#include <phys_utils.h>
+#include <phys_workers.h>
+
+#include <cstdint>
+#include <type_traits>
+#include <unordered_map>
+
+namespace physic
+{
+	// Integer coordinates of world chunk, chunk (0, 0) starts at the origin
+	struct ChunkCoord
+	{
+		int32_t x;
+		int32_t y;
+	};
+
+	inline ChunkCoord GetChunkCoord(const Point& pos, Scalar chunk_size)
+	{
+		const double size = static_cast<double>(chunk_size);
+		return { static_cast<int32_t>(std::floor(static_cast<double>(pos.x) / size)),
+				 static_cast<int32_t>(std::floor(static_cast<double>(pos.y) / size)) };
+	}
+
+	inline uint64_t GetChunkKey(const ChunkCoord& coord)
+	{
+		return (static_cast<uint64_t>(static_cast<uint32_t>(coord.x)) << 32) | static_cast<uint32_t>(coord.y);
+	}
+
+	inline ChunkCoord GetChunkCoord(uint64_t key)
+	{
+		return { static_cast<int32_t>(static_cast<uint32_t>(key >> 32)), static_cast<int32_t>(static_cast<uint32_t>(key)) };
+	}
+
+	inline void GetChunkBounds(const ChunkCoord& coord, Scalar chunk_size, Point& bot_left, Point& top_right)
+	{
+		bot_left = Point{ chunk_size * Scalar(coord.x), chunk_size * Scalar(coord.y) };
+		top_right = Point{ bot_left.x + chunk_size, bot_left.y + chunk_size };
+	}
+
+	// Unbounded world split into square chunks, each one indexed by its own quadtree.
+	// Chunks are created on first insertion and dropped once they stay empty for a whole fill,
+	// so memory follows populated area and not world size. Tree is QuadTree or LinearQuadTree.
+	template <class T, class Tree = QuadTree<T>>
+	class ChunkTree
+	{
+	public:
+		using Entry = typename Tree::Entry;
+
+		// Workers are given to trees of all chunks, if the tree can use them
+		explicit ChunkTree(Scalar chunk_size, Workers* workers = nullptr)
+			: m_chunkSize(chunk_size)
+			, m_maxRadius(0)
+			, m_workers(workers)
+		{
+			assert(chunk_size > Scalar(0));
+		}
+
+		Scalar chunkSize() const
+		{
+			return m_chunkSize;
+		}
+
+		// Unlike quadtree insertion never fails, any position has its chunk
+		void insert(const T& body)
+		{
+			assert(body != nullptr);
+
+			const ChunkCoord coord = GetChunkCoord(body->GetPosition(), m_chunkSize);
+			auto it = m_chunks.find(GetChunkKey(coord));
+			if (it == m_chunks.end())
+			{
+				Point bot_left;
+				Point top_right;
+				GetChunkBounds(coord, m_chunkSize, bot_left, top_right);
+				it = m_chunks.emplace(GetChunkKey(coord), Chunk(bot_left, top_right, m_workers)).first;
+			}
+
+			Chunk& chunk = it->second;
+			const bool inserted = chunk.tree.insert(body);
+			assert(inserted);
+			(void)inserted;
+			++chunk.count;
+			m_maxRadius = std::max(m_maxRadius, chunk.tree.maxRadius());
+		}
+
+		// Index inserted objects, must be called after insertions and before queries
+		void build()
+		{
+			for (auto& chunk : m_chunks)
+				if (0 != chunk.second.count)
+					chunk.second.tree.build();
+		}
+
+		// Visit entries of nodes overlapping rectangle, visit(entry) returns false to stop.
+		// Entries stick out of their chunk by their radius, so chunks within the biggest
+		// radius around rectangle are walked too.
+		template <class Visit>
+		bool query(const Point& bot_left, const Point& top_right, Visit& visit) const
+		{
+			auto overlaps = [&](const Point& node_bot_left, const Point& node_top_right)
+			{
+				return bot_left.x <= node_top_right.x && node_bot_left.x <= top_right.x &&
+					bot_left.y <= node_top_right.y && node_bot_left.y <= top_right.y;
+			};
+
+			const ChunkCoord first = GetChunkCoord(Point{ bot_left.x - m_maxRadius, bot_left.y - m_maxRadius }, m_chunkSize);
+			const ChunkCoord last = GetChunkCoord(Point{ top_right.x + m_maxRadius, top_right.y + m_maxRadius }, m_chunkSize);
+
+			// Rectangle covering more chunks than there are is checked against every chunk
+			const double covered = (double(last.x) - first.x + 1) * (double(last.y) - first.y + 1);
+			if (covered > static_cast<double>(m_chunks.size()))
+				return traverse(overlaps, visit);
+
+			for (int32_t x = first.x; x <= last.x; ++x)
+				for (int32_t y = first.y; y <= last.y; ++y)
+				{
+					auto it = m_chunks.find(GetChunkKey({ x, y }));
+					if (it != m_chunks.end() && !it->second.tree.traverse(overlaps, visit))
+						return false;
+				}
+
+			return true;
+		}
+
+		// Same contract as QuadTree::traverse, chunks are walked in no particular order
+		template <class Accept, class Visit>
+		bool traverse(Accept& accept, Visit& visit) const
+		{
+			for (const auto& chunk : m_chunks)
+				if (!chunk.second.tree.traverse(accept, visit))
+					return false;
+
+			return true;
+		}
+
+		void clear()
+		{
+			for (auto it = m_chunks.begin(); it != m_chunks.end();)
+			{
+				if (0 == it->second.count)
+				{
+					it = m_chunks.erase(it);
+					continue;
+				}
+
+				it->second.tree.clear();
+				it->second.count = 0;
+				++it;
+			}
+
+			m_maxRadius = 0;
+		}
+
+	private:
+		struct Chunk
+		{
+			Chunk(const Point& bot_left, const Point& top_right, Workers* workers)
+				: tree(makeTree(bot_left, top_right, workers))
+				, count(0)
+			{
+			}
+
+			static Tree makeTree(const Point& bot_left, const Point& top_right, Workers* workers)
+			{
+				if constexpr (std::is_constructible<Tree, int, Point, Point, Workers*>::value)
+					return Tree(0, bot_left, top_right, workers);
+				else
+					return Tree(0, bot_left, top_right);
+			}
+
+			Tree tree;
+			// Objects inserted since last clear
+			size_t count;
+		};
+
+		Scalar m_chunkSize;
+		Scalar m_maxRadius;
+		Workers* m_workers;
+		std::unordered_map<uint64_t, Chunk> m_chunks;
+	};
+} // namespace physic
+
+#endif // PHYS_CHUNKTREE_H
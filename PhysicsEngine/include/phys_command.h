@@ -0,0 +1,29 @@
+#ifndef PHYS_COMMAND_H
+#define PHYS_COMMAND_H
+
+#include <phys_platform.h>
+#include <phys_body.h>
+
+namespace physic
+{
+	// Change of engine or body made from another thread, applied by engine at the beginning of step
+	struct BodyCommand
+	{
+		enum class Type
+		{
+			Add,
+			Remove,
+			ApplyForce,
+			ApplyImpulse,
+			SetPosition,
+			SetVelocity
+		};
+
+		Type type;
+		BodyPtr body;
+		// Force, impulse, position or velocity, unused by Add and Remove
+		fVec2D value;
+	};
+} // namespace physic
+
+#endif // PHYS_COMMAND_H
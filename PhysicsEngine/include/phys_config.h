@@ -0,0 +1,17 @@
+#ifndef PHYS_CONFIG_H
+#define PHYS_CONFIG_H
+
+// Build options of the engine. Every public header includes this one, so the engine
+// and programs using it are built with the same options. Change them here only,
+// not in project settings, and rebuild everything after that.
+
+// Scalar type is float unless one of these is defined:
+// double for large worlds, fixed-point physic::Fixed for deterministic lockstep simulation.
+//#define PHYS_SCALAR_DOUBLE
+//#define PHYS_SCALAR_FIXED
+
+#if defined(PHYS_SCALAR_DOUBLE) && defined(PHYS_SCALAR_FIXED)
+#error Only one Scalar type can be selected
+#endif
+
+#endif // PHYS_CONFIG_H
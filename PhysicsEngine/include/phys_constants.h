@@ -5,15 +5,21 @@
 
 namespace physic
 {
-	const float kGravity = 9.81f;
-	const float kBounceFactor = 0.75f;
-	const float kAirDragFactor = 0.f;
-	const float kGroundFriction = 0.f;
+	const Scalar kGravity = 9.81f;
+	const Scalar kBounceFactor = 0.75f;
+	const Scalar kAirDragFactor = 0.f;
+	const Scalar kGroundFriction = 0.f;
 
-	const double kPi = 3.141592;
+	const int kDefaultBodyRadius = 10;
 
 	const Point kWorldBotLeft = { 0, 0 };
 	const Point kWorldTopRight = { 2048, 2048 };
+
+	// Side of square chunk the world is split into for indexing and streaming
+	const Scalar kWorldChunkSize = 1024;
+
+	// Side of square cell segments of terrain are indexed by
+	const Scalar kTerrainCellSize = 64;
 }
 
 #endif // PHYS_CONSTANTS_H
\ No newline at end of file
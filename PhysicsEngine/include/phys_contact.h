@@ -0,0 +1,44 @@
+#ifndef PHYS_CONTACT_H
+#define PHYS_CONTACT_H
+
+#include <phys_platform.h>
+#include <phys_body.h>
+
+namespace physic
+{
+	struct ContactEvent
+	{
+		enum class Type
+		{
+			Begin,
+			Persist,
+			End
+		};
+
+		Type type;
+
+		// first < second, same pair always comes in same order
+		BodyId first;
+		BodyId second;
+
+		// At least one of bodies is sensor, contact was not solved
+		bool sensor;
+
+		// Contact point and normal from first to second body, zero for End events
+		Point point;
+		fVec2D normal;
+	};
+
+	class PHYS_API IContactListener
+	{
+	public:
+		// Called once at the end of every step which had contact changes or touching bodies.
+		// Events are valid only until return from this call.
+		virtual void OnContacts(const ContactEvent* events, size_t count) = 0;
+
+	protected:
+		~IContactListener() = default;
+	};
+} // namespace physic
+
+#endif // PHYS_CONTACT_H
\ No newline at end of file
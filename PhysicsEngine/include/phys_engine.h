@@ -3,21 +3,160 @@
 
 #include <phys_platform.h>
 #include <phys_body.h>
+#include <phys_command.h>
+#include <phys_contact.h>
+#include <phys_export.h>
+#include <phys_forcefield.h>
+#include <phys_frame.h>
+#include <phys_joint.h>
+#include <phys_lod.h>
+#include <phys_particles.h>
+#include <phys_query.h>
+#include <phys_stats.h>
+#include <phys_streaming.h>
+#include <phys_terrain.h>
 #include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
 
 namespace physic
 {
+	class IEngine;
+	using EnginePtr = std::shared_ptr<IEngine>;
+
 	class PHYS_API IEngine
 	{
 	public:
+		// Bodies bounce off world borders unless activity regions are set, chunked world has no borders
 		virtual void SetWorldBorders(Point bottom_left, Point top_right) = 0;
-		virtual void SetWorldConstants(float gravity, float air_drag, float ground_friction) = 0;
+		virtual void SetWorldConstants(Scalar gravity, Scalar air_drag, Scalar ground_friction) = 0;
 		virtual void AddBody(BodyPtr&) = 0;
 		virtual void RemoveBody(const BodyPtr&) = 0;
 
+		// Apply forces[i] to bodies[i] for each of count bodies
+		virtual void ApplyForces(const BodyPtr* bodies, const fVec2D* forces, size_t count) = 0;
+
+		// Registered fields are evaluated for all bodies on every step
+		virtual void AddForceField(const ForceFieldPtr&) = 0;
+		virtual void RemoveForceField(const ForceFieldPtr&) = 0;
+
+		// Dynamic bodies and particles colliding with statics bounce off terrain. Chain connects
+		// count points one by one, closed chain also connects the last point to the first one.
+		virtual TerrainId AddSegmentChain(const Point* points, size_t count, bool closed) = 0;
+		// Ground below line through count heights above origin, taken every spacing along x
+		virtual TerrainId AddHeightfield(const Point& origin, Scalar spacing, const Scalar* heights, size_t count) = 0;
+		// Returns false if there is no such terrain
+		virtual bool RemoveTerrain(TerrainId) = 0;
+
+		// Joints are solved on every step after forces are applied. Joints of removed bodies are removed too.
+		virtual JointId AddJoint(const JointDef&) = 0;
+		// Returns false if there is no such joint
+		virtual bool RemoveJoint(JointId) = 0;
+
+		// Registered particle systems are moved at the end of every step
+		virtual void AddParticleSystem(const ParticleSystemPtr&) = 0;
+		virtual void RemoveParticleSystem(const ParticleSystemPtr&) = 0;
+
+		// The only call safe from any thread. Commands are applied in order of pushing at the beginning of next step.
+		// Queue is bounded and never allocates, returns false if it is full and command is dropped.
+		virtual bool PushCommand(BodyCommand command) = 0;
+
 		virtual void Step(double dt) = 0;
 
-		static IEngine* Instance();
+		// With max_dt above zero Step splits dt into substeps, the longest ones which keep bodies
+		// from moving more than a part of their radius and touching bodies from overlapping too deep,
+		// but within [min_dt, max_dt]. Each substep is a step with its own index, checkpoint and
+		// contact events. Zero max_dt makes Step simulate dt at once, otherwise min_dt must be above zero.
+		virtual void SetAdaptiveStep(double min_dt, double max_dt) = 0;
+		// Split of time and the bounds it was chosen by for last call of Step
+		virtual StepStats GetStepStats() const = 0;
+
+		// Run Step on engine worker thread and publish frame after it, so host can draw the previous
+		// frame meanwhile. Until the step is done engine should be changed only through PushCommand
+		// and read only through GetFrame. Steps requested before the previous one is done run in order.
+		// While simulation thread runs no step is requested and the future holds std::logic_error.
+		virtual std::future<void> StepAsync(double dt) = 0;
+		// Same, but done is called on worker thread right after the step, e.g. to resume a coroutine
+		// (see phys_async.h). Returns false and never calls done while simulation thread runs.
+		virtual bool StepAsync(double dt, std::function<void()> done) = 0;
+
+		// Run Step with dt every dt seconds on a dedicated thread. Steps requested by StepAsync are
+		// finished before it starts. While it runs, the engine should be changed only through
+		// PushCommand and read only through GetFrame.
+		virtual void StartSimulation(double dt) = 0;
+		virtual void StopSimulation() = 0;
+		// Last frame published by simulation thread, nullptr before the first one. Safe from any thread.
+		virtual FramePtr GetFrame() const = 0;
+
+		// Listener gets all contact events of step at once after the step, nullptr to disable
+		virtual void SetContactListener(IContactListener*) = 0;
+
+		// Only chunks overlapping any of regions are simulated, bodies of other chunks are frozen
+		// and not seen by queries. Without regions whole world is active and bounded by world borders,
+		// with regions it is unbounded and world borders are only a hint of where bodies mostly are.
+		virtual void SetActivityRegions(const ActivityRegion* regions, size_t count) = 0;
+		// Frozen chunks are written to files in directory and released from memory,
+		// empty directory keeps them in memory
+		virtual void SetStreamingDirectory(const std::string& directory) = 0;
+		// Listener gets bodies written to and read from streaming directory, nullptr to disable
+		virtual void SetChunkListener(IChunkListener*) = 0;
+
+		// Bodies near focus points, e.g. players or cameras, are stepped every step, farther ones
+		// at rate of their tier and keep state of their last step in between. Forces applied to them
+		// are summed until their step. Without focus points or tiers all bodies are stepped every step.
+		virtual void SetFocusPoints(const Point* points, size_t count) = 0;
+		virtual void SetLodTiers(const LodTier* tiers, size_t count) = 0;
+
+		// Number of finished steps
+		virtual uint64_t GetStepIndex() const = 0;
+
+		// Keep positions, velocities, set of bodies with frozen and streamed out ones, and joints
+		// after each of last count steps, zero to disable. Chunk files read back are kept on disk
+		// while checkpoints need them. Other body properties and activity regions are not kept.
+		virtual void SetCheckpointCount(size_t count) = 0;
+		// Return to state after step, e.g. to apply late input and step again.
+		// Checkpoints of later steps are dropped. Returns false if step is not kept.
+		virtual bool Rewind(uint64_t step) = 0;
+
+		// Replace states with the ones of all active bodies, e.g. for replication or saving
+		virtual void GetBodyStates(std::vector<BodyState>& states) const = 0;
+
+		// Exporter gets ids, positions and velocities of all bodies at the end of every step, nullptr to disable
+		virtual void SetStateExporter(const StateExporterPtr&) = 0;
+
+		// Copy ids, positions and velocities of all active bodies into buffer of capacity bodies.
+		// Returns number of bodies, if it is above capacity the rest did not fit.
+		virtual size_t ExportBodies(ExportedBody* bodies, size_t capacity) const = 0;
+
+		// Spatial queries see bodies as they were at the end of last step
+
+		// Closest body crossed by segment, returns false if there is none
+		virtual bool Raycast(const Point& from, const Point& to, RaycastHit& hit) const = 0;
+		// Every body crossed by segment
+		virtual void RaycastAll(const Point& from, const Point& to, IRaycastCallback&) const = 0;
+		// Closest hit for each of count rays, rays are split between worker threads
+		virtual void RaycastBatch(const RaycastRequest* rays, RaycastHit* hits, size_t count) const = 0;
+
+		// Bodies overlapping rectangle or circle
+		virtual void QueryRect(const Point& bot_left, const Point& top_right, IQueryCallback&) const = 0;
+		virtual void QueryCircle(const Point& center, Scalar radius, IQueryCallback&) const = 0;
+
+		// Up to k bodies closest to point, sorted by distance. Returns number of found bodies.
+		virtual size_t QueryNearest(const Point& point, size_t k, NearestHit* hits) const = 0;
+
+		// Same as ExportBodies for bodies overlapping rectangle, e.g. viewport of a camera
+		virtual size_t ExportBodiesInRect(const Point& bot_left, const Point& top_right,
+			ExportedBody* bodies, size_t capacity) const = 0;
+
+		// Scalar is filled in by the caller, so code built with other options of phys_config.h
+		// than the engine gets std::logic_error here instead of memory corruption later
+		static IEngine* Instance(ScalarKind scalar = kScalarKind);
+
+		// Engine apart from the global instance, e.g. one per region of distributed world in a single process
+		static EnginePtr Create(ScalarKind scalar = kScalarKind);
 	protected:
 		IEngine() = default;
 		virtual ~IEngine() = default;
@@ -0,0 +1,79 @@
+#ifndef PHYS_EXPORT_H
+#define PHYS_EXPORT_H
+
+#include <phys_platform.h>
+#include <phys_body.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace physic
+{
+	// Body state as laid out in shared memory, readers should be built with the same Scalar
+	struct ExportedBody
+	{
+		BodyId id;
+		Point position;
+		fVec2D velocity;
+	};
+
+	static_assert(std::is_trivially_copyable<ExportedBody>::value, "ExportedBody must be trivially copyable");
+
+	class IStateExporter;
+	using StateExporterPtr = std::shared_ptr<IStateExporter>;
+
+	// Writing side of shared memory region with three snapshot buffers.
+	// Writer never waits for readers, each buffer is guarded by a sequence lock.
+	class PHYS_API IStateExporter
+	{
+	public:
+		// Buffer for next snapshot, written in place. Returns its capacity in bodies.
+		virtual ExportedBody* BeginWrite(size_t& capacity) = 0;
+		// Publish buffer got from BeginWrite. Total is number of bodies which did not have to fit into capacity.
+		virtual void EndWrite(uint64_t step, size_t count, size_t total) = 0;
+
+		// Create or replace named region for up to capacity bodies, nullptr on failure
+		static StateExporterPtr Create(const std::string& name, size_t capacity);
+
+		IStateExporter() = default;
+		virtual ~IStateExporter() = default;
+	};
+
+	// Snapshot mapped from shared memory, bodies point right into the region
+	struct StateView
+	{
+		uint64_t step;
+		const ExportedBody* bodies;
+		size_t count;
+		size_t total;
+
+		// Lock sequence of buffer the view was taken from
+		uint64_t sequence;
+		uint32_t slot;
+	};
+
+	class IStateReader;
+	using StateReaderPtr = std::shared_ptr<IStateReader>;
+
+	class PHYS_API IStateReader
+	{
+	public:
+		// Latest published snapshot without copying. Returns false if nothing was published yet.
+		virtual bool Acquire(StateView& view) const = 0;
+		// True if writer did not touch buffer of view since Acquire, check it after reading the bodies
+		virtual bool Validate(const StateView& view) const = 0;
+
+		// Consistent copy of latest snapshot, retried while writer overwrites it
+		virtual bool Read(std::vector<ExportedBody>& bodies, uint64_t& step) const = 0;
+
+		// Open region created by exporter, nullptr if there is none or it was built with another layout
+		static StateReaderPtr Open(const std::string& name);
+
+		IStateReader() = default;
+		virtual ~IStateReader() = default;
+	};
+} // namespace physic
+
+#endif // PHYS_EXPORT_H
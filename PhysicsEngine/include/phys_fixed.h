@@ -0,0 +1,273 @@
+#ifndef PHYS_FIXED_H
+#define PHYS_FIXED_H
+
+#include <phys_platform.h>
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+
+namespace physic
+{
+	// Deterministic fixed-point number with 16 fractional bits stored in 64-bit integer.
+	// All arithmetic is done on integers, so results are bit-exact on every machine.
+	class PHYS_API Fixed
+	{
+	public:
+		static constexpr int kFractionBits = 16;
+		static constexpr int64_t kOne = int64_t(1) << kFractionBits;
+
+		constexpr Fixed() : m_raw(0) {}
+
+		template <typename I, typename = typename std::enable_if<std::is_integral<I>::value>::type>
+		constexpr Fixed(I value) : m_raw(static_cast<int64_t>(value) * kOne) {}
+
+		// Round half away from zero
+		constexpr Fixed(float value) : Fixed(static_cast<double>(value)) {}
+		constexpr Fixed(double value) : m_raw(static_cast<int64_t>(value * kOne + (value < 0 ? -0.5 : 0.5))) {}
+
+		static constexpr Fixed FromRaw(int64_t raw) { Fixed f; f.m_raw = raw; return f; }
+		constexpr int64_t Raw() const { return m_raw; }
+
+		explicit constexpr operator int() const { return static_cast<int>(m_raw / kOne); }
+		explicit constexpr operator float() const { return static_cast<float>(m_raw) / kOne; }
+		explicit constexpr operator double() const { return static_cast<double>(m_raw) / kOne; }
+		explicit constexpr operator bool() const { return 0 != m_raw; }
+
+		constexpr Fixed operator-() const { return FromRaw(-m_raw); }
+
+		constexpr Fixed& operator+=(const Fixed& v) { m_raw += v.m_raw; return *this; }
+		constexpr Fixed& operator-=(const Fixed& v) { m_raw -= v.m_raw; return *this; }
+
+		constexpr Fixed& operator*=(const Fixed& v)
+		{
+			// Split integer and fractional parts to keep the product in 64 bits
+			const int64_t high = m_raw >> kFractionBits;
+			const int64_t low = m_raw & (kOne - 1);
+			m_raw = high * v.m_raw + ((low * v.m_raw) >> kFractionBits);
+			return *this;
+		}
+
+		constexpr Fixed& operator/=(const Fixed& v)
+		{
+			assert(0 != v.m_raw);
+			// Long division of magnitudes, quotient and remainder are scaled separately
+			const bool negative = (m_raw < 0) != (v.m_raw < 0);
+			const uint64_t dividend = m_raw < 0 ? uint64_t(0) - static_cast<uint64_t>(m_raw) : static_cast<uint64_t>(m_raw);
+			const uint64_t divisor = v.m_raw < 0 ? uint64_t(0) - static_cast<uint64_t>(v.m_raw) : static_cast<uint64_t>(v.m_raw);
+
+			uint64_t quotient = dividend / divisor;
+			uint64_t remainder = dividend % divisor;
+			if (divisor <= (UINT64_MAX >> kFractionBits))
+			{
+				// Scaled remainder fits in 64 bits
+				quotient = (quotient << kFractionBits) + (remainder << kFractionBits) / divisor;
+			}
+			else
+			{
+				// One bit at a time, remainder is below divisor so doubling it never overflows
+				for (int bit = 0; bit < kFractionBits; ++bit)
+				{
+					remainder <<= 1;
+					quotient <<= 1;
+					if (remainder >= divisor)
+					{
+						remainder -= divisor;
+						quotient |= 1;
+					}
+				}
+			}
+
+			m_raw = negative ? -static_cast<int64_t>(quotient) : static_cast<int64_t>(quotient);
+			return *this;
+		}
+
+		friend constexpr Fixed operator+(Fixed l, const Fixed& r) { return l += r; }
+		friend constexpr Fixed operator-(Fixed l, const Fixed& r) { return l -= r; }
+		friend constexpr Fixed operator*(Fixed l, const Fixed& r) { return l *= r; }
+		friend constexpr Fixed operator/(Fixed l, const Fixed& r) { return l /= r; }
+
+		friend constexpr bool operator==(const Fixed& l, const Fixed& r) { return l.m_raw == r.m_raw; }
+		friend constexpr bool operator!=(const Fixed& l, const Fixed& r) { return l.m_raw != r.m_raw; }
+		friend constexpr bool operator<(const Fixed& l, const Fixed& r) { return l.m_raw < r.m_raw; }
+		friend constexpr bool operator>(const Fixed& l, const Fixed& r) { return l.m_raw > r.m_raw; }
+		friend constexpr bool operator<=(const Fixed& l, const Fixed& r) { return l.m_raw <= r.m_raw; }
+		friend constexpr bool operator>=(const Fixed& l, const Fixed& r) { return l.m_raw >= r.m_raw; }
+
+		typedef int64_t type;
+
+	private:
+		int64_t m_raw;
+	};
+
+	// Math functions are found by argument dependent lookup, same as std:: ones for built-in types
+	constexpr Fixed abs(const Fixed& v) { return v.Raw() < 0 ? -v : v; }
+	// Half away from zero, same as std::round
+	constexpr Fixed round(const Fixed& v)
+	{
+		return v.Raw() < 0 ? Fixed::FromRaw(-((-v.Raw() + Fixed::kOne / 2) & ~(Fixed::kOne - 1)))
+			: Fixed::FromRaw((v.Raw() + Fixed::kOne / 2) & ~(Fixed::kOne - 1));
+	}
+
+	constexpr Fixed sqrt(const Fixed& v)
+	{
+		assert(v.Raw() >= 0);
+
+		// Integer square root of raw value shifted by fractional bits.
+		// Too big values lose half of fractional bits instead of overflowing.
+		const bool shift = v.Raw() < (int64_t(1) << (62 - Fixed::kFractionBits));
+		uint64_t n = shift ? static_cast<uint64_t>(v.Raw()) << Fixed::kFractionBits : static_cast<uint64_t>(v.Raw());
+
+		uint64_t res = 0;
+		uint64_t bit = uint64_t(1) << 62;
+		while (bit > n)
+			bit >>= 2;
+
+		while (bit != 0)
+		{
+			if (n >= res + bit)
+			{
+				n -= res + bit;
+				res = (res >> 1) + bit;
+			}
+			else
+				res >>= 1;
+			bit >>= 2;
+		}
+
+		return Fixed::FromRaw(shift ? static_cast<int64_t>(res) : static_cast<int64_t>(res) << (Fixed::kFractionBits / 2));
+	}
+
+	// Trigonometry by CORDIC: rotations by angles of atan(2^-i) done with shifts and additions
+	// on integers with 30 fractional bits, so results don't depend on floating point of the machine.
+	namespace cordic
+	{
+		constexpr int kBits = 30;
+		constexpr int kIterations = 30;
+
+		// atan(2^-i) scaled by 2^30
+		constexpr int64_t kAngles[kIterations] = {
+			843314857, 497837829, 263043837, 133525159, 67021687, 33543516, 16775851, 8388437,
+			4194283, 2097149, 1048576, 524288, 262144, 131072, 65536, 32768,
+			16384, 8192, 4096, 2048, 1024, 512, 256, 128,
+			64, 32, 16, 8, 4, 2 };
+
+		// Inverse of length gain of all rotations
+		constexpr int64_t kInvGain = 652032874;
+		constexpr int64_t kPi = 3373259426;
+		constexpr int64_t kHalfPi = 1686629713;
+		constexpr int64_t kTwoPi = 6746518852;
+		// 2 pi with fixed-point fractional bits, for angles too big to be scaled up
+		constexpr int64_t kTwoPiFixed = 411775;
+
+		constexpr Fixed ToFixed(int64_t value)
+		{
+			return Fixed::FromRaw((value + (int64_t(1) << (kBits - Fixed::kFractionBits - 1))) >> (kBits - Fixed::kFractionBits));
+		}
+
+		// Cosine and sine of fixed-point angle in radians, both with 30 fractional bits
+		constexpr void Rotate(const Fixed& angle, int64_t& cos_value, int64_t& sin_value)
+		{
+			// Angle is brought to [-pi, pi]
+			const int64_t raw = angle.Raw();
+			const int shift = kBits - Fixed::kFractionBits;
+			int64_t z = (raw < (int64_t(1) << 48) && raw > -(int64_t(1) << 48)) ?
+				(raw << shift) % kTwoPi : (raw % kTwoPiFixed) << shift;
+			if (z > kPi)
+				z -= kTwoPi;
+			else if (z < -kPi)
+				z += kTwoPi;
+
+			// and then to [-pi/2, pi/2], sine keeps its value and cosine changes sign
+			bool flip = false;
+			if (z > kHalfPi)
+			{
+				z = kPi - z;
+				flip = true;
+			}
+			else if (z < -kHalfPi)
+			{
+				z = -kPi - z;
+				flip = true;
+			}
+
+			int64_t x = kInvGain;
+			int64_t y = 0;
+			for (int i = 0; i < kIterations; ++i)
+			{
+				const int64_t dx = y >> i;
+				const int64_t dy = x >> i;
+				if (z >= 0)
+				{
+					x -= dx;
+					y += dy;
+					z -= kAngles[i];
+				}
+				else
+				{
+					x += dx;
+					y -= dy;
+					z += kAngles[i];
+				}
+			}
+
+			cos_value = flip ? -x : x;
+			sin_value = y;
+		}
+
+		// Angle of vector (x, y) with x >= 0, both with 30 fractional bits
+		constexpr int64_t Atan(int64_t x, int64_t y)
+		{
+			int64_t z = 0;
+			for (int i = 0; i < kIterations; ++i)
+			{
+				const int64_t dx = y >> i;
+				const int64_t dy = x >> i;
+				if (y >= 0)
+				{
+					x += dx;
+					y -= dy;
+					z += kAngles[i];
+				}
+				else
+				{
+					x -= dx;
+					y += dy;
+					z -= kAngles[i];
+				}
+			}
+			return z;
+		}
+	} // namespace cordic
+
+	constexpr Fixed cos(const Fixed& v)
+	{
+		int64_t cos_value = 0;
+		int64_t sin_value = 0;
+		cordic::Rotate(v, cos_value, sin_value);
+		return cordic::ToFixed(cos_value);
+	}
+
+	constexpr Fixed sin(const Fixed& v)
+	{
+		int64_t cos_value = 0;
+		int64_t sin_value = 0;
+		cordic::Rotate(v, cos_value, sin_value);
+		return cordic::ToFixed(sin_value);
+	}
+
+	// Argument is clamped to [-1, 1], rounding may take cosine of angle between vectors out of it
+	constexpr Fixed acos(const Fixed& v)
+	{
+		const Fixed c = v > Fixed(1) ? Fixed(1) : (v < Fixed(-1) ? Fixed(-1) : v);
+		const int shift = cordic::kBits - Fixed::kFractionBits;
+		const int64_t x = c.Raw() << shift;
+		const int64_t y = sqrt(Fixed(1) - c * c).Raw() << shift;
+
+		// acos(c) is angle of vector (c, sqrt(1 - c^2)), the left half is mirrored
+		return cordic::ToFixed(x >= 0 ? cordic::Atan(x, y) : cordic::kPi - cordic::Atan(-x, y));
+	}
+} // namespace physic
+
+#endif // PHYS_FIXED_H
\ No newline at end of file
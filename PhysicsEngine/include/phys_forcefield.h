@@ -0,0 +1,55 @@
+#ifndef PHYS_FORCEFIELD_H
+#define PHYS_FORCEFIELD_H
+
+#include <phys_platform.h>
+#include <phys_utils.h>
+
+#include <memory>
+
+namespace physic
+{
+	class IForceField;
+	using ForceFieldPtr = std::shared_ptr<IForceField>;
+
+	// State of bodies gathered by engine into contiguous arrays,
+	// so every field is evaluated in one pass over all affected bodies
+	struct FieldBodies
+	{
+		const Point* positions;
+		const fVec2D* velocities;
+		const Scalar* masses;
+		size_t count;
+	};
+
+	class PHYS_API IForceField
+	{
+	public:
+		// Local fields return true and fill bounds, engine passes only bodies inside of them.
+		// Global fields return false and are evaluated for all bodies.
+		virtual bool GetBounds(Point& bot_left, Point& top_right) const = 0;
+
+		// Add force of the field for every body to forces[i]
+		virtual void Evaluate(const FieldBodies& bodies, fVec2D* forces) const = 0;
+
+		// Constant acceleration for all bodies, e.g. gravity
+		static ForceFieldPtr CreateUniform(const fVec2D& acceleration);
+
+		// Force opposite to body velocity, e.g. air drag
+		static ForceFieldPtr CreateDrag(Scalar factor);
+
+		// Drag bodies inside of rectangle towards wind velocity
+		static ForceFieldPtr CreateWind(const Point& bot_left, const Point& top_right, const fVec2D& velocity, Scalar factor);
+
+		// Acceleration towards center fading out to zero at radius.
+		// Negative strength pushes bodies away, e.g. explosion.
+		static ForceFieldPtr CreateRadial(const Point& center, Scalar radius, Scalar strength);
+
+		// Damped spring pulling bodies inside of radius to anchor
+		static ForceFieldPtr CreateSpring(const Point& anchor, Scalar radius, Scalar stiffness, Scalar damping);
+
+		IForceField() = default;
+		virtual ~IForceField() = default;
+	};
+} // namespace physic
+
+#endif // PHYS_FORCEFIELD_H
\ No newline at end of file
@@ -0,0 +1,22 @@
+#ifndef PHYS_FRAME_H
+#define PHYS_FRAME_H
+
+#include <phys_platform.h>
+#include <phys_export.h>
+
+#include <memory>
+#include <vector>
+
+namespace physic
+{
+	// Read-only state of all bodies after a step, never changed once published
+	struct Frame
+	{
+		uint64_t step;
+		std::vector<ExportedBody> bodies;
+	};
+
+	using FramePtr = std::shared_ptr<const Frame>;
+} // namespace physic
+
+#endif // PHYS_FRAME_H
@@ -0,0 +1,36 @@
+#ifndef PHYS_JOINT_H
+#define PHYS_JOINT_H
+
+#include <phys_platform.h>
+#include <phys_body.h>
+
+#include <cstdint>
+
+namespace physic
+{
+	using JointId = uint32_t;
+
+	// Constraint keeping distance between centers of two bodies
+	struct JointDef
+	{
+		enum class Type
+		{
+			// Distance is kept exactly
+			Distance,
+			// Distance is pulled back to length with stiffness and damping
+			Spring,
+			// Distance never exceeds length, shorter is allowed
+			Rope
+		};
+
+		Type type;
+		BodyPtr first;
+		BodyPtr second;
+		Scalar length;
+		// Used by springs only, stiffness must be positive
+		Scalar stiffness;
+		Scalar damping;
+	};
+} // namespace physic
+
+#endif // PHYS_JOINT_H
@@ -0,0 +1,338 @@
+#ifndef PHYS_LINEAR_QUADTREE_H
+#define PHYS_LINEAR_QUADTREE_H
+
+#include <phys_body.h>
+#include <phys_morton.h>
+#include <phys_quadtree.h>
+#include <phys_utils.h>
+#include <phys_workers.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace physic
+{
+	// Quadtree without node objects. Entries are sorted by Morton code of position, so every node
+	// is a range of entries sharing code prefix. Split points of nodes are found in one pass over
+	// adjacent codes and nodes are kept in a flat array. Same interface as QuadTree, but entries are indexed by build(), which
+	// must be called after insertions and before queries.
+	template <class T>
+	class LinearQuadTree
+	{
+		static_assert(std::is_base_of<BodyPtr, T>::value,
+			"Template parameter should be std::shared_ptr<IBody>");
+
+	public:
+		using Entry = typename QuadTree<T>::Entry;
+
+		// Node stops splitting at this number of entries
+		static const size_t kMaxObjects = QuadTree<T>::kMaxObjects;
+
+		// Fewer entries per thread are sorted faster by one thread
+		static const size_t kMinEntriesPerThread = 32768;
+
+		// Big builds are split between threads of workers, if any. Workers are shared
+		// by trees of all chunks, so trees using them must not be built concurrently.
+		LinearQuadTree(int level, Point bot_left, Point top_right, Workers* workers = nullptr)
+			: m_botLeft(bot_left)
+			, m_topRight(top_right)
+			, m_maxRadius(0)
+			, m_workers(workers)
+		{
+			(void)level;
+		}
+
+		bool insert(const T& body)
+		{
+			assert(body != nullptr);
+
+			const Entry entry = { body, body->GetPosition(), body->GetRadius(), body->GetCollisionFilter() };
+			if (!IsPointInRect(entry.position, m_botLeft, m_topRight))
+				return false;
+
+			m_maxRadius = std::max(m_maxRadius, entry.radius);
+			m_entries.push_back(entry);
+			return true;
+		}
+
+		// Sort entries and derive nodes from them
+		void build()
+		{
+			const size_t count = m_entries.size();
+			m_nodes.clear();
+			if (0 == count)
+				return;
+
+			sortEntries();
+			buildNodes();
+		}
+
+		// Same contract as QuadTree::traverse
+		template <class Accept, class Visit>
+		bool traverse(Accept& accept, Visit& visit) const
+		{
+			if (m_nodes.empty())
+				return true;
+
+			return traverseNode(m_nodes.front(), accept, visit);
+		}
+
+		Scalar maxRadius() const
+		{
+			return m_maxRadius;
+		}
+
+		// Buffers are kept to be reused on next fill
+		void clear()
+		{
+			m_entries.clear();
+			m_nodes.clear();
+			m_maxRadius = 0;
+		}
+
+	private:
+		struct Node
+		{
+			Point bot_left;
+			Point top_right;
+			// Biggest radius of entries of the node
+			Scalar max_radius;
+			// Range of entries
+			uint32_t first;
+			uint32_t last;
+			// Index of the first of four children in Morton order, zero for leaf
+			uint32_t children;
+		};
+
+		template <class Accept, class Visit>
+		bool traverseNode(const Node& node, Accept& accept, Visit& visit) const
+		{
+			const Point bot_left{ node.bot_left.x - node.max_radius, node.bot_left.y - node.max_radius };
+			const Point top_right{ node.top_right.x + node.max_radius, node.top_right.y + node.max_radius };
+			if (!accept(bot_left, top_right))
+				return true;
+
+			if (0 == node.children)
+			{
+				for (uint32_t i = node.first; i < node.last; ++i)
+					if (!visit(m_entries[i]))
+						return false;
+				return true;
+			}
+
+			for (uint32_t child = 0; child < 4; ++child)
+			{
+				const Node& child_node = m_nodes[node.children + child];
+				if (child_node.first != child_node.last && !traverseNode(child_node, accept, visit))
+					return false;
+			}
+
+			return true;
+		}
+
+		// Nodes level by level from root, children of node are next to each other. Adjacent codes
+		// first differing at digit of level split node of that level, so split points of all nodes
+		// come from one pass over codes and each node takes its own ones in order.
+		void buildNodes()
+		{
+			const size_t count = m_entries.size();
+
+			// Level of split before every entry, entries of same code split no node
+			m_splitLevels.resize(count);
+			parallel(count, [this](size_t, size_t begin, size_t end)
+			{
+				for (size_t i = std::max<size_t>(begin, 1); i < end; ++i)
+					m_splitLevels[i] = static_cast<uint8_t>(GetMortonCommonDigits(m_codes[i - 1], m_codes[i]));
+			});
+
+			// Split points grouped by level, ascending within level
+			std::array<uint32_t, kMortonBits + 1> level_starts{};
+			for (size_t i = 1; i < count; ++i)
+				if (m_splitLevels[i] < kMortonBits)
+					++level_starts[m_splitLevels[i] + 1];
+			for (int level = 1; level <= kMortonBits; ++level)
+				level_starts[level] += level_starts[level - 1];
+
+			std::array<uint32_t, kMortonBits + 1> cursors = level_starts;
+			m_splits.resize(level_starts[kMortonBits]);
+			for (uint32_t i = 1; i < count; ++i)
+				if (m_splitLevels[i] < kMortonBits)
+					m_splits[cursors[m_splitLevels[i]]++] = i;
+
+			m_nodes.push_back({ m_botLeft, m_topRight, 0, 0, static_cast<uint32_t>(count), 0 });
+			size_t level_begin = 0;
+			for (int level = 0; level < kMortonBits && level_begin < m_nodes.size(); ++level)
+			{
+				const size_t level_end = m_nodes.size();
+				const int shift = 2 * (kMortonBits - 1 - level);
+				uint32_t split = level_starts[level];
+				const uint32_t splits_end = level_starts[level + 1];
+
+				for (size_t index = level_begin; index < level_end; ++index)
+				{
+					// Copy, children are appended to the same array
+					const Node node = m_nodes[index];
+					if (node.last - node.first <= kMaxObjects)
+						continue;
+
+					m_nodes[index].children = static_cast<uint32_t>(m_nodes.size());
+
+					// Split points of leaves before this node
+					while (split < splits_end && m_splits[split] <= node.first)
+						++split;
+
+					const Point::type mid_x = node.bot_left.x + (node.top_right.x - node.bot_left.x) / 2;
+					const Point::type mid_y = node.bot_left.y + (node.top_right.y - node.bot_left.y) / 2;
+
+					uint32_t begin = node.first;
+					for (uint32_t digit = 0; digit < 4; ++digit)
+					{
+						// Child is empty unless its digit is the next one, then it runs to next split point
+						uint32_t end = begin;
+						if (begin < node.last && ((m_codes[begin] >> shift) & 3) == digit)
+							end = split < splits_end && m_splits[split] < node.last ? m_splits[split++] : node.last;
+
+						// Lower bit of digit is x, higher one is y
+						const Point child_bot_left{ (digit & 1) ? mid_x : node.bot_left.x, (digit & 2) ? mid_y : node.bot_left.y };
+						const Point child_top_right{ (digit & 1) ? node.top_right.x : mid_x, (digit & 2) ? node.top_right.y : mid_y };
+						m_nodes.push_back({ child_bot_left, child_top_right, 0, begin, end, 0 });
+
+						begin = end;
+					}
+				}
+
+				level_begin = level_end;
+			}
+
+			// Children follow their parents, so radii go up from the back. Leaves cover each entry once.
+			for (size_t index = m_nodes.size(); index-- > 0;)
+			{
+				Node& node = m_nodes[index];
+				if (0 == node.children)
+				{
+					for (uint32_t i = node.first; i < node.last; ++i)
+						node.max_radius = std::max(node.max_radius, m_entries[i].radius);
+				}
+				else
+				{
+					for (uint32_t child = 0; child < 4; ++child)
+						node.max_radius = std::max(node.max_radius, m_nodes[node.children + child].max_radius);
+				}
+			}
+		}
+
+		// Threads splitting count entries
+		size_t threadCount(size_t count) const
+		{
+			if (nullptr == m_workers)
+				return 1;
+
+			return std::max<size_t>(1, std::min(m_workers->size(), count / kMinEntriesPerThread));
+		}
+
+		// Run work(thread, begin, end) over equal parts of count entries
+		template <class Work>
+		void parallel(size_t count, const Work& work)
+		{
+			const size_t threads = threadCount(count);
+			if (threads <= 1)
+			{
+				work(0, 0, count);
+				return;
+			}
+
+			const size_t per_thread = (count + threads - 1) / threads;
+			m_workers->run(threads, [&work, count, per_thread](size_t thread)
+			{
+				work(thread, std::min(count, thread * per_thread), std::min(count, (thread + 1) * per_thread));
+			});
+		}
+
+		// Least significant digit radix sort of codes, threads count and scatter their own parts
+		void sortEntries()
+		{
+			const size_t count = m_entries.size();
+
+			// Code in high bits, index of entry in low ones
+			m_keys.resize(count);
+			m_sortedKeys.resize(count);
+			parallel(count, [this](size_t, size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+					m_keys[i] = (static_cast<uint64_t>(GetMortonCode(m_entries[i].position, m_botLeft, m_topRight)) << 32) | i;
+			});
+
+			m_histograms.assign(threadCount(count), Histogram());
+			for (int shift = 32; shift < 64; shift += 8)
+			{
+				parallel(count, [this, shift](size_t t, size_t begin, size_t end)
+				{
+					Histogram& histogram = m_histograms[t];
+					histogram.fill(0);
+					for (size_t i = begin; i < end; ++i)
+						++histogram[(m_keys[i] >> shift) & 0xFF];
+				});
+
+				// Offsets of each thread within each digit, so scatter stays stable
+				uint32_t offset = 0;
+				for (size_t digit = 0; digit < 256; ++digit)
+					for (auto& histogram : m_histograms)
+					{
+						const uint32_t digit_count = histogram[digit];
+						histogram[digit] = offset;
+						offset += digit_count;
+					}
+
+				parallel(count, [this, shift](size_t t, size_t begin, size_t end)
+				{
+					Histogram& histogram = m_histograms[t];
+					for (size_t i = begin; i < end; ++i)
+						m_sortedKeys[histogram[(m_keys[i] >> shift) & 0xFF]++] = m_keys[i];
+				});
+
+				m_keys.swap(m_sortedKeys);
+			}
+
+			// Entries follow their codes
+			m_sortedEntries.resize(count);
+			m_codes.resize(count);
+			parallel(count, [this](size_t, size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					m_sortedEntries[i] = std::move(m_entries[static_cast<uint32_t>(m_keys[i])]);
+					m_codes[i] = static_cast<uint32_t>(m_keys[i] >> 32);
+				}
+			});
+			m_entries.swap(m_sortedEntries);
+			m_sortedEntries.clear();
+		}
+
+		using Histogram = std::array<uint32_t, 256>;
+
+		Point m_botLeft;
+		Point m_topRight;
+		Scalar m_maxRadius;
+		Workers* m_workers;
+
+		// Sorted by code after build
+		std::vector<Entry> m_entries;
+		std::vector<uint32_t> m_codes;
+		// Root first, children of each node are next to each other
+		std::vector<Node> m_nodes;
+
+		// Scratch buffers of sorting
+		std::vector<uint64_t> m_keys;
+		std::vector<uint64_t> m_sortedKeys;
+		std::vector<Entry> m_sortedEntries;
+		std::vector<Histogram> m_histograms;
+
+		// Scratch buffers of node derivation
+		std::vector<uint8_t> m_splitLevels;
+		std::vector<uint32_t> m_splits;
+	};
+} // namespace physic
+
+#endif // PHYS_LINEAR_QUADTREE_H
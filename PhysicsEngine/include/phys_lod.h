@@ -0,0 +1,20 @@
+#ifndef PHYS_LOD_H
+#define PHYS_LOD_H
+
+#include <phys_platform.h>
+#include <phys_utils.h>
+
+#include <cstdint>
+
+namespace physic
+{
+	// Dynamic bodies at least distance away from every focus point are stepped
+	// once in interval steps with dt of all skipped steps
+	struct LodTier
+	{
+		Scalar distance;
+		uint32_t interval;
+	};
+} // namespace physic
+
+#endif // PHYS_LOD_H
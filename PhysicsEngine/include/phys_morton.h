@@ -0,0 +1,67 @@
+#ifndef PHYS_MORTON_H
+#define PHYS_MORTON_H
+
+#include <phys_utils.h>
+
+#include <cstdint>
+
+namespace physic
+{
+	// Bits per axis of Morton code, the area is split into 2^bits by 2^bits cells
+	const int kMortonBits = 16;
+
+	// Move lower 16 bits of value to even bits
+	inline uint32_t SpreadMortonBits(uint32_t value)
+	{
+		value &= 0x0000FFFF;
+		value = (value | (value << 8)) & 0x00FF00FF;
+		value = (value | (value << 4)) & 0x0F0F0F0F;
+		value = (value | (value << 2)) & 0x33333333;
+		value = (value | (value << 1)) & 0x55555555;
+		return value;
+	}
+
+	inline uint32_t GetMortonCode(uint32_t x, uint32_t y)
+	{
+		return SpreadMortonBits(x) | (SpreadMortonBits(y) << 1);
+	}
+
+	// Number of leading base 4 digits two codes share, i.e. depth of the deepest quadtree node
+	// holding both cells. Equal codes share all kMortonBits digits.
+	inline int GetMortonCommonDigits(uint32_t l, uint32_t r)
+	{
+		uint32_t diff = l ^ r;
+		if (0 == diff)
+			return kMortonBits;
+
+		// Leading zero bits of difference by halving, two bits per digit
+		int digits = 0;
+		for (int bits = 16; bits >= 2; bits /= 2)
+		{
+			if (0 == (diff >> (32 - bits)))
+			{
+				digits += bits / 2;
+				diff <<= bits;
+			}
+		}
+		return digits;
+	}
+
+	// Z-order of cell containing position, positions outside of area go to its border cells.
+	// Close positions mostly get close codes.
+	inline uint32_t GetMortonCode(const Point& pos, const Point& bot_left, const Point& top_right)
+	{
+		const double cells = static_cast<double>(1u << kMortonBits);
+		auto quantize = [cells](double value, double low, double high)
+		{
+			const double cell = high > low ? (value - low) / (high - low) * cells : 0.;
+			return static_cast<uint32_t>(Clip(cell, 0., cells - 1.));
+		};
+
+		return GetMortonCode(
+			quantize(static_cast<double>(pos.x), static_cast<double>(bot_left.x), static_cast<double>(top_right.x)),
+			quantize(static_cast<double>(pos.y), static_cast<double>(bot_left.y), static_cast<double>(top_right.y)));
+	}
+} // namespace physic
+
+#endif // PHYS_MORTON_H
@@ -0,0 +1,51 @@
+#ifndef PHYS_PARTICLES_H
+#define PHYS_PARTICLES_H
+
+#include <phys_platform.h>
+#include <phys_utils.h>
+
+#include <memory>
+
+namespace physic
+{
+	class IParticleSystem;
+	using ParticleSystemPtr = std::shared_ptr<IParticleSystem>;
+
+	// Live particles stored by component, valid until next step or emission
+	struct ParticleData
+	{
+		const Scalar* x;
+		const Scalar* y;
+		const Scalar* velocity_x;
+		const Scalar* velocity_y;
+		// Seconds left to live
+		const Scalar* lifetime;
+		size_t count;
+	};
+
+	// Massless points for debris, sparks and the like. They are moved by gravity and drag,
+	// bounce off world borders and static bodies, and never touch dynamic bodies or each other.
+	// Systems are created only by Create, engine relies on its implementation.
+	class PHYS_API IParticleSystem
+	{
+	public:
+		// Returns false if there is no room left
+		virtual bool Emit(const Point& position, const fVec2D& velocity, Scalar lifetime) = 0;
+
+		virtual ParticleData GetParticles() const = 0;
+		virtual size_t GetCapacity() const = 0;
+		virtual Scalar GetRadius() const = 0;
+		virtual Scalar GetBounceFactor() const = 0;
+		virtual bool CollidesWithStatics() const = 0;
+
+		static ParticleSystemPtr Create(size_t capacity, Scalar radius, Scalar bounce_factor, bool collide_with_statics);
+
+		virtual ~IParticleSystem() = default;
+
+	private:
+		friend class ParticleSystem;
+		IParticleSystem() = default;
+	};
+} // namespace physic
+
+#endif // PHYS_PARTICLES_H
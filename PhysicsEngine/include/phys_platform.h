@@ -1,6 +1,8 @@
 #ifndef PHYS_PLATFORM_H
 #define PHYS_PLATFORM_H
 
+#include <phys_config.h>
+
 #ifdef PHYSICSENGINE_EXPORTS
 	#define PHYS_API __declspec(dllexport)
 #else
@@ -9,15 +11,11 @@
 
 #ifdef _MSC_VER
 
-// Implementation is intentionally forbidding macroized keywords
-#define _ALLOW_KEYWORD_MACROS 
-// No MSVC does constexpr fully yet
-#pragma push_macro("constexpr")
-#define constexpr 
-
 // MSVC 2013 workarounds
 #if _MSC_VER <= 1800
 
+// Implementation is intentionally forbidding macroized keywords
+#define _ALLOW_KEYWORD_MACROS 
 #pragma push_macro("noexcept")
 #define noexcept  
 
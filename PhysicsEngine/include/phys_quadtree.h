@@ -1,6 +1,7 @@
 #ifndef PHYS_QUADTREE_H
 #define PHYS_QUADTREE_H
 
+#include <phys_body.h>
 #include <phys_utils.h>
 #include <vector>
 
@@ -13,88 +14,122 @@ namespace physic
 			"Template parameter should be std::shared_ptr<IBody>");
 
 	public:
-		const size_t kMaxObjects = 8;
+		// Object is stored with its position, radius and filter at the moment of insertion,
+		// so broad phase and queries don't have to go through body interface
+		struct Entry
+		{
+			T object;
+			Point position;
+			Scalar radius;
+			CollisionFilter filter;
+		};
+
+		static const size_t kMaxObjects = 8;
 		QuadTree(int level, Point bot_left, Point top_right)
 			: m_level(level)
 			, m_botLeft(bot_left)
 			, m_topRight(top_right)
+			, m_maxRadius(0)
 		{
 		}
 
-		std::vector<T> locate(const T& body) const
+		bool insert(const T& body)
 		{
 			assert(body != nullptr);
 
-			Point pos = body->GetPosition();
-			std::vector<T> res {};
+			const Entry entry = { body, body->GetPosition(), body->GetRadius(), body->GetCollisionFilter() };
+			return insert(entry);
+		}
 
-			if (!IsPointInRect(pos, m_botLeft, m_topRight))
-				return res;
+		// Walk the tree. accept(bot_left, top_right) gets node bounds grown by radius of
+		// its biggest object and returns false to skip the node. visit(entry) returns false to stop.
+		template <class Accept, class Visit>
+		bool traverse(Accept& accept, Visit& visit) const
+		{
+			if (m_objects.empty())
+				return true;
+
+			const Point bot_left{ m_botLeft.x - m_maxRadius, m_botLeft.y - m_maxRadius };
+			const Point top_right{ m_topRight.x + m_maxRadius, m_topRight.y + m_maxRadius };
+			if (!accept(bot_left, top_right))
+				return true;
 
-			if (!m_objects.empty() && m_objects.size() > 1)
-				return std::move(std::vector<T>(m_objects));
+			for (const auto& entry : m_objects)
+				if (!visit(entry))
+					return false;
 
-			if (!m_nodes.empty())
-				for (const auto& node : m_nodes)
-				{
-					std::vector<T>& tmp = node.locate(body);
-					if (!tmp.empty())
-						return std::move(std::vector<T>(tmp));
-				}
+			for (const auto& node : m_nodes)
+				if (!node.traverse(accept, visit))
+					return false;
 
-			return res;
+			return true;
 		}
 
-		bool insert(const T& body)
+		// Objects are indexed on insertion, nothing is left to do before queries
+		void build()
 		{
-			assert(body != nullptr);
+		}
+
+		// Biggest radius of objects in the tree
+		Scalar maxRadius() const
+		{
+			return m_maxRadius;
+		}
+
+		// Subdivisions are kept to be reused on next fill
+		void clear()
+		{
+			m_objects.clear();
+			m_maxRadius = 0;
+
+			for (auto& node : m_nodes)
+				node.clear();
+		}
 
-			Point pos = body->GetPosition();
-			if (!IsPointInRect(pos, m_botLeft, m_topRight))
+	private:
+		bool insert(const Entry& entry)
+		{
+			if (!IsPointInRect(entry.position, m_botLeft, m_topRight))
 				return false;
 
+			m_maxRadius = std::max(m_maxRadius, entry.radius);
+
 			if (m_objects.size() < kMaxObjects)
 			{
-				m_objects.push_back(body);
+				m_objects.push_back(entry);
 				return true;
 			}
 
 			if (m_nodes.empty())
 			{
-				const int m_x = m_botLeft.x;
-				const int m_y = m_botLeft.y;
-				const int m_right = m_topRight.x;
-				const int m_top = m_topRight.y;
-				const int mid_x = m_botLeft.x + (m_topRight.x - m_botLeft.x) / 2;
-				const int mid_y = m_botLeft.y + (m_topRight.y - m_botLeft.y) / 2;
-
-				m_nodes.push_back(QuadTree(m_level + 1, m_botLeft, Point(mid_x, mid_y)));
-				m_nodes.push_back(QuadTree(m_level + 1, Point(m_x, mid_y), Point(mid_x, m_top)));
-				m_nodes.push_back(QuadTree(m_level + 1, Point(mid_x, m_y), Point(m_right, mid_y)));
-				m_nodes.push_back(QuadTree(m_level + 1, Point(mid_x, mid_y), m_topRight));
+				const Point::type m_x = m_botLeft.x;
+				const Point::type m_y = m_botLeft.y;
+				const Point::type m_right = m_topRight.x;
+				const Point::type m_top = m_topRight.y;
+				const Point::type mid_x = m_botLeft.x + (m_topRight.x - m_botLeft.x) / 2;
+				const Point::type mid_y = m_botLeft.y + (m_topRight.y - m_botLeft.y) / 2;
+
+				m_nodes.push_back(QuadTree(m_level + 1, m_botLeft, Point{ mid_x, mid_y }));
+				m_nodes.push_back(QuadTree(m_level + 1, Point{ m_x, mid_y }, Point{ mid_x, m_top }));
+				m_nodes.push_back(QuadTree(m_level + 1, Point{ mid_x, m_y }, Point{ m_right, mid_y }));
+				m_nodes.push_back(QuadTree(m_level + 1, Point{ mid_x, mid_y }, m_topRight));
 			}
 
 			for (auto& node : m_nodes)
-				if (node.insert(body))
+				if (node.insert(entry))
 					return true;
 
 			return false;
 		}
 
-		void clear()
-		{
-			m_objects.clear();
-
-			for (auto node : m_nodes)
-				node.clear();
-		}
-
-	private:
 		int m_level;
 		Point m_botLeft;
 		Point m_topRight;
 
-		std::vector<T> m_objects;
+		// Biggest radius of objects in this node and all subnodes
+		Scalar m_maxRadius;
+
+		std::vector<Entry> m_objects;
 		std::vector<QuadTree> m_nodes;
 	};
 } // namespace physic
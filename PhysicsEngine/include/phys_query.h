@@ -0,0 +1,53 @@
+#ifndef PHYS_QUERY_H
+#define PHYS_QUERY_H
+
+#include <phys_platform.h>
+#include <phys_body.h>
+
+namespace physic
+{
+	struct RaycastRequest
+	{
+		Point from;
+		Point to;
+	};
+
+	struct RaycastHit
+	{
+		// nullptr if nothing was hit
+		BodyPtr body;
+		Point point;
+		fVec2D normal;
+		// Position of hit along the ray, 0 at from and 1 at to
+		Scalar fraction;
+	};
+
+	struct NearestHit
+	{
+		BodyPtr body;
+		Scalar distance;
+	};
+
+	// Callbacks are called from inside of query, no results are stored by engine
+	class PHYS_API IQueryCallback
+	{
+	public:
+		// Return false to stop the query
+		virtual bool OnBody(const BodyPtr&) = 0;
+
+	protected:
+		~IQueryCallback() = default;
+	};
+
+	class PHYS_API IRaycastCallback
+	{
+	public:
+		// Hits are reported in no particular order. Return false to stop the query.
+		virtual bool OnHit(const RaycastHit&) = 0;
+
+	protected:
+		~IRaycastCallback() = default;
+	};
+} // namespace physic
+
+#endif // PHYS_QUERY_H
\ No newline at end of file
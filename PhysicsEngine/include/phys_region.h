@@ -0,0 +1,61 @@
+#ifndef PHYS_REGION_H
+#define PHYS_REGION_H
+
+#include <phys_platform.h>
+#include <phys_engine.h>
+#include <phys_transport.h>
+
+#include <memory>
+#include <vector>
+
+namespace physic
+{
+	// World rectangle split into columns x rows equal regions, index of region is row * columns + column.
+	// Positions outside of rectangle belong to the closest edge region.
+	struct RegionGrid
+	{
+		Point bot_left;
+		Point top_right;
+		int columns;
+		int rows;
+
+		// Owned bodies closer than this to a neighbour region are mirrored there as ghosts.
+		// Should be at least twice the biggest radius, so both nodes see every pair touching across border.
+		Scalar ghost_margin;
+	};
+
+	class IRegionNode;
+	using RegionNodePtr = std::shared_ptr<IRegionNode>;
+
+	// Simulates one region of distributed world with its own engine. Dynamic and kinematic bodies
+	// are owned by node of region they are in and handed off when they cross region border.
+	// Bodies near the border are mirrored to neighbours as ghosts with the same mass. Pair touching
+	// across the border is solved by both nodes from the same states, each node keeps only the impulse
+	// of its own body and the ghost is overwritten by its owner after the step, so momentum is conserved.
+	// Static bodies are never exchanged, every node adds the ones it needs.
+	// Nodes of different processes should use separate IBody::SetIdRange.
+	class PHYS_API IRegionNode
+	{
+	public:
+		virtual int GetRegion() const = 0;
+
+		// Body out of own region is handed off on next step
+		virtual void AddBody(BodyPtr&) = 0;
+		virtual void RemoveBody(const BodyPtr&) = 0;
+
+		// Bodies owned by this node, handed off ones are gone after step and received ones are new objects
+		virtual const std::vector<BodyPtr>& GetOwnedBodies() const = 0;
+
+		// Step engine and exchange handoffs and ghosts with neighbour regions.
+		// Blocks until all neighbours finish the same step. Returns false if transport failed.
+		virtual bool Step(double dt) = 0;
+
+		// Transport peer index is region index
+		static RegionNodePtr Create(IEngine& engine, const TransportPtr& transport, const RegionGrid& grid);
+
+		IRegionNode() = default;
+		virtual ~IRegionNode() = default;
+	};
+} // namespace physic
+
+#endif // PHYS_REGION_H
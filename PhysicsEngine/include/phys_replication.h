@@ -0,0 +1,67 @@
+#ifndef PHYS_REPLICATION_H
+#define PHYS_REPLICATION_H
+
+#include <phys_platform.h>
+#include <phys_body.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace physic
+{
+	class IEngine;
+
+	// Positions and velocities are sent as integer multiples of precision,
+	// encoder and decoder should use the same config
+	struct ReplicationConfig
+	{
+		Scalar position_precision;
+		Scalar velocity_precision;
+	};
+
+	const ReplicationConfig kDefaultReplicationConfig = { Scalar(1) / Scalar(64), Scalar(1) / Scalar(64) };
+
+	class IReplicationEncoder;
+	using ReplicationEncoderPtr = std::shared_ptr<IReplicationEncoder>;
+
+	// Server side of replication, one per client. Every packet holds only bodies changed
+	// since the last snapshot acknowledged by client, or all of them if there is none.
+	class PHYS_API IReplicationEncoder
+	{
+	public:
+		// Append packet with delta of states, e.g. got from IEngine::GetBodyStates, to packet.
+		// Returns sequence of the packet.
+		virtual uint32_t Encode(const BodyState* states, size_t count, std::vector<uint8_t>& packet) = 0;
+
+		// Client reported decoded packet, its snapshot becomes baseline of next packets
+		virtual void Acknowledge(uint32_t sequence) = 0;
+
+		static ReplicationEncoderPtr Create(const ReplicationConfig& config = kDefaultReplicationConfig);
+
+		IReplicationEncoder() = default;
+		virtual ~IReplicationEncoder() = default;
+	};
+
+	class IReplicationDecoder;
+	using ReplicationDecoderPtr = std::shared_ptr<IReplicationDecoder>;
+
+	// Client side of replication, keeps bodies of mirror engine in sync with server. Mirror may be
+	// stepped between packets, e.g. to predict motion, every decoded packet resets positions and
+	// velocities of its bodies to the server ones.
+	class PHYS_API IReplicationDecoder
+	{
+	public:
+		// Apply packet to mirror. On success sequence should be sent back to encoder as acknowledgement.
+		// Returns false for malformed packets, packets of encoder built with other Scalar type,
+		// packets older than the last decoded one and packets based on snapshot which is not kept anymore.
+		virtual bool Decode(const uint8_t* data, size_t size, IEngine& mirror, uint32_t& sequence) = 0;
+
+		static ReplicationDecoderPtr Create(const ReplicationConfig& config = kDefaultReplicationConfig);
+
+		IReplicationDecoder() = default;
+		virtual ~IReplicationDecoder() = default;
+	};
+} // namespace physic
+
+#endif // PHYS_REPLICATION_H
@@ -0,0 +1,27 @@
+#ifndef PHYS_STATS_H
+#define PHYS_STATS_H
+
+#include <phys_platform.h>
+#include <phys_utils.h>
+
+#include <cstddef>
+
+namespace physic
+{
+	// What last call of Step did
+	struct StepStats
+	{
+		// Time simulated by the call and its split into substeps
+		double dt;
+		size_t substeps;
+		double min_substep;
+		double max_substep;
+
+		// Fastest body relative to its radius, in radii per second
+		Scalar max_speed;
+		// Deepest overlap of touching bodies relative to the smaller radius
+		Scalar max_penetration;
+	};
+} // namespace physic
+
+#endif // PHYS_STATS_H
@@ -0,0 +1,37 @@
+#ifndef PHYS_STREAMING_H
+#define PHYS_STREAMING_H
+
+#include <phys_platform.h>
+#include <phys_body.h>
+
+#include <string>
+
+namespace physic
+{
+	// Area of world around player, camera, etc. Chunks overlapping any region are simulated.
+	struct ActivityRegion
+	{
+		Point bot_left;
+		Point top_right;
+	};
+
+	class PHYS_API IChunkListener
+	{
+	public:
+		// Bodies of chunk were written to streaming directory and released by engine.
+		// Pointers held by caller stay valid but the bodies are not simulated anymore.
+		virtual void OnBodiesUnloaded(const BodyPtr* bodies, size_t count) = 0;
+
+		// Bodies of chunk were read back as new objects with the same ids
+		virtual void OnBodiesLoaded(const BodyPtr* bodies, size_t count) = 0;
+
+		// File of chunk ended with a truncated record. Bodies before it were loaded as usual,
+		// the rest is lost and the file was renamed to path + ".bad" to be looked at later.
+		virtual void OnChunkDamaged(const std::string& /*path*/) {}
+
+	protected:
+		~IChunkListener() = default;
+	};
+} // namespace physic
+
+#endif // PHYS_STREAMING_H
@@ -0,0 +1,16 @@
+#ifndef PHYS_TERRAIN_H
+#define PHYS_TERRAIN_H
+
+#include <phys_platform.h>
+#include <phys_utils.h>
+
+#include <cstdint>
+
+namespace physic
+{
+	// Static world geometry apart from bodies: segment chains and heightfields.
+	// It is indexed once when added, so it costs nothing until something touches it.
+	using TerrainId = uint32_t;
+} // namespace physic
+
+#endif // PHYS_TERRAIN_H
@@ -0,0 +1,42 @@
+#ifndef PHYS_TRANSPORT_H
+#define PHYS_TRANSPORT_H
+
+#include <phys_platform.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace physic
+{
+	class ITransport;
+	using TransportPtr = std::shared_ptr<ITransport>;
+
+	// Message channel between engine nodes, nodes are addressed by index.
+	// Messages from one peer are received in order they were sent.
+	class PHYS_API ITransport
+	{
+	public:
+		virtual int GetSelf() const = 0;
+		virtual int GetPeerCount() const = 0;
+
+		// Returns false if peer is not reachable anymore
+		virtual bool Send(int peer, const void* data, size_t size) = 0;
+
+		// Blocks until message from any peer arrives. Returns false if transport is closed.
+		virtual bool Receive(int& peer, std::vector<uint8_t>& message) = 0;
+
+		// Connected transports of count nodes living in one process, e.g. for tests
+		static std::vector<TransportPtr> CreateLocal(int count);
+
+		// Node self of nodes connected by TCP, node i listens on addresses[i] given as "host:port".
+		// Blocks until all nodes are connected, returns nullptr on failure.
+		static TransportPtr CreateSocket(const std::vector<std::string>& addresses, int self);
+
+		ITransport() = default;
+		virtual ~ITransport() = default;
+	};
+} // namespace physic
+
+#endif // PHYS_TRANSPORT_H
@@ -2,19 +2,41 @@
 #define PHYS_UTILS_H
 
 #include <phys_platform.h>
-//#include <phys_constants.h>
+#include <phys_fixed.h>
 
 #include <cmath>
-#include <tuple>
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
 #include <stdexcept>
 #include <cassert>
 #include <vector>
 
 namespace physic
 {
+	enum class ScalarKind : uint8_t
+	{
+		Float,
+		Double,
+		Fixed
+	};
+
+	// Scalar type of the whole engine is chosen in phys_config.h
+#if defined(PHYS_SCALAR_DOUBLE)
+	using Scalar = double;
+	const ScalarKind kScalarKind = ScalarKind::Double;
+#elif defined(PHYS_SCALAR_FIXED)
+	using Scalar = Fixed;
+	const ScalarKind kScalarKind = ScalarKind::Fixed;
+#else
+	using Scalar = float;
+	const ScalarKind kScalarKind = ScalarKind::Float;
+#endif
+
+	const double kPi = 3.141592;
 
 	template <typename T>
-	T Clip(const T& n, const T& lower, const T& upper) {
+	constexpr T Clip(const T& n, const T& lower, const T& upper) {
 		return std::max(lower, std::min(n, upper));
 	}
 
@@ -22,55 +44,34 @@ namespace physic
 	class PHYS_API Angle
 	{
 	public:
-		Angle(T angle) : m_angle(angle) {}
-		~Angle() = default;
-		T inRad() const { return static_cast<T>(m_angle * kPi / 180.f); }
-		T inDeg() const { return m_angle; }
+		constexpr Angle(T angle) : m_angle(angle) {}
+		constexpr T inRad() const { return static_cast<T>(m_angle * T(kPi) / T(180)); }
+		constexpr T inDeg() const { return m_angle; }
 
 	private:
 		T m_angle;
 	};
 
 	// Useful aliases
-	using fAngle = Angle<float>;
+	using fAngle = Angle<Scalar>;
 
+	// Aggregate without user-declared constructors, so vectors stay trivially copyable,
+	// are passed and copied as plain data and are built with braces: fVec2D{ x, y }
 	template <typename T>
 	class PHYS_API Vec2D
 	{
 	public:
-		T x;
-		T y;
-
-		Vec2D(T vx = 0, T vy = 0) : x(vx), y(vy) {}
-
-		template <typename U>
-		Vec2D(T length, Angle<U> angle)
-			: x(static_cast<T>(length * std::cos(angle.inRad())))
-			, y(static_cast<T>(length * std::sin(angle.inRad())))
-		{}
-
-		//template <typename U>
-		//Vec2D(U length, U angle)
-		//	: x(static_cast<T>(length * std::cos(angle.inRad())))
-		//	, y(static_cast<T>(length * std::sin(angle.inRad())))
-		//{}
-
-		~Vec2D() = default;
-
-		Vec2D(const Vec2D& v) : x(v.x), y(v.y) {}
-		Vec2D& operator=(const Vec2D& v) { x = v.x; y = v.y; return *this; }
-
-		Vec2D(Vec2D&& v) : x(std::move(v.x)), y(std::move(v.y)) {}
-		Vec2D& operator=(Vec2D&& v) { x = std::move(v.x); y = std::move(v.y); return *this; }
+		T x = 0;
+		T y = 0;
 
 		// Unary arithmetic operators
-		Vec2D& operator+=(const Vec2D& v) { x += v.x; y += v.y; return *this; }
-		Vec2D& operator-=(const Vec2D& v) { x -= v.x; y -= v.y; return *this; }
-		Vec2D operator-() const { return Vec2D<T>(-x, -y); }
+		constexpr Vec2D& operator+=(const Vec2D& v) { x += v.x; y += v.y; return *this; }
+		constexpr Vec2D& operator-=(const Vec2D& v) { x -= v.x; y -= v.y; return *this; }
+		constexpr Vec2D operator-() const { return Vec2D<T>{ -x, -y }; }
 
 		// Unary scalar multiplication and division operators
-		template <typename S> Vec2D& operator*=(S s) { x *= static_cast<T>(s); y *= static_cast<T>(s); return *this; }
-		template <typename S> Vec2D& operator/=(S s)
+		template <typename S> constexpr Vec2D& operator*=(S s) { x *= static_cast<T>(s); y *= static_cast<T>(s); return *this; }
+		template <typename S> constexpr Vec2D& operator/=(S s)
 		{
 			assert(0 != s);
 			x /= s; y /= s; return *this;
@@ -80,83 +81,107 @@ namespace physic
 	};
 
 	// Compare operators
-	template<class T> bool operator==(const Vec2D<T>& l, const Vec2D<T>& r) { return std::tie(l.x, l.y) == std::tie(r.x, r.y); }
-	template<class T> bool operator!=(const Vec2D<T>& l, const Vec2D<T>& r) { return !(l == r); }
+	template<class T> constexpr bool operator==(const Vec2D<T>& l, const Vec2D<T>& r) { return l.x == r.x && l.y == r.y; }
+	template<class T> constexpr bool operator!=(const Vec2D<T>& l, const Vec2D<T>& r) { return !(l == r); }
 
 	// Binary arithmetic operators 
-	template<class T> Vec2D<T> operator+(const Vec2D<T>& l, const Vec2D<T>& r) { return Vec2D<T>(l) += r; }
-	template<class T> Vec2D<T> operator-(const Vec2D<T>& l, const Vec2D<T>& r) { return Vec2D<T>(l) -= r; }
+	// Results are built in place: returning the reference from a compound operator
+	// copies the temporary once more and keeps the compiler from vectorizing loops
+	template<class T> constexpr Vec2D<T> operator+(const Vec2D<T>& l, const Vec2D<T>& r) { return Vec2D<T>{ l.x + r.x, l.y + r.y }; }
+	template<class T> constexpr Vec2D<T> operator-(const Vec2D<T>& l, const Vec2D<T>& r) { return Vec2D<T>{ l.x - r.x, l.y - r.y }; }
 
 	// Binary scalar multiplication and division operators
-	template<class T, typename S> Vec2D<T> operator*(const S& s, const Vec2D<T>& v) { return Vec2D<T>(v) *= s; }
-	template<class T, typename S> Vec2D<T> operator*(const Vec2D<T>& v, const S& s) { return Vec2D<T>(v) *= s; }
-	template<class T, typename S> Vec2D<T> operator/(const S& s, const Vec2D<T>& v) { return Vec2D<T>(v) /= s; }
-	template<class T, typename S> Vec2D<T> operator/(const Vec2D<T>& v, const S& s) { return Vec2D<T>(v) /= s; }
+	template<class T, typename S> constexpr Vec2D<T> operator*(const S& s, const Vec2D<T>& v) { return Vec2D<T>{ v.x * static_cast<T>(s), v.y * static_cast<T>(s) }; }
+	template<class T, typename S> constexpr Vec2D<T> operator*(const Vec2D<T>& v, const S& s) { return Vec2D<T>{ v.x * static_cast<T>(s), v.y * static_cast<T>(s) }; }
+	template<class T, typename S> constexpr Vec2D<T> operator/(const S& s, const Vec2D<T>& v) { Vec2D<T> r = v; r /= s; return r; }
+	template<class T, typename S> constexpr Vec2D<T> operator/(const Vec2D<T>& v, const S& s) { Vec2D<T> r = v; r /= s; return r; }
+
+	// Bring std math in scope, Fixed overloads are found by argument dependent lookup
+	using std::sqrt;
+	using std::cos;
+	using std::sin;
+	using std::acos;
+	using std::round;
 
 	// Get length of vector
-	template<class T> T EuclideanNorm(const Vec2D<T>& v) { return std::sqrt(v.x * v.x + v.y * v.y); }
-	template<class T> T DotProduct(const Vec2D<T>& a, const Vec2D<T>& b) { return a.x * b.x + a.y * b.y; }
-	template<class T> T CrossProduct(const Vec2D<T>& a, const Vec2D<T>& b) { return a.x * b.y - a.y * b.x; }
-	template<class T> T GetAngle(const Vec2D<T>& a, const Vec2D<T>& b) { return std::acos(DotProduct(a, b) / (EuclideanNorm(a) * EuclideanNorm(b))) * 180.f / kPi; }
-	template<class T> Vec2D<T> Normalized(const Vec2D<T>& v) { T norm = EuclideanNorm(v); return norm != 0 ? Vec2D<T>(v) / norm : Vec2D<T>(static_cast<T>(0), static_cast<T>(0)); }
-	template<class T> Vec2D<T> Round(const Vec2D<T>& v) { return Vec2D<T>(std::round(v.x), std::round(v.y)); }
+	template<class T> T EuclideanNorm(const Vec2D<T>& v) { return sqrt(v.x * v.x + v.y * v.y); }
+	template<class T> constexpr T SquaredNorm(const Vec2D<T>& v) { return v.x * v.x + v.y * v.y; }
+	template<class T> constexpr T DotProduct(const Vec2D<T>& a, const Vec2D<T>& b) { return a.x * b.x + a.y * b.y; }
+	template<class T> constexpr T CrossProduct(const Vec2D<T>& a, const Vec2D<T>& b) { return a.x * b.y - a.y * b.x; }
+	template<class T> T GetAngle(const Vec2D<T>& a, const Vec2D<T>& b) { return static_cast<T>(acos(DotProduct(a, b) / (EuclideanNorm(a) * EuclideanNorm(b))) * T(180) / T(kPi)); }
+	template<class T> Vec2D<T> Normalized(const Vec2D<T>& v) { T norm = EuclideanNorm(v); return norm != 0 ? Vec2D<T>(v) / norm : Vec2D<T>{}; }
+	template<class T> Vec2D<T> Round(const Vec2D<T>& v) { return Vec2D<T>{ round(v.x), round(v.y) }; }
+
+	// Vector of length pointing at angle
+	template<class T, class U> Vec2D<T> PolarVector(T length, Angle<U> angle)
+	{
+		return Vec2D<T>{ static_cast<T>(length * T(cos(angle.inRad()))), static_cast<T>(length * T(sin(angle.inRad()))) };
+	}
 
 	// Useful aliases
-	using fVec2D = Vec2D<float>;
+	using fVec2D = Vec2D<Scalar>;
 
+	// Aggregate the same way as Vec2D: Point{ x, y }
 	template <typename T>
 	class PHYS_API Point2D
 	{
 	public:
-		T x;
-		T y;
-
-		Point2D(T vx = 0, T vy = 0) : x(vx), y(vy) {}
-		~Point2D() = default;
-
-		Point2D(const Point2D& v) : x(v.x), y(v.y) {}
-		Point2D& operator=(const Point2D& v) { x = v.x; y = v.y; return *this; }
-
-		Point2D(Point2D&& v) : x(std::move(v.x)), y(std::move(v.y)) {}
-		Point2D& operator=(Point2D&& v) { x = std::move(v.x); y = std::move(v.y); return *this; }
+		T x = 0;
+		T y = 0;
 
 		// Unary arithmetic operators
-		Point2D& operator+=(const Point2D& v) { x += v.x; y += v.y; return *this; }
-		Point2D& operator-=(const Point2D& v) { x -= v.x; y -= v.y; return *this; }
+		constexpr Point2D& operator+=(const Point2D& v) { x += v.x; y += v.y; return *this; }
+		constexpr Point2D& operator-=(const Point2D& v) { x -= v.x; y -= v.y; return *this; }
 		
 		template <typename U>
-		Point2D& operator+=(const Vec2D<U>& v) { x += v.x; y += v.y; return *this; }
+		constexpr Point2D& operator+=(const Vec2D<U>& v) { x += v.x; y += v.y; return *this; }
 		template <typename U>
-		Point2D& operator-=(const Vec2D<U>& v) { x -= v.x; y -= v.y; return *this; }
+		constexpr Point2D& operator-=(const Vec2D<U>& v) { x -= v.x; y -= v.y; return *this; }
 
-		Point2D operator-() const { return Point2D<T>(-x, -y); }
+		constexpr Point2D operator-() const { return Point2D<T>{ -x, -y }; }
 
 		typedef T type;
 	};
 
+	// Compare operators
+	template<class T> constexpr bool operator==(const Point2D<T>& l, const Point2D<T>& r) { return l.x == r.x && l.y == r.y; }
+	template<class T> constexpr bool operator!=(const Point2D<T>& l, const Point2D<T>& r) { return !(l == r); }
+
 	// Binary arithmetic operators 
 	template<typename T> 
-	Vec2D<T> operator+(const Point2D<T>& l, const Point2D<T>& r) { return Vec2D<T>(l.x + r.x, l.y + r.y); }
+	constexpr Vec2D<T> operator+(const Point2D<T>& l, const Point2D<T>& r) { return Vec2D<T>{ l.x + r.x, l.y + r.y }; }
 	template<typename T>
-	Vec2D<T> operator-(const Point2D<T>& l, const Point2D<T>& r) { return Vec2D<T>(l.x - r.x, l.y - r.y); }
+	constexpr Vec2D<T> operator-(const Point2D<T>& l, const Point2D<T>& r) { return Vec2D<T>{ l.x - r.x, l.y - r.y }; }
 
-	template<class T> bool IsPointInRect(const Point2D<T>& p, const Point2D<T>& bot_left, const Point2D<T>& top_right)
+	// Point moved by vector
+	template<typename T>
+	constexpr Point2D<T> operator+(const Point2D<T>& p, const Vec2D<T>& v) { return Point2D<T>{ p.x + v.x, p.y + v.y }; }
+	template<typename T>
+	constexpr Point2D<T> operator-(const Point2D<T>& p, const Vec2D<T>& v) { return Point2D<T>{ p.x - v.x, p.y - v.y }; }
+
+	template<class T> constexpr bool IsPointInRect(const Point2D<T>& p, const Point2D<T>& bot_left, const Point2D<T>& top_right)
 	{
 		return  p.x >= bot_left.x && p.x <= top_right.x &&
 				p.y >= bot_left.y && p.y <= top_right.y;
 	}
 
-	using Point = Point2D<float>;
+	using Point = Point2D<Scalar>;
 
 	class PHYS_API Mass
 	{
 	public:
-		float mass;
-		float inv_mass;
+		Scalar mass;
+		Scalar inv_mass;
 
-		Mass(float m) : mass(m), inv_mass(m ? 1.f / m : 0.f) {}
+		constexpr Mass(Scalar m) : mass(m), inv_mass(m != Scalar(0) ? Scalar(1) / m : Scalar(0)) {}
 	};
 
+	static_assert(std::is_trivially_copyable<fVec2D>::value, "fVec2D must be trivially copyable");
+	static_assert(std::is_trivially_copyable<Point>::value, "Point must be trivially copyable");
+	static_assert(std::is_aggregate<fVec2D>::value, "fVec2D must be aggregate");
+	static_assert(std::is_aggregate<Point>::value, "Point must be aggregate");
+	static_assert(std::is_trivially_copyable<Mass>::value, "Mass must be trivially copyable");
+
 } // namespace physic
 
 #endif // PHYS_UTILS_H
\ No newline at end of file
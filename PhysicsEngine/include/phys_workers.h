@@ -0,0 +1,113 @@
+#ifndef PHYS_WORKERS_H
+#define PHYS_WORKERS_H
+
+#include <cassert>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace physic
+{
+	// Threads kept for the life of owner, so passes don't start threads of their own.
+	// Workers sleep between passes and run work(thread) for threads [1, count) of every pass,
+	// calling thread is thread 0.
+	class Workers
+	{
+	public:
+		explicit Workers(size_t threads)
+			: m_call(nullptr)
+			, m_work(nullptr)
+			, m_count(0)
+			, m_generation(0)
+			, m_running(0)
+			, m_stopping(false)
+		{
+			m_threads.reserve(threads - 1);
+			for (size_t t = 1; t < threads; ++t)
+				m_threads.emplace_back(&Workers::loop, this, t);
+		}
+
+		~Workers()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_stopping = true;
+			}
+			m_wake.notify_all();
+			for (auto& thread : m_threads)
+				thread.join();
+		}
+
+		Workers(const Workers&) = delete;
+		Workers& operator=(const Workers&) = delete;
+
+		size_t size() const
+		{
+			return m_threads.size() + 1;
+		}
+
+		// Returns once all of count threads are done
+		template <class Work>
+		void run(size_t count, const Work& work)
+		{
+			assert(count > 0 && count <= size());
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_call = [](const void* context, size_t thread) { (*static_cast<const Work*>(context))(thread); };
+				m_work = &work;
+				m_count = count;
+				m_running = count - 1;
+				++m_generation;
+			}
+			m_wake.notify_all();
+
+			work(0);
+
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_done.wait(lock, [this]() { return 0 == m_running; });
+		}
+
+	private:
+		void loop(size_t thread)
+		{
+			uint64_t seen = 0;
+			std::unique_lock<std::mutex> lock(m_mutex);
+			while (true)
+			{
+				m_wake.wait(lock, [this, seen]() { return m_stopping || m_generation != seen; });
+				if (m_stopping)
+					return;
+
+				seen = m_generation;
+				// Threads above count of this pass sit it out
+				if (thread >= m_count)
+					continue;
+
+				lock.unlock();
+				m_call(m_work, thread);
+				lock.lock();
+
+				if (0 == --m_running)
+					m_done.notify_one();
+			}
+		}
+
+		std::vector<std::thread> m_threads;
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		std::condition_variable m_done;
+
+		// Work of current pass
+		void (*m_call)(const void*, size_t);
+		const void* m_work;
+		size_t m_count;
+		uint64_t m_generation;
+		size_t m_running;
+		bool m_stopping;
+	};
+} // namespace physic
+
+#endif // PHYS_WORKERS_H
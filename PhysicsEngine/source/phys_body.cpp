@@ -1,14 +1,17 @@
 #include <phys_body.h>
 #include <phys_constants.h>
 
-#include <numeric>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
 
 using namespace physic;
 
 class ShapeBox : public IShape
 {
 public:
-	explicit ShapeBox() : m_shape(ShapeType::Rectangle), m_radius(0) {};
+	explicit ShapeBox() : m_radius(0) {};
 	virtual ~ShapeBox() = default;
 
 	ShapeBox(const ShapeBox&) = delete;
@@ -29,10 +32,7 @@ public:
 	void collidePolygon(IShape* other);
 
 private:
-	IShape::ShapeType m_shape;
 	int m_radius;
-	fVec2D m_normal;
-	Point m_center;
 
 	int m_width;
 	int m_height;
@@ -40,17 +40,17 @@ private:
 
 IShape::ShapeType ShapeBox::GetShapeType() const
 {
-	return m_shape;
+	return ShapeType::Rectangle;
 }
 
 Point ShapeBox::GetCenter() const
 {
-	return m_center;
+	return { 0, 0 };
 }
 
 fVec2D ShapeBox::GetNormalVector() const
 {
-	return m_normal;
+	return { 0, 0 };
 }
 
 bool ShapeBox::Collide(IShape* other)
@@ -94,13 +94,13 @@ void ShapeBox::collidePolygon(IShape* other)
 class ShapeCircle : public IShape
 {
 public:
-	explicit ShapeCircle() : m_shape(ShapeType::Circle), m_radius(0) {};
+	explicit ShapeCircle(int radius) : m_radius(radius) {};
 	virtual ~ShapeCircle() = default;
 
 	ShapeCircle(const ShapeCircle&) = delete;
 	ShapeCircle& operator=(const ShapeCircle&) = delete;
 
-	ShapeCircle(ShapeCircle&&);
+	ShapeCircle(ShapeCircle&&) = delete;
 	ShapeCircle& operator=(ShapeCircle&&) = delete;
 
 	virtual ShapeType GetShapeType() const override;
@@ -111,27 +111,17 @@ public:
 	virtual bool Collide(IShape* other) override;
 
 private:
-	IShape::ShapeType m_shape;
-	int m_radius;
-	fVec2D m_normal;
-	Point m_center;
+	const int m_radius;
 };
 
-ShapeCircle::ShapeCircle(ShapeCircle&& other)
-	: m_shape(std::move(other.m_shape))
-	, m_radius(std::move(other.m_radius))
-{
-
-}
-
 IShape::ShapeType ShapeCircle::GetShapeType() const
 {
-	return m_shape;
+	return ShapeType::Circle;
 }
 
 Point ShapeCircle::GetCenter() const
 {
-	return m_center;
+	return { 0, 0 };
 }
 
 int ShapeCircle::GetRadius() const
@@ -149,12 +139,91 @@ bool ShapeCircle::Collide(IShape* other)
 	return false;
 }
 
+// Shapes are looked up by id from any thread without locking, so they are kept in pages
+// which are allocated on demand and never moved or freed
+class ShapeRegistry
+{
+public:
+	static const size_t kPageSize = 256;
+	static const size_t kMaxPages = 256;
+
+	static ShapeRegistry& Instance()
+	{
+		static ShapeRegistry registry;
+		return registry;
+	}
+
+	ShapeId registerCircle(int radius)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto found = m_circles.find(radius);
+		if (found != std::end(m_circles))
+			return found->second;
+
+		const ShapeId id = add(std::make_shared<ShapeCircle>(radius));
+		m_circles.emplace(radius, id);
+		return id;
+	}
+
+	ShapePtr get(ShapeId id) const
+	{
+		if (id >= m_count.load(std::memory_order_acquire))
+			return nullptr;
+
+		return m_pages[id / kPageSize][id % kPageSize];
+	}
+
+private:
+	ShapeRegistry()
+		: m_count(0)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_circles.emplace(kDefaultBodyRadius, add(std::make_shared<ShapeCircle>(kDefaultBodyRadius)));
+	}
+
+	// Called under lock, shape is visible to readers once count is increased
+	ShapeId add(ShapePtr shape)
+	{
+		const size_t count = m_count.load(std::memory_order_relaxed);
+		assert(count < kPageSize * kMaxPages);
+		if (count >= kPageSize * kMaxPages)
+			return kDefaultShapeId;
+
+		auto& page = m_pages[count / kPageSize];
+		if (nullptr == page)
+			page.reset(new ShapePtr[kPageSize]);
+
+		page[count % kPageSize] = std::move(shape);
+		m_count.store(count + 1, std::memory_order_release);
+		return static_cast<ShapeId>(count);
+	}
+
+	std::mutex m_mutex;
+	std::unordered_map<int, ShapeId> m_circles;
+
+	std::array<std::unique_ptr<ShapePtr[]>, kMaxPages> m_pages;
+	std::atomic<size_t> m_count;
+};
+
+ShapeId IShape::RegisterCircle(int radius)
+{
+	assert(radius > 0);
+	return ShapeRegistry::Instance().registerCircle(radius);
+}
+
+ShapePtr IShape::GetShape(ShapeId id)
+{
+	return ShapeRegistry::Instance().get(id);
+}
+
 // TODO move BodyImpl to private include header
 class BodyImpl : public IBody
 {
 public:
 	BodyImpl() = delete;
-	BodyImpl(IShape::ShapeType, Point, fVec2D, float);
+	BodyImpl(ShapeId, Point, fVec2D, Scalar, BodyType);
+	explicit BodyImpl(const BodyState&);
 	~BodyImpl() = default;
 	BodyImpl(const BodyImpl&) = delete;
 	BodyImpl& operator=(const BodyImpl&) = delete;
@@ -162,6 +231,9 @@ public:
 	BodyImpl(BodyImpl&&);
 	BodyImpl& operator=(BodyImpl&&) = delete;
 
+	virtual BodyId GetId() const override;
+	virtual BodyType GetBodyType() const override;
+
 	virtual Point GetPosition() const override;
 	virtual void SetPosition(const Point&) override;
 
@@ -171,53 +243,141 @@ public:
 	virtual fVec2D GetVelocityVector() const override;
 	virtual void SetVelocityVector(const fVec2D&) override;
 
-	virtual float GetBounceFactor() const override;
-	virtual void SetBounceFactor(float) override;
+	virtual Scalar GetBounceFactor() const override;
+	virtual void SetBounceFactor(Scalar) override;
+
+	virtual bool IsSensor() const override;
+	virtual void SetSensor(bool) override;
+
+	virtual CollisionFilter GetCollisionFilter() const override;
+	virtual void SetCollisionFilter(const CollisionFilter&) override;
 
 	virtual void ApplyForce(const fVec2D&) override;
 	virtual void ApplyImpulse(const fVec2D&) override;
 
-	virtual void Update(float dt) override;
+	virtual fVec2D GetPendingForce() const override;
+	virtual fVec2D GetPendingImpulse() const override;
+	virtual void SetPending(const fVec2D& force, const fVec2D& impulse) override;
+
+	virtual void Update(Scalar dt) override;
+	virtual void IntegrateVelocity(Scalar dt) override;
+	virtual void IntegratePosition(Scalar dt) override;
 
 	virtual ShapePtr GetShape() const override;
+	virtual ShapeId GetShapeId() const override;
+	virtual Scalar GetRadius() const override;
+
+	virtual BodyState GetState() const override;
+	virtual uint32_t GetRevision() const override;
 
 private:
 	// TODO get usage of mass and calculate impulses
+	BodyId m_id;
+	BodyType m_type;
 	Point m_position;
 	fVec2D m_velocity;
 	Mass m_mass;
 
-	std::vector<fVec2D> m_forces;
-	std::vector<fVec2D> m_impulses;
+	// Sums of forces and impulses applied on current step
+	fVec2D m_force;
+	fVec2D m_impulse;
+
+	// Left by IntegrateVelocity for IntegratePosition
+	fVec2D m_displacement;
+	fVec2D m_integratedVelocity;
 
-	std::shared_ptr<IShape> m_shape;
+	// Geometry is shared by all bodies of the same shape
+	ShapeId m_shape;
+	Scalar m_radius;
 
 	// Leave "bounciness" to some "material"
-	float m_bounceFactor;
+	Scalar m_bounceFactor;
+
+	bool m_sensor;
+	CollisionFilter m_filter;
+
+	uint32_t m_revision;
 };
 
-BodyImpl::BodyImpl(IShape::ShapeType shape, Point pos, fVec2D vel, float mass)
-	: m_position(pos)
-	, m_velocity(vel)
-	, m_mass(mass)
-	, m_forces()
-	, m_impulses()
-	, m_shape(std::make_shared<ShapeCircle>(ShapeCircle()))
+// Bodies may be created from any thread
+static std::atomic<BodyId> s_nextBodyId(0);
+static std::atomic<BodyId> s_firstBodyId(0);
+static std::atomic<BodyId> s_lastBodyId(UINT32_MAX);
+
+BodyImpl::BodyImpl(ShapeId shape, Point pos, fVec2D vel, Scalar mass, BodyType type)
+	: m_id(s_nextBodyId++)
+	, m_type(type)
+	, m_position(pos)
+	, m_velocity(type == BodyType::Static ? fVec2D{ 0, 0 } : vel)
+	, m_mass(type == BodyType::Dynamic ? mass : Scalar(0))
+	, m_force{ 0, 0 }
+	, m_impulse{ 0, 0 }
+	, m_displacement{ 0, 0 }
+	, m_integratedVelocity{ 0, 0 }
+	, m_shape(nullptr != IShape::GetShape(shape) ? shape : kDefaultShapeId)
+	, m_radius(static_cast<Scalar>(IShape::GetShape(m_shape)->GetRadius()))
 	, m_bounceFactor(kBounceFactor)
+	, m_sensor(false)
+	, m_filter(kDefaultCollisionFilter)
+	, m_revision(0)
 {}
 
+BodyImpl::BodyImpl(const BodyState& state)
+	: m_id(state.id)
+	, m_type(state.type)
+	, m_position(state.position)
+	, m_velocity(state.velocity)
+	, m_mass(state.type == BodyType::Dynamic ? state.mass : Scalar(0))
+	, m_force{ 0, 0 }
+	, m_impulse{ 0, 0 }
+	, m_displacement{ 0, 0 }
+	, m_integratedVelocity{ 0, 0 }
+	, m_shape(nullptr != IShape::GetShape(state.shape_id) ? state.shape_id : kDefaultShapeId)
+	, m_radius(static_cast<Scalar>(IShape::GetShape(m_shape)->GetRadius()))
+	, m_bounceFactor(state.bounce_factor)
+	, m_sensor(state.sensor)
+	, m_filter(state.filter)
+	, m_revision(0)
+{
+	// Ids of restored bodies must not be given to new ones
+	if (m_id < s_firstBodyId.load() || m_id >= s_lastBodyId.load())
+		return;
+
+	BodyId next = s_nextBodyId.load();
+	while (next <= m_id && !s_nextBodyId.compare_exchange_weak(next, m_id + 1))
+		;
+}
+
 BodyImpl::BodyImpl(BodyImpl&& other)
-	: m_position(std::move(other.m_position))
+	: m_id(std::move(other.m_id))
+	, m_type(std::move(other.m_type))
+	, m_position(std::move(other.m_position))
 	, m_velocity(std::move(other.m_velocity))
 	, m_mass(std::move(other.m_mass))
-	, m_forces(std::move(other.m_forces))
-	, m_impulses(std::move(other.m_impulses))
+	, m_force(std::move(other.m_force))
+	, m_impulse(std::move(other.m_impulse))
+	, m_displacement(std::move(other.m_displacement))
+	, m_integratedVelocity(std::move(other.m_integratedVelocity))
 	, m_shape(std::move(other.m_shape))
+	, m_radius(std::move(other.m_radius))
 	, m_bounceFactor(std::move(other.m_bounceFactor))
+	, m_sensor(std::move(other.m_sensor))
+	, m_filter(std::move(other.m_filter))
+	, m_revision(std::move(other.m_revision))
 {
 
 }
 
+BodyId BodyImpl::GetId() const
+{
+	return m_id;
+}
+
+IBody::BodyType BodyImpl::GetBodyType() const
+{
+	return m_type;
+}
+
 Point BodyImpl::GetPosition() const
 {
 	return m_position;
@@ -226,6 +386,7 @@ Point BodyImpl::GetPosition() const
 void BodyImpl::SetPosition(const Point& val)
 {
 	m_position = val;
+	++m_revision;
 }
 
 Mass BodyImpl::GetMass() const
@@ -235,7 +396,9 @@ Mass BodyImpl::GetMass() const
 
 void BodyImpl::SetMass(const Mass& mass)
 {
-	m_mass = mass;
+	// Static and kinematic bodies keep infinite mass
+	if (BodyType::Dynamic == m_type)
+		m_mass = mass;
 }
 
 fVec2D BodyImpl::GetVelocityVector() const
@@ -248,49 +411,150 @@ void BodyImpl::SetVelocityVector(const fVec2D& val)
 	m_velocity = val;
 }
 
-float BodyImpl::GetBounceFactor() const
+Scalar BodyImpl::GetBounceFactor() const
 {
 	return m_bounceFactor;
 }
 
-void BodyImpl::SetBounceFactor(float bounceFactor)
+void BodyImpl::SetBounceFactor(Scalar bounceFactor)
 {
 	m_bounceFactor = bounceFactor;
 }
 
+bool BodyImpl::IsSensor() const
+{
+	return m_sensor;
+}
+
+void BodyImpl::SetSensor(bool sensor)
+{
+	m_sensor = sensor;
+}
+
+CollisionFilter BodyImpl::GetCollisionFilter() const
+{
+	return m_filter;
+}
+
+void BodyImpl::SetCollisionFilter(const CollisionFilter& filter)
+{
+	m_filter = filter;
+	++m_revision;
+}
+
 void BodyImpl::ApplyForce(const fVec2D& force)
 {
-	m_forces.push_back(force);
+	m_force += force;
 }
 
 void BodyImpl::ApplyImpulse(const fVec2D& impulse)
 {
-	m_impulses.push_back(impulse);
+	m_impulse += impulse;
+}
+
+fVec2D BodyImpl::GetPendingForce() const
+{
+	return m_force;
+}
+
+fVec2D BodyImpl::GetPendingImpulse() const
+{
+	return m_impulse;
 }
 
-void BodyImpl::Update(float dt)
+void BodyImpl::SetPending(const fVec2D& force, const fVec2D& impulse)
 {
-	// Summarize all impulses applied to this body on this step
-	const fVec2D impulses = std::accumulate(std::begin(m_impulses), std::end(m_impulses), fVec2D(0, 0));
+	m_force = force;
+	m_impulse = impulse;
+}
 
-	// Summarize all forces applied to this body on this step
-	const fVec2D forces = std::accumulate(std::begin(m_forces), std::end(m_forces), fVec2D(0, 0));
-	const fVec2D acceleration = forces * m_mass.inv_mass;
+void BodyImpl::Update(Scalar dt)
+{
+	IntegrateVelocity(dt);
+	IntegratePosition(dt);
+}
+
+void BodyImpl::IntegrateVelocity(Scalar dt)
+{
+	// Forces and impulses are already summarized by ApplyForce and ApplyImpulse
+	const fVec2D acceleration = m_force * m_mass.inv_mass;
 
-	m_position += dt * m_velocity + 0.5f * acceleration * dt * dt;
-	m_velocity += dt * acceleration + impulses * m_mass.inv_mass;
+	m_displacement = dt * m_velocity + Scalar(0.5) * acceleration * dt * dt;
+	m_velocity += dt * acceleration + m_impulse * m_mass.inv_mass;
+	m_integratedVelocity = m_velocity;
 
-	m_impulses.clear();
-	m_forces.clear();
+	m_impulse = { 0, 0 };
+	m_force = { 0, 0 };
+}
+
+void BodyImpl::IntegratePosition(Scalar dt)
+{
+	// Velocity corrected by constraints is kept for the whole step, so they hold after it
+	if (m_velocity != m_integratedVelocity)
+		m_position += dt * m_velocity;
+	else
+		m_position += m_displacement;
+	++m_revision;
 }
 
 ShapePtr BodyImpl::GetShape() const
 {
-	assert(nullptr != m_shape);
+	return IShape::GetShape(m_shape);
+}
+
+ShapeId BodyImpl::GetShapeId() const
+{
 	return m_shape;
 }
 
-BodyPtr IBody::CreateBody(IShape::ShapeType shape, const Point& position, const fVec2D& velocity, float mass)
+Scalar BodyImpl::GetRadius() const
+{
+	return m_radius;
+}
+
+BodyState BodyImpl::GetState() const
 {
-	return std::shared_ptr<IBody>(std::make_shared<BodyImpl>(BodyImpl(shape, position, velocity, mass)));
-}
\ No newline at end of file
+	BodyState state;
+	state.id = m_id;
+	state.type = m_type;
+	state.shape = GetShape()->GetShapeType();
+	state.shape_id = m_shape;
+	state.position = m_position;
+	state.velocity = m_velocity;
+	state.mass = m_mass.mass;
+	state.bounce_factor = m_bounceFactor;
+	state.sensor = m_sensor;
+	state.filter = m_filter;
+	return state;
+}
+
+uint32_t BodyImpl::GetRevision() const
+{
+	return m_revision;
+}
+
+BodyPtr IBody::CreateBody(IShape::ShapeType shape, const Point& position, const fVec2D& velocity, Scalar mass, BodyType type)
+{
+	// Every shape type is simulated as default circle so far
+	(void)shape;
+	return CreateBody(kDefaultShapeId, position, velocity, mass, type);
+}
+
+BodyPtr IBody::CreateBody(ShapeId shape, const Point& position, const fVec2D& velocity, Scalar mass, BodyType type)
+{
+	return std::shared_ptr<IBody>(std::make_shared<BodyImpl>(BodyImpl(shape, position, velocity, mass, type)));
+}
+
+BodyPtr IBody::CreateBody(const BodyState& state)
+{
+	return std::shared_ptr<IBody>(std::make_shared<BodyImpl>(BodyImpl(state)));
+}
+
+void IBody::SetIdRange(BodyId first, BodyId last)
+{
+	assert(first < last);
+
+	s_firstBodyId = first;
+	s_lastBodyId = last;
+	s_nextBodyId = first;
+}
@@ -0,0 +1,158 @@
+#include "phys_engine_impl.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace physic;
+
+uint64_t EngineImpl::GetStepIndex() const
+{
+	return m_stepIndex;
+}
+
+void EngineImpl::SetCheckpointCount(size_t count)
+{
+	m_checkpoints.clear();
+	m_checkpoints.resize(count);
+	m_checkpointCount = count;
+	m_nextCheckpoint = 0;
+
+	// No step is kept yet
+	for (auto& checkpoint : m_checkpoints)
+		checkpoint.step = UINT64_MAX;
+
+	deleteRetiredChunkFiles();
+}
+
+bool EngineImpl::Rewind(uint64_t step)
+{
+	auto found = std::find_if(std::begin(m_checkpoints), std::end(m_checkpoints),
+		[step](const Checkpoint& checkpoint) { return checkpoint.step == step; });
+	if (found == std::end(m_checkpoints))
+		return false;
+
+	const Checkpoint& checkpoint = *found;
+	const Membership& membership = *checkpoint.membership;
+
+	// Set of bodies is restored only if it was changed since the checkpoint
+	if (m_membership != checkpoint.membership)
+	{
+		m_bodies = membership.bodies;
+		m_kinematicBodies = membership.kinematic_bodies;
+		m_staticBodies = membership.static_bodies;
+
+		// Bodies frozen or streamed out since then are in memory again and ones woken since then
+		// are frozen again, so none of them is added twice when its chunk wakes up
+		m_frozenChunks = membership.frozen_chunks;
+		size_t frozen = 0;
+		for (const auto& chunk : membership.frozen_chunks)
+			for (const auto& body : chunk.second)
+			{
+				body->SetPosition(membership.frozen_positions[frozen]);
+				body->SetVelocityVector(membership.frozen_velocities[frozen]);
+				++frozen;
+			}
+		restoreChunkFiles(membership.streamed_chunks, step);
+		m_removedStreamed = membership.removed_streamed;
+
+		// Joints of bodies removed since then come back with them
+		m_joints.restore(membership.joints);
+
+		m_membership = checkpoint.membership;
+		m_staticTreeDirty = true;
+		// Regions may have changed since the checkpoint
+		m_activityChanged = true;
+	}
+
+	size_t index = 0;
+	for (auto& body : m_bodies)
+	{
+		body->SetPosition(checkpoint.positions[index]);
+		body->SetVelocityVector(checkpoint.velocities[index]);
+		body->SetPending(checkpoint.forces[index], checkpoint.impulses[index]);
+		++index;
+	}
+	for (auto& body : m_kinematicBodies)
+	{
+		body->SetPosition(checkpoint.positions[index]);
+		body->SetVelocityVector(checkpoint.velocities[index]);
+		++index;
+	}
+	m_treeDirty = true;
+
+	// Skipped steps of far bodies are kept as well, so steps are simulated again the same way
+	m_bodyLod = checkpoint.lod;
+
+	m_prevContacts = checkpoint.contacts;
+	m_stepIndex = step;
+
+	// Later steps are going to be simulated again
+	for (auto& later : m_checkpoints)
+		if (later.step != UINT64_MAX && later.step > step)
+		{
+			later.step = UINT64_MAX;
+			later.membership.reset();
+		}
+
+	m_nextCheckpoint = (static_cast<size_t>(found - std::begin(m_checkpoints)) + 1) % m_checkpointCount;
+	return true;
+}
+
+void EngineImpl::saveCheckpoint()
+{
+	if (nullptr == m_membership)
+	{
+		auto membership = std::make_shared<Membership>();
+		membership->bodies = m_bodies;
+		membership->kinematic_bodies = m_kinematicBodies;
+		membership->static_bodies = m_staticBodies;
+
+		membership->frozen_chunks = m_frozenChunks;
+		for (const auto& chunk : membership->frozen_chunks)
+			for (const auto& body : chunk.second)
+			{
+				membership->frozen_positions.push_back(body->GetPosition());
+				membership->frozen_velocities.push_back(body->GetVelocityVector());
+			}
+		membership->streamed_chunks = m_streamedChunks;
+		membership->removed_streamed = m_removedStreamed;
+
+		m_joints.save(membership->joints);
+		m_membership = membership;
+	}
+
+	// Buffers of the oldest checkpoint keep their capacity
+	Checkpoint& checkpoint = m_checkpoints[m_nextCheckpoint];
+	m_nextCheckpoint = (m_nextCheckpoint + 1) % m_checkpointCount;
+
+	checkpoint.step = m_stepIndex;
+	checkpoint.membership = m_membership;
+
+	const size_t count = m_bodies.size() + m_kinematicBodies.size();
+	checkpoint.positions.resize(count);
+	checkpoint.velocities.resize(count);
+	checkpoint.forces.resize(m_bodies.size());
+	checkpoint.impulses.resize(m_bodies.size());
+
+	size_t index = 0;
+	for (const auto& body : m_bodies)
+	{
+		checkpoint.positions[index] = body->GetPosition();
+		checkpoint.velocities[index] = body->GetVelocityVector();
+		checkpoint.forces[index] = body->GetPendingForce();
+		checkpoint.impulses[index] = body->GetPendingImpulse();
+		++index;
+	}
+	for (const auto& body : m_kinematicBodies)
+	{
+		checkpoint.positions[index] = body->GetPosition();
+		checkpoint.velocities[index] = body->GetVelocityVector();
+		++index;
+	}
+
+	checkpoint.lod = m_bodyLod;
+	checkpoint.contacts = m_prevContacts;
+
+	// Overwritten checkpoint could be the last one to need files read back since then
+	deleteRetiredChunkFiles();
+}
@@ -0,0 +1,97 @@
+#ifndef PHYS_COMMAND_QUEUE_H
+#define PHYS_COMMAND_QUEUE_H
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace physic
+{
+	// Bounded multi-producer single-consumer queue on a ring of preallocated cells, nothing is
+	// allocated after construction. Producers never wait for each other or the consumer: push
+	// claims a cell with one compare-exchange and publishes it with one store. Every cell carries
+	// a sequence number telling whose turn it is, so an item pushed while another producer is in
+	// the middle of push may become visible only after that push completes.
+	template <class T>
+	class CommandQueue
+	{
+	public:
+		// Capacity must be a power of two
+		explicit CommandQueue(size_t capacity)
+			: m_cells(new Cell[capacity])
+			, m_mask(capacity - 1)
+			, m_pushPosition(0)
+			, m_popPosition(0)
+		{
+			assert(capacity >= 2 && (capacity & (capacity - 1)) == 0);
+
+			for (size_t i = 0; i < capacity; ++i)
+				m_cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+
+		CommandQueue(const CommandQueue&) = delete;
+		CommandQueue& operator=(const CommandQueue&) = delete;
+
+		// Any thread. Returns false if queue is full, value is left untouched then.
+		bool push(T&& value)
+		{
+			size_t position = m_pushPosition.load(std::memory_order_relaxed);
+			Cell* cell;
+			while (true)
+			{
+				cell = &m_cells[position & m_mask];
+				const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+				const ptrdiff_t turn = static_cast<ptrdiff_t>(sequence) - static_cast<ptrdiff_t>(position);
+				if (0 == turn)
+				{
+					if (m_pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+						break;
+				}
+				else if (turn < 0)
+				{
+					// Cell still holds item of previous lap
+					return false;
+				}
+				else
+				{
+					position = m_pushPosition.load(std::memory_order_relaxed);
+				}
+			}
+
+			cell->value = std::move(value);
+			cell->sequence.store(position + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Consumer thread only. Returns false if queue is empty.
+		bool pop(T& value)
+		{
+			Cell& cell = m_cells[m_popPosition & m_mask];
+			if (cell.sequence.load(std::memory_order_acquire) != m_popPosition + 1)
+				return false;
+
+			// Cell is handed to producers of next lap
+			value = std::move(cell.value);
+			cell.value = T();
+			cell.sequence.store(m_popPosition + m_mask + 1, std::memory_order_release);
+			++m_popPosition;
+			return true;
+		}
+
+	private:
+		struct Cell
+		{
+			std::atomic<size_t> sequence;
+			T value;
+		};
+
+		std::unique_ptr<Cell[]> m_cells;
+		const size_t m_mask;
+		std::atomic<size_t> m_pushPosition;
+		size_t m_popPosition;
+	};
+} // namespace physic
+
+#endif // PHYS_COMMAND_QUEUE_H
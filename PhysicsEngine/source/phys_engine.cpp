@@ -1,56 +1,28 @@
-#include <phys_engine.h>
-#include <phys_constants.h>
-#include <phys_quadtree.h>
+#include "phys_engine_impl.h"
 
 #include <algorithm>
 #include <chrono>
 #include <iostream>
+#include <stdexcept>
+#include <thread>
 #include <vector>
 
 using namespace physic;
 
-class EngineImpl : public IEngine
-{
-public:
-	virtual void SetWorldBorders(
-		Point bot_left = kWorldBotLeft,
-		Point top_right = kWorldTopRight) override;
-
-	virtual void SetWorldConstants(
-		float gravity = kGravity, 
-		float air_density = kAirDragFactor, 
-		float ground_friction = kGroundFriction) override;
-	
-	virtual void AddBody(BodyPtr&) override;
-	virtual void RemoveBody(const BodyPtr&) override;
-	virtual void Step(double dt) override;
-
-	EngineImpl();
-	virtual ~EngineImpl() = default;
-
-	EngineImpl(const EngineImpl&) = delete;
-	EngineImpl& operator=(const EngineImpl&) = delete;
-	EngineImpl(EngineImpl&&) = delete;
-	EngineImpl& operator=(EngineImpl&&) = delete;
-
-private:
-
-	//bool checkBodyOnBorder()
-	bool checkCollision(const BodyPtr&, const BodyPtr&) const;
+// Contact buffers are allocated once for this number of contacts
+const size_t kReservedContacts = 1024;
 
-	void solveCollision(BodyPtr&, BodyPtr&) const;
+// Commands pushed between two steps above this number are rejected
+const size_t kCommandQueueCapacity = 16384;
 
-	Point clipPointToWorldBorder(const Point&) const;
-
-	Point m_botLeft;
-	Point m_topRight;
-
-	std::vector<BodyPtr> m_bodies;
-
-	fVec2D m_gravity;
-	float m_airDrag;
-	float m_groundFricion;
-};
+// Revisions only grow, so the sum changes once any body is moved or refiltered
+static uint64_t SumRevisions(const std::vector<BodyPtr>& bodies)
+{
+	uint64_t sum = 0;
+	for (const auto& body : bodies)
+		sum += body->GetRevision();
+	return sum;
+}
 
 void EngineImpl::SetWorldBorders(Point bot_left, Point top_right)
 {
@@ -59,98 +31,676 @@ void EngineImpl::SetWorldBorders(Point bot_left, Point top_right)
 	m_topRight = top_right;
 }
 
-void EngineImpl::SetWorldConstants(float gravity, float air_drag, float ground_friction)
+void EngineImpl::SetWorldConstants(Scalar gravity, Scalar air_drag, Scalar ground_friction)
 {
-	m_gravity = fVec2D(gravity, fAngle(-90.));
+	// Not a polar vector: rounded angle of -90 degrees has a small cosine, with fixed point Scalar
+	// bodies would slowly slide sideways
+	m_gravity = fVec2D{ 0, -gravity };
 	m_airDrag = air_drag;
 	m_groundFricion = ground_friction;
+
+	// Replace built-in fields in place to keep evaluation order
+	const ForceFieldPtr gravity_field = IForceField::CreateUniform(m_gravity);
+	const ForceFieldPtr air_drag_field = IForceField::CreateDrag(air_drag);
+	std::replace(std::begin(m_fields), std::end(m_fields), m_gravityField, gravity_field);
+	std::replace(std::begin(m_fields), std::end(m_fields), m_airDragField, air_drag_field);
+	m_gravityField = gravity_field;
+	m_airDragField = air_drag_field;
 }
 
 void EngineImpl::AddBody(BodyPtr& body)
 {
 	assert(nullptr != body);
-	m_bodies.push_back(body);
+
+	m_membership.reset();
+
+	switch (body->GetBodyType())
+	{
+	case IBody::BodyType::Static:
+		m_staticBodies.push_back(body);
+		m_staticTreeDirty = true;
+		break;
+	case IBody::BodyType::Kinematic:
+		m_kinematicBodies.push_back(body);
+		m_treeDirty = true;
+		break;
+	default:
+		m_bodies.push_back(body);
+		m_bodyLod.push_back({ 1, 0, 0 });
+		m_treeDirty = true;
+		break;
+	}
 }
 
 void EngineImpl::RemoveBody(const BodyPtr& body)
 {
 	assert(nullptr != body);
-	m_bodies.erase(std::remove(std::begin(m_bodies), std::end(m_bodies), body), std::end(m_bodies));
+
+	m_membership.reset();
+
+	bool removed = false;
+	if (body->GetBodyType() == IBody::BodyType::Dynamic)
+	{
+		// Rates are kept in order of bodies
+		auto found = std::find(std::begin(m_bodies), std::end(m_bodies), body);
+		if (found != std::end(m_bodies))
+		{
+			m_bodyLod.erase(std::begin(m_bodyLod) + (found - std::begin(m_bodies)));
+			m_bodies.erase(found);
+			removed = true;
+		}
+	}
+	else
+	{
+		std::vector<BodyPtr>& bodies = body->GetBodyType() == IBody::BodyType::Static ? m_staticBodies : m_kinematicBodies;
+		const size_t count = bodies.size();
+		bodies.erase(std::remove(std::begin(bodies), std::end(bodies), body), std::end(bodies));
+		removed = count != bodies.size();
+	}
+
+	// Frozen body stays in chunk of its last position
+	const uint64_t chunk_key = GetChunkKey(GetChunkCoord(body->GetPosition(), kWorldChunkSize));
+	auto frozen = m_frozenChunks.find(chunk_key);
+	if (!removed && frozen != std::end(m_frozenChunks))
+	{
+		std::vector<BodyPtr>& chunk = frozen->second;
+		const size_t count = chunk.size();
+		chunk.erase(std::remove(std::begin(chunk), std::end(chunk), body), std::end(chunk));
+		removed = count != chunk.size();
+	}
+
+	// Body written to disk is left out when its chunk is read back
+	if (!removed && m_streamedChunks.count(chunk_key) != 0)
+		m_removedStreamed.insert(body->GetId());
+
+	m_joints.removeBody(body);
+
+	if (body->GetBodyType() == IBody::BodyType::Static)
+		m_staticTreeDirty = true;
+	else
+		m_treeDirty = true;
 }
 
-void EngineImpl::Step(double dt)
+void EngineImpl::AddForceField(const ForceFieldPtr& field)
 {
-	// Fill spatial quadtree
-	QuadTree<BodyPtr> tree(0, m_botLeft, m_topRight);
-	for (const auto& body : m_bodies)
+	assert(nullptr != field);
+	m_fields.push_back(field);
+}
+
+void EngineImpl::RemoveForceField(const ForceFieldPtr& field)
+{
+	assert(nullptr != field);
+	m_fields.erase(std::remove(std::begin(m_fields), std::end(m_fields), field), std::end(m_fields));
+}
+
+JointId EngineImpl::AddJoint(const JointDef& def)
+{
+	m_membership.reset();
+	return m_joints.add(def);
+}
+
+bool EngineImpl::RemoveJoint(JointId id)
+{
+	m_membership.reset();
+	return m_joints.remove(id);
+}
+
+void EngineImpl::ApplyForces(const BodyPtr* bodies, const fVec2D* forces, size_t count)
+{
+	assert(nullptr != bodies || 0 == count);
+	assert(nullptr != forces || 0 == count);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		assert(nullptr != bodies[i]);
+		bodies[i]->ApplyForce(forces[i]);
+	}
+}
+
+bool EngineImpl::PushCommand(BodyCommand command)
+{
+	assert(nullptr != command.body);
+	return m_commands.push(std::move(command));
+}
+
+void EngineImpl::applyCommands()
+{
+	BodyCommand command;
+	while (m_commands.pop(command))
 	{
-		tree.insert(body);
+		switch (command.type)
+		{
+		case BodyCommand::Type::Add:
+			AddBody(command.body);
+			break;
+		case BodyCommand::Type::Remove:
+			RemoveBody(command.body);
+			break;
+		case BodyCommand::Type::ApplyForce:
+			command.body->ApplyForce(command.value);
+			break;
+		case BodyCommand::Type::ApplyImpulse:
+			command.body->ApplyImpulse(command.value);
+			break;
+		case BodyCommand::Type::SetPosition:
+			command.body->SetPosition(Point{ command.value.x, command.value.y });
+			break;
+		case BodyCommand::Type::SetVelocity:
+			command.body->SetVelocityVector(command.value);
+			break;
+		default:
+			break;
+		}
 	}
+}
+
+void EngineImpl::stepOnce(double dt)
+{
+	// Changes made by other threads since previous step
+	applyCommands();
+
+	// Bodies could leave active area on previous step
+	updateActivity();
 
-	for (auto& body : m_bodies)
+	// Spatial index is filled at the end of previous step, refill it only if set of bodies
+	// was changed since then or setters moved or refiltered any of them, e.g. by SetPosition
+	if (m_treeDirty || m_treeRevision != SumRevisions(m_bodies) + SumRevisions(m_kinematicBodies))
+		rebuildTree();
+
+	if (m_staticTreeDirty || m_staticTreeRevision != SumRevisions(m_staticBodies))
+		rebuildStaticTree();
+
+	m_terrain.build();
+
+	m_contacts.clear();
+	m_maxPenetration = Scalar(0);
+	m_indexShift = Scalar(0);
+
+	// Far bodies skip steps, the ones stepped now cover all skipped steps
+	scheduleBodies(dt);
+
+	const bool bounded = m_activityRegions.empty();
+
+	for (size_t i = 0; i < m_bodies.size(); ++i)
 	{
-		Point position = body->GetPosition();
-		
-		// TODO clip position in here?
-		position = clipPointToWorldBorder(position);
-		body->SetPosition(position);
+		// Skipped body still takes impulses from neighbours, they are applied on its step
+		if (0 == m_bodyDt[i])
+			continue;
+
+		BodyPtr& body = m_bodies[i];
+		const Point indexed = body->GetPosition();
+		Point position = indexed;
+
+		// Chunked world has no borders
+		if (bounded)
+		{
+			position = clipPointToWorldBorder(position);
+			body->SetPosition(position);
+		}
 
 		// Broad phase of collision detection:
-		// Look up for neighbours in quadrant
-		auto& colliding = tree.locate(body);
-		if (!colliding.empty())
-			for (auto& collide : colliding)
+		// Look up for nodes overlapping bounds of body, skip filtered out pairs
+		const Scalar radius = body->GetRadius();
+		const Point reach_bot_left{ position.x - radius, position.y - radius };
+		const Point reach_top_right{ position.x + radius, position.y + radius };
+		const CollisionFilter filter = body->GetCollisionFilter();
+		const BodyId id = body->GetId();
+		auto collide_with = [&](const ChunkTree<BodyPtr>::Entry& entry)
+		{
+			if (!ShouldCollide(filter, entry.filter))
+				return true;
+
+			// Impulses are applied only when bodies integrate, so both visits of pair would see
+			// the same velocities. Pair of dynamic bodies due on this step is solved by the one
+			// of lower id, others are visited only from the dynamic body due now.
+			BodyPtr collide = entry.object;
+			const BodyId collide_id = collide->GetId();
+			if (collide_id < id && collide->GetBodyType() == IBody::BodyType::Dynamic &&
+				!std::binary_search(std::begin(m_skippedIds), std::end(m_skippedIds), collide_id))
+				return true;
+
+			// Narrow phase of collision detection
+ 			if (checkCollision(body, collide))
 			{
-				// Narrow phase of collision detection
- 				if (checkCollision(body, collide))
+				recordContact(body, collide);
+
+				// Sensors only report contacts
+				if (!body->IsSensor() && !collide->IsSensor())
 					solveCollision(body, collide);
 			}
+			return true;
+		};
+		m_tree.query(reach_bot_left, reach_top_right, collide_with);
+
+		// Static bodies are kept apart, look up for the ones overlapping body the same way
+		m_staticTree.query(reach_bot_left, reach_top_right, collide_with);
+
+		// Terrain pushes body out of itself and takes velocity into its surface
+		if (!body->IsSensor() && !m_terrain.empty())
+		{
+			const Scalar bounce_factor = body->GetBounceFactor();
+			fVec2D velocity = body->GetVelocityVector();
+			auto touch_terrain = [&](const fVec2D& normal, Scalar depth)
+			{
+				position += normal * depth;
+
+				const Scalar speed = DotProduct(velocity, normal);
+				if (speed < Scalar(0))
+					velocity -= (Scalar(1) + bounce_factor) * speed * normal;
+
+				if (radius > Scalar(0))
+					m_maxPenetration = std::max(m_maxPenetration, depth / radius);
+			};
+			m_terrain.collide(position, radius, touch_terrain);
+
+			body->SetPosition(position);
+			body->SetVelocityVector(velocity);
+		}
+
+		const fVec2D shift = position - indexed;
+		m_indexShift = std::max({ m_indexShift, shift.x, -shift.x, shift.y, -shift.y });
+
+		if (!bounded)
+			continue;
 
 		// TODO Clean this up
 		// Check restrictions. Body will bounce at world margins.
 		const Mass mass = body->GetMass();
-		const float kBounceFactor = body->GetBounceFactor();
+		const Scalar kBounceFactor = body->GetBounceFactor();
 		fVec2D velocity = body->GetVelocityVector();
 
 		if (position.x >= m_topRight.x || position.x <= m_botLeft.x)
 			velocity.x *= -kBounceFactor;
 		
-		fVec2D ground_friction_force = { 0, 0 };
 		if (position.y >= m_topRight.y || position.y <= m_botLeft.y)
 		{
 			// Apply ground frictions simulation
 			if (position.y <= m_botLeft.y)
 				// Vector of force is negative to velocity vector
-				if (m_groundFricion > 0.f)
-					ground_friction_force = -m_groundFricion * EuclideanNorm(m_gravity) * mass.mass * velocity
-												/ EuclideanNorm(velocity);
+				if (m_groundFricion > Scalar(0) && velocity != fVec2D{ 0, 0 })
+					body->ApplyForce(-m_groundFricion * EuclideanNorm(m_gravity) * mass.mass * velocity
+												/ EuclideanNorm(velocity));
 
 			velocity.y *= -kBounceFactor;
 		}
 
 		body->SetVelocityVector(velocity);
+	}
+
+	// Gravity, air drag and all registered fields
+	applyForceFields();
+
+	// Forces and impulses of every body due on this step change its velocity,
+	// joints correct velocities and only then bodies move, so joints hold after the step
+	for (size_t i = 0; i < m_bodies.size(); ++i)
+		if (0 != m_bodyDt[i])
+			m_bodies[i]->IntegrateVelocity(static_cast<Scalar>(m_bodyDt[i]));
+
+	m_joints.solve(static_cast<Scalar>(dt), m_skippedIds);
+
+	for (size_t i = 0; i < m_bodies.size(); ++i)
+		if (0 != m_bodyDt[i])
+			m_bodies[i]->IntegratePosition(static_cast<Scalar>(m_bodyDt[i]));
+
+	// What velocities couldn't hold is corrected by moving bodies
+	m_joints.correct(m_skippedIds);
+
+	// Bodies could come closer to or go farther from focus points
+	updateTiers();
+
+	// Kinematic bodies just follow their velocity
+	for (auto& body : m_kinematicBodies)
+		body->Update(static_cast<Scalar>(dt));
+
+	// Particles bounce off borders and static bodies only
+	updateParticles(static_cast<Scalar>(dt));
+
+	// Index final positions for queries and next step
+	rebuildTree();
+
+	// Deliver all contact changes of this step at once
+	collectContactEvents();
 
-		//Apply air drag force
-		const fVec2D air_drag_force = m_airDrag * -velocity;
-		// Sum of force vectors, gravity force and air drag force
-		const fVec2D force = m_gravity * mass.mass + air_drag_force + ground_friction_force;
+	if (nullptr != m_contactListener && !m_contactEvents.empty())
+		m_contactListener->OnContacts(m_contactEvents.data(), m_contactEvents.size());
 
-		body->ApplyForce(force);
+	++m_stepIndex;
+	if (m_checkpointCount > 0)
+		saveCheckpoint();
 
-		// Run all the calculations for current body
-		body->Update(dt);
+	if (nullptr != m_stateExporter)
+		publishState();
+}
+
+void EngineImpl::SetContactListener(IContactListener* listener)
+{
+	m_contactListener = listener;
+}
+
+void EngineImpl::GetBodyStates(std::vector<BodyState>& states) const
+{
+	states.clear();
+	states.reserve(m_bodies.size() + m_kinematicBodies.size() + m_staticBodies.size());
+
+	for (const auto& body : m_bodies)
+		states.push_back(body->GetState());
+	for (const auto& body : m_kinematicBodies)
+		states.push_back(body->GetState());
+	for (const auto& body : m_staticBodies)
+		states.push_back(body->GetState());
+}
+
+void EngineImpl::SetStateExporter(const StateExporterPtr& exporter)
+{
+	m_stateExporter = exporter;
+}
+
+size_t EngineImpl::ExportBodies(ExportedBody* exported, size_t capacity) const
+{
+	assert(nullptr != exported || 0 == capacity);
+
+	size_t count = 0;
+	auto write = [&](const std::vector<BodyPtr>& bodies)
+	{
+		for (size_t i = 0; i < bodies.size() && count < capacity; ++i, ++count)
+		{
+			exported[count].id = bodies[i]->GetId();
+			exported[count].position = bodies[i]->GetPosition();
+			exported[count].velocity = bodies[i]->GetVelocityVector();
+		}
+	};
+	write(m_bodies);
+	write(m_kinematicBodies);
+	write(m_staticBodies);
+
+	return m_bodies.size() + m_kinematicBodies.size() + m_staticBodies.size();
+}
+
+void EngineImpl::publishState()
+{
+	// Bodies are written right into shared memory
+	size_t capacity = 0;
+	ExportedBody* exported = m_stateExporter->BeginWrite(capacity);
+
+	const size_t total = ExportBodies(exported, capacity);
+	m_stateExporter->EndWrite(m_stepIndex, std::min(total, capacity), total);
+}
+
+void EngineImpl::recordContact(const BodyPtr& body, const BodyPtr& collide)
+{
+	// Keep pair in order of ids, so it is the same whichever body found it
+	const bool ordered = body->GetId() < collide->GetId();
+	const BodyPtr& first = ordered ? body : collide;
+	const BodyPtr& second = ordered ? collide : body;
+
+	const Point position = first->GetPosition();
+	const fVec2D normal = Normalized(second->GetPosition() - position);
+
+	Contact contact;
+	contact.key = (static_cast<uint64_t>(first->GetId()) << 32) | second->GetId();
+	contact.sensor = first->IsSensor() || second->IsSensor();
+	contact.first_dynamic = first->GetBodyType() == IBody::BodyType::Dynamic;
+	contact.second_dynamic = second->GetBodyType() == IBody::BodyType::Dynamic;
+	contact.point = position + normal * first->GetRadius();
+	contact.normal = normal;
+	m_contacts.push_back(contact);
+
+	// Sensors may overlap as deep as they like
+	if (contact.sensor)
+		return;
+
+	const Scalar first_radius = first->GetRadius();
+	const Scalar second_radius = second->GetRadius();
+	const Scalar radius = std::min(first_radius, second_radius);
+	if (radius > Scalar(0))
+	{
+		const Scalar depth = first_radius + second_radius - EuclideanNorm(second->GetPosition() - position);
+		m_maxPenetration = std::max(m_maxPenetration, depth / radius);
+	}
+}
+
+void EngineImpl::collectContactEvents()
+{
+	m_contactEvents.clear();
+
+	// Pair none of which dynamic bodies was stepped was not tested, it keeps touching as before
+	if (!m_skippedIds.empty())
+	{
+		auto skipped = [this](BodyId id)
+		{
+			return std::binary_search(std::begin(m_skippedIds), std::end(m_skippedIds), id);
+		};
+
+		for (const auto& contact : m_prevContacts)
+			if ((!contact.first_dynamic || skipped(static_cast<BodyId>(contact.key >> 32))) &&
+				(!contact.second_dynamic || skipped(static_cast<BodyId>(contact.key))))
+				m_contacts.push_back(contact);
+	}
+
+	// Broad phase records a pair once: pair of dynamic bodies due now from the one of lower id,
+	// any other pair from its only dynamic body due now. Pairs kept above weren't tested on this
+	// step, so keys don't repeat, unique only guards that. Sorting lines them up with previous step.
+	auto less = [](const Contact& l, const Contact& r) { return l.key < r.key; };
+	auto same = [](const Contact& l, const Contact& r) { return l.key == r.key; };
+	std::sort(std::begin(m_contacts), std::end(m_contacts), less);
+	m_contacts.erase(std::unique(std::begin(m_contacts), std::end(m_contacts), same), std::end(m_contacts));
+
+	auto makeEvent = [](ContactEvent::Type type, const Contact& contact)
+	{
+		ContactEvent event;
+		event.type = type;
+		event.first = static_cast<BodyId>(contact.key >> 32);
+		event.second = static_cast<BodyId>(contact.key);
+		event.sensor = contact.sensor;
+		event.point = type == ContactEvent::Type::End ? Point{ 0, 0 } : contact.point;
+		event.normal = type == ContactEvent::Type::End ? fVec2D{ 0, 0 } : contact.normal;
+		return event;
+	};
+
+	// Merge sorted contacts of previous and current step
+	auto prev = std::begin(m_prevContacts);
+	auto curr = std::begin(m_contacts);
+	while (prev != std::end(m_prevContacts) || curr != std::end(m_contacts))
+	{
+		if (curr == std::end(m_contacts) || (prev != std::end(m_prevContacts) && prev->key < curr->key))
+			m_contactEvents.push_back(makeEvent(ContactEvent::Type::End, *prev++));
+		else if (prev == std::end(m_prevContacts) || curr->key < prev->key)
+			m_contactEvents.push_back(makeEvent(ContactEvent::Type::Begin, *curr++));
+		else
+		{
+			m_contactEvents.push_back(makeEvent(ContactEvent::Type::Persist, *curr++));
+			++prev;
+		}
+	}
+
+	std::swap(m_contacts, m_prevContacts);
+}
+
+void EngineImpl::rebuildTree()
+{
+	m_tree.clear();
+	for (const auto& body : m_bodies)
+		m_tree.insert(body);
+	for (const auto& body : m_kinematicBodies)
+		m_tree.insert(body);
+	m_tree.build();
+
+	m_treeDirty = false;
+	m_treeRevision = SumRevisions(m_bodies) + SumRevisions(m_kinematicBodies);
+}
+
+void EngineImpl::rebuildStaticTree()
+{
+	m_staticTree.clear();
+	for (const auto& body : m_staticBodies)
+		m_staticTree.insert(body);
+	m_staticTree.build();
+
+	m_staticTreeDirty = false;
+	m_staticTreeRevision = SumRevisions(m_staticBodies);
+}
+
+void EngineImpl::applyForceFields()
+{
+	// Forces are summed until body is stepped, so skipped bodies get them only on their step
+	m_fieldBodies.clear();
+	for (size_t i = 0; i < m_bodies.size(); ++i)
+		if (0 != m_bodyDt[i])
+			m_fieldBodies.push_back(i);
+
+	const size_t count = m_fieldBodies.size();
+
+	// Gather state of all bodies once for every field
+	m_fieldPositions.resize(count);
+	m_fieldVelocities.resize(count);
+	m_fieldMasses.resize(count);
+	m_fieldForces.assign(count, fVec2D{ 0, 0 });
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		const BodyPtr& body = m_bodies[m_fieldBodies[i]];
+		m_fieldPositions[i] = body->GetPosition();
+		m_fieldVelocities[i] = body->GetVelocityVector();
+		m_fieldMasses[i] = body->GetMass().mass;
+	}
+
+	const FieldBodies all = { m_fieldPositions.data(), m_fieldVelocities.data(), m_fieldMasses.data(), count };
+
+	// Local fields look up their bodies in tree, found bodies are matched to gathered state by id
+	m_fieldIndices.clear();
+	for (const auto& field : m_fields)
+	{
+		Point bot_left;
+		Point top_right;
+		if (!field->GetBounds(bot_left, top_right))
+		{
+			field->Evaluate(all, m_fieldForces.data());
+			continue;
+		}
+
+		if (m_fieldIndices.empty())
+			for (size_t i = 0; i < count; ++i)
+				m_fieldIndices.emplace(m_bodies[m_fieldBodies[i]]->GetId(), i);
+
+		// Local field, cull bodies outside of its bounds and pack the rest. Tree holds positions
+		// bodies had before collisions moved them, so it is searched as far around bounds.
+		m_localIndices.clear();
+		m_localPositions.clear();
+		m_localVelocities.clear();
+		m_localMasses.clear();
+
+		auto gather = [&](const ChunkTree<BodyPtr>::Entry& entry)
+		{
+			// Kinematic and skipped bodies take no forces on this step
+			const auto it = m_fieldIndices.find(entry.object->GetId());
+			if (it != m_fieldIndices.end() && IsPointInRect(m_fieldPositions[it->second], bot_left, top_right))
+			{
+				const size_t i = it->second;
+				m_localIndices.push_back(i);
+				m_localPositions.push_back(m_fieldPositions[i]);
+				m_localVelocities.push_back(m_fieldVelocities[i]);
+				m_localMasses.push_back(m_fieldMasses[i]);
+			}
+			return true;
+		};
+		m_tree.query(Point{ bot_left.x - m_indexShift, bot_left.y - m_indexShift },
+			Point{ top_right.x + m_indexShift, top_right.y + m_indexShift }, gather);
+
+		if (m_localIndices.empty())
+			continue;
+
+		m_localForces.assign(m_localIndices.size(), fVec2D{ 0, 0 });
+
+		const FieldBodies local = { m_localPositions.data(), m_localVelocities.data(), m_localMasses.data(), m_localIndices.size() };
+		field->Evaluate(local, m_localForces.data());
+
+		for (size_t i = 0; i < m_localIndices.size(); ++i)
+			m_fieldForces[m_localIndices[i]] += m_localForces[i];
 	}
+
+	for (size_t i = 0; i < count; ++i)
+		m_bodies[m_fieldBodies[i]]->ApplyForce(m_fieldForces[i]);
 }
 
 EngineImpl::EngineImpl()
 	: m_botLeft(kWorldBotLeft)
 	, m_topRight(kWorldTopRight)
+	, m_commands(kCommandQueueCapacity)
+	, m_workers(std::max(1u, std::thread::hardware_concurrency()))
 	, m_bodies()
-	, m_gravity(0, -kGravity)
+	, m_kinematicBodies()
+	, m_staticBodies()
+	, m_tree(kWorldChunkSize, &m_workers)
+	, m_treeDirty(false)
+	, m_treeRevision(0)
+	, m_staticTree(kWorldChunkSize)
+	, m_staticTreeDirty(false)
+	, m_staticTreeRevision(0)
+	, m_terrain(kTerrainCellSize)
+	, m_bodyLod()
+	, m_bodyDt()
+	, m_skippedIds()
+	, m_focusPoints()
+	, m_lodTiers()
+	, m_activityRegions()
+	, m_activityChanged(false)
+	, m_frozenChunks()
+	, m_streamedChunks()
+	, m_removedStreamed()
+	, m_retiredChunks()
+	, m_chunkFileCount(0)
+	, m_streamingDirectory()
+	, m_chunkListener(nullptr)
+	, m_contacts()
+	, m_prevContacts()
+	, m_contactEvents()
+	, m_contactListener(nullptr)
+	, m_maxPenetration(0)
+	, m_indexShift(0)
+	, m_minStep(0)
+	, m_maxStep(0)
+	, m_stepStats()
+	, m_stateExporter()
+	, m_stepIndex(0)
+	, m_checkpoints()
+	, m_checkpointCount(0)
+	, m_nextCheckpoint(0)
+	, m_membership()
+	, m_simulationThread()
+	, m_simulationRunning(false)
+	, m_frame()
+	, m_frameMutex()
+	, m_framePool(std::make_shared<FramePool>())
+	, m_stepThread()
+	, m_stepMutex()
+	, m_stepCondition()
+	, m_asyncSteps()
+	, m_stepThreadStopping(false)
+	, m_fields()
+	, m_gravityField(IForceField::CreateUniform(fVec2D{ 0, -kGravity }))
+	, m_airDragField(IForceField::CreateDrag(kAirDragFactor))
+	, m_joints(m_workers)
+	, m_particleSystems()
+	, m_gravity{ 0, -kGravity }
 	, m_airDrag(kAirDragFactor)
 	, m_groundFricion(kGroundFriction)
 {
+	m_fields.push_back(m_gravityField);
+	m_fields.push_back(m_airDragField);
 
+	m_contacts.reserve(kReservedContacts);
+	m_prevContacts.reserve(kReservedContacts);
+	m_contactEvents.reserve(kReservedContacts);
+}
+
+EngineImpl::~EngineImpl()
+{
+	StopSimulation();
+	stopStepThread();
+
+	// Files kept only for checkpoints go with them
+	m_checkpoints.clear();
+	deleteRetiredChunkFiles();
 }
 
 bool EngineImpl::checkCollision(const BodyPtr& body, const BodyPtr& collide) const
@@ -161,8 +711,7 @@ bool EngineImpl::checkCollision(const BodyPtr& body, const BodyPtr& collide) con
 	if (body == collide)
 		return false;
 
-	// Get size from body interface
-	static unsigned radius = 20;
+	const Scalar radius = body->GetRadius() + collide->GetRadius();
 	const fVec2D distance = collide->GetPosition() - body->GetPosition();
 	return (distance.x * distance.x) + (distance.y * distance.y) <= radius * radius;
 }
@@ -180,21 +729,29 @@ void EngineImpl::solveCollision(BodyPtr& body, BodyPtr& collide) const
 	const fVec2D collision_normal = Normalized(collision_vector);
 
 	const fVec2D relative_velocity = collide_velocity - velocity;
-	const double length_relative = DotProduct(relative_velocity, collision_normal);
+	const Scalar length_relative = DotProduct(relative_velocity, collision_normal);
 
 	// Objects moving in different directions, nothing to solve
-	if (length_relative > 0.f)
+	if (length_relative > Scalar(0))
 		return;
 
 	const Mass mass = body->GetMass();
 	const Mass collide_mass = collide->GetMass();
 
-	const double length_impulse = -(1.f + kBounceFactor) * length_relative / (mass.inv_mass + collide_mass.inv_mass);
+	// Both bodies have infinite mass, none of them can be moved
+	const Scalar inv_mass_sum = mass.inv_mass + collide_mass.inv_mass;
+	if (inv_mass_sum == Scalar(0))
+		return;
+
+	const Scalar length_impulse = -(Scalar(1) + kBounceFactor) * length_relative / inv_mass_sum;
 
 	const fVec2D impulse = length_impulse * collision_normal;
 
-	body->ApplyImpulse(-(impulse));
-	collide->ApplyImpulse(impulse);
+	// Static and kinematic bodies don't take impulses
+	if (mass.inv_mass != Scalar(0))
+		body->ApplyImpulse(-(impulse));
+	if (collide_mass.inv_mass != Scalar(0))
+		collide->ApplyImpulse(impulse);
 }
 
 Point EngineImpl::clipPointToWorldBorder(const Point& pos) const
@@ -207,8 +764,22 @@ Point EngineImpl::clipPointToWorldBorder(const Point& pos) const
 			 static_cast<Point::type>(m_topRight.y)) };
 }
 
-IEngine* IEngine::Instance()
+// Layout of every type using Scalar differs between engine and caller built with other Scalar
+static void CheckScalarKind(ScalarKind scalar)
 {
+	if (scalar != kScalarKind)
+		throw std::logic_error("engine is built with other Scalar type, see phys_config.h");
+}
+
+IEngine* IEngine::Instance(ScalarKind scalar)
+{
+	CheckScalarKind(scalar);
 	static EngineImpl _instance;
 	return &_instance;
-}
\ No newline at end of file
+}
+
+EnginePtr IEngine::Create(ScalarKind scalar)
+{
+	CheckScalarKind(scalar);
+	return std::make_shared<EngineImpl>();
+}
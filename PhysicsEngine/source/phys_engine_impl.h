@@ -0,0 +1,375 @@
+#ifndef PHYS_ENGINE_IMPL_H
+#define PHYS_ENGINE_IMPL_H
+
+#include <phys_engine.h>
+#include <phys_constants.h>
+#include <phys_chunktree.h>
+#include <phys_linear_quadtree.h>
+#include <phys_workers.h>
+#include "phys_command_queue.h"
+#include "phys_joint_solver.h"
+#include "phys_terrain_grid.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace physic
+{
+	class EngineImpl : public IEngine
+	{
+	public:
+		virtual void SetWorldBorders(
+			Point bot_left = kWorldBotLeft,
+			Point top_right = kWorldTopRight) override;
+
+		virtual void SetWorldConstants(
+			Scalar gravity = kGravity, 
+			Scalar air_density = kAirDragFactor, 
+			Scalar ground_friction = kGroundFriction) override;
+	
+		virtual void AddBody(BodyPtr&) override;
+		virtual void RemoveBody(const BodyPtr&) override;
+		virtual void ApplyForces(const BodyPtr* bodies, const fVec2D* forces, size_t count) override;
+
+		virtual void AddForceField(const ForceFieldPtr&) override;
+		virtual void RemoveForceField(const ForceFieldPtr&) override;
+
+		virtual TerrainId AddSegmentChain(const Point* points, size_t count, bool closed) override;
+		virtual TerrainId AddHeightfield(const Point& origin, Scalar spacing, const Scalar* heights, size_t count) override;
+		virtual bool RemoveTerrain(TerrainId) override;
+
+		virtual JointId AddJoint(const JointDef&) override;
+		virtual bool RemoveJoint(JointId) override;
+
+		virtual void AddParticleSystem(const ParticleSystemPtr&) override;
+		virtual void RemoveParticleSystem(const ParticleSystemPtr&) override;
+
+		virtual bool PushCommand(BodyCommand command) override;
+
+		virtual void Step(double dt) override;
+
+		virtual void SetAdaptiveStep(double min_dt, double max_dt) override;
+		virtual StepStats GetStepStats() const override;
+
+		virtual std::future<void> StepAsync(double dt) override;
+		virtual bool StepAsync(double dt, std::function<void()> done) override;
+
+		virtual void StartSimulation(double dt) override;
+		virtual void StopSimulation() override;
+		virtual FramePtr GetFrame() const override;
+
+		virtual void SetContactListener(IContactListener*) override;
+
+		virtual void SetActivityRegions(const ActivityRegion* regions, size_t count) override;
+		virtual void SetStreamingDirectory(const std::string& directory) override;
+		virtual void SetChunkListener(IChunkListener*) override;
+
+		virtual void SetFocusPoints(const Point* points, size_t count) override;
+		virtual void SetLodTiers(const LodTier* tiers, size_t count) override;
+
+		virtual uint64_t GetStepIndex() const override;
+		virtual void SetCheckpointCount(size_t count) override;
+		virtual bool Rewind(uint64_t step) override;
+
+		virtual void GetBodyStates(std::vector<BodyState>& states) const override;
+		virtual void SetStateExporter(const StateExporterPtr&) override;
+		virtual size_t ExportBodies(ExportedBody* bodies, size_t capacity) const override;
+
+		virtual bool Raycast(const Point& from, const Point& to, RaycastHit& hit) const override;
+		virtual void RaycastAll(const Point& from, const Point& to, IRaycastCallback&) const override;
+		virtual void RaycastBatch(const RaycastRequest* rays, RaycastHit* hits, size_t count) const override;
+
+		virtual void QueryRect(const Point& bot_left, const Point& top_right, IQueryCallback&) const override;
+		virtual void QueryCircle(const Point& center, Scalar radius, IQueryCallback&) const override;
+
+		virtual size_t QueryNearest(const Point& point, size_t k, NearestHit* hits) const override;
+
+		virtual size_t ExportBodiesInRect(const Point& bot_left, const Point& top_right,
+			ExportedBody* bodies, size_t capacity) const override;
+
+		EngineImpl();
+		virtual ~EngineImpl();
+
+		EngineImpl(const EngineImpl&) = delete;
+		EngineImpl& operator=(const EngineImpl&) = delete;
+		EngineImpl(EngineImpl&&) = delete;
+		EngineImpl& operator=(EngineImpl&&) = delete;
+
+	private:
+
+		//bool checkBodyOnBorder()
+		bool checkCollision(const BodyPtr&, const BodyPtr&) const;
+
+		void solveCollision(BodyPtr&, BodyPtr&) const;
+
+		Point clipPointToWorldBorder(const Point&) const;
+
+		void applyForceFields();
+		void updateParticles(Scalar dt);
+
+		void rebuildTree();
+		void rebuildStaticTree();
+
+		// Walk dynamic and static trees with same callbacks
+		template <class Accept, class Visit>
+		void traverseTrees(Accept& accept, Visit& visit) const
+		{
+			if (m_tree.traverse(accept, visit))
+				m_staticTree.traverse(accept, visit);
+		}
+
+		void applyCommands();
+
+		// Single step of dt, Step makes one or more of them
+		void stepOnce(double dt);
+		// Largest stable substep for current speeds and overlaps
+		double chooseSubstep();
+
+		// Rate of dynamic body, kept in order of m_bodies
+		struct BodyLod
+		{
+			uint32_t interval;
+			// Steps and time passed since body was stepped last time
+			uint32_t pending;
+			double elapsed;
+		};
+
+		// Pick bodies to step now and time they cover
+		void scheduleBodies(double dt);
+		// Choose interval of bodies stepped now by distance to focus points
+		void updateTiers();
+
+		// File of chunk on disk, it only grows until chunk is read back
+		struct StreamedChunk
+		{
+			std::string path;
+			uint64_t size;
+		};
+
+		// Freeze bodies which left active chunks, wake or stream in chunks which became active
+		void updateActivity();
+		bool isChunkActive(const ChunkCoord&) const;
+		bool freezeBodies(std::vector<BodyPtr>& bodies, std::vector<BodyLod>* lod = nullptr);
+		void wakeChunks();
+		void streamOutChunks();
+		// Size is the size of file after writing
+		bool writeChunk(const std::string& path, bool append, const std::vector<BodyPtr>& bodies, uint64_t& size) const;
+		// Returns false if file can't be opened, bodies before a truncated record are still read
+		bool readChunk(const std::string& path, std::vector<BodyPtr>& bodies, bool& truncated) const;
+		// Every file gets a new name, so files kept for checkpoints are never overwritten
+		std::string chunkFilePath(uint64_t key);
+		// Delete file read back or keep it while checkpoints may still need it
+		void retireChunkFile(uint64_t key, const std::string& path);
+		// Drop files no kept checkpoint needs
+		void deleteRetiredChunkFiles();
+		// Bring files of chunks back to what checkpoint of step has seen
+		void restoreChunkFiles(const std::unordered_map<uint64_t, StreamedChunk>& streamed, uint64_t step);
+
+		void publishState();
+		void publishFrame();
+		void runSteps();
+		void stopStepThread();
+		void simulate(double dt);
+		void saveCheckpoint();
+
+		void recordContact(const BodyPtr&, const BodyPtr&);
+		void collectContactEvents();
+
+		Point m_botLeft;
+		Point m_topRight;
+
+		// Written by any thread, drained by Step, preallocated so pushing never allocates
+		CommandQueue<BodyCommand> m_commands;
+
+		// Threads shared by parallel passes of step and by batched queries, which never overlap.
+		// Mutable for const queries, which therefore must not run concurrently with each other.
+		mutable Workers m_workers;
+
+		// Bodies are kept apart by type, static ones are never integrated
+		std::vector<BodyPtr> m_bodies;
+		std::vector<BodyPtr> m_kinematicBodies;
+		std::vector<BodyPtr> m_staticBodies;
+
+		// Spatial index of dynamic and kinematic bodies, used by broad phase and queries.
+		// Refilled every step, so it is sorted at once instead of split on every insertion.
+		ChunkTree<BodyPtr, LinearQuadTree<BodyPtr>> m_tree;
+		bool m_treeDirty;
+		// Sum of revisions of indexed bodies, entries keep position and filter of that moment
+		uint64_t m_treeRevision;
+
+		// Spatial index of static bodies, refilled only when they are added, removed or changed
+		ChunkTree<BodyPtr> m_staticTree;
+		bool m_staticTreeDirty;
+		uint64_t m_staticTreeRevision;
+
+		Terrain m_terrain;
+
+		std::vector<BodyLod> m_bodyLod;
+		// Time covered by each dynamic body on current step, zero for skipped ones
+		std::vector<double> m_bodyDt;
+		// Sorted ids of dynamic bodies skipped on current step
+		std::vector<BodyId> m_skippedIds;
+		std::vector<Point> m_focusPoints;
+		// Sorted by distance
+		std::vector<LodTier> m_lodTiers;
+
+		std::vector<ActivityRegion> m_activityRegions;
+		bool m_activityChanged;
+
+		// Bodies of frozen chunks by chunk key, kept in memory until streamed out
+		std::unordered_map<uint64_t, std::vector<BodyPtr>> m_frozenChunks;
+		// Files of chunks streamed out by chunk key
+		std::unordered_map<uint64_t, StreamedChunk> m_streamedChunks;
+		// Ids of bodies removed while their chunk was on disk, dropped when it is read back
+		std::unordered_set<BodyId> m_removedStreamed;
+		// Files read back while checkpoints are kept, with step they were read after
+		struct RetiredChunk
+		{
+			uint64_t key;
+			std::string path;
+			uint64_t step;
+		};
+		std::vector<RetiredChunk> m_retiredChunks;
+		uint64_t m_chunkFileCount;
+		std::string m_streamingDirectory;
+		IChunkListener* m_chunkListener;
+
+		// Touching pair of bodies found by narrow phase
+		struct Contact
+		{
+			// Lower id in high bits, pairs are sorted and compared by key
+			uint64_t key;
+			bool sensor;
+			// Pair is tested only from dynamic bodies
+			bool first_dynamic;
+			bool second_dynamic;
+			Point point;
+			fVec2D normal;
+		};
+
+		// Contacts of current and previous step, swapped every step
+		std::vector<Contact> m_contacts;
+		std::vector<Contact> m_prevContacts;
+		std::vector<ContactEvent> m_contactEvents;
+		IContactListener* m_contactListener;
+		// Deepest overlap of solid contacts of last step relative to the smaller radius
+		Scalar m_maxPenetration;
+		// Farthest a dynamic body was moved along either axis on current step after m_tree was filled,
+		// local fields search the tree that far around their bounds
+		Scalar m_indexShift;
+
+		// Zero max dt disables adaptive step
+		double m_minStep;
+		double m_maxStep;
+		StepStats m_stepStats;
+
+		StateExporterPtr m_stateExporter;
+		// Number of finished steps
+		uint64_t m_stepIndex;
+
+		// Set of bodies and joints shared by checkpoints until it is changed
+		struct Membership
+		{
+			std::vector<BodyPtr> bodies;
+			std::vector<BodyPtr> kinematic_bodies;
+			std::vector<BodyPtr> static_bodies;
+
+			// Frozen bodies don't move until they are woken, which changes membership,
+			// so their state is kept once, in order of the chunks of this copy
+			std::unordered_map<uint64_t, std::vector<BodyPtr>> frozen_chunks;
+			std::vector<Point> frozen_positions;
+			std::vector<fVec2D> frozen_velocities;
+			std::unordered_map<uint64_t, StreamedChunk> streamed_chunks;
+			std::unordered_set<BodyId> removed_streamed;
+
+			std::vector<JointSolver::Saved> joints;
+		};
+
+		// State after step, moving bodies are stored in order of membership
+		struct Checkpoint
+		{
+			uint64_t step;
+			std::shared_ptr<const Membership> membership;
+			std::vector<Point> positions;
+			std::vector<fVec2D> velocities;
+			// Forces and impulses summed by dynamic bodies skipped by LOD
+			std::vector<fVec2D> forces;
+			std::vector<fVec2D> impulses;
+			std::vector<BodyLod> lod;
+			std::vector<Contact> contacts;
+		};
+
+		// Ring of checkpoints, buffers of overwritten ones are reused
+		std::vector<Checkpoint> m_checkpoints;
+		size_t m_checkpointCount;
+		size_t m_nextCheckpoint;
+		// Current set of bodies, reset whenever it changes
+		std::shared_ptr<const Membership> m_membership;
+
+		std::thread m_simulationThread;
+		std::atomic<bool> m_simulationRunning;
+		// Readers copy the published frame under the mutex and keep it alive as long as they like
+		FramePtr m_frame;
+		mutable std::mutex m_frameMutex;
+		// Frames released by the last reader come back here to be refilled. Pool is shared with
+		// deleters of published frames, so frames may outlive the engine.
+		struct FramePool
+		{
+			std::mutex mutex;
+			std::vector<std::unique_ptr<Frame>> frames;
+		};
+		std::shared_ptr<FramePool> m_framePool;
+
+		// Step requested by StepAsync
+		struct AsyncStep
+		{
+			double dt;
+			std::function<void()> done;
+		};
+
+		// Worker of StepAsync, started by the first call
+		std::thread m_stepThread;
+		std::mutex m_stepMutex;
+		std::condition_variable m_stepCondition;
+		std::deque<AsyncStep> m_asyncSteps;
+		bool m_stepThreadStopping;
+
+		std::vector<ForceFieldPtr> m_fields;
+		ForceFieldPtr m_gravityField;
+		ForceFieldPtr m_airDragField;
+
+		JointSolver m_joints;
+
+		std::vector<ParticleSystemPtr> m_particleSystems;
+
+		fVec2D m_gravity;
+		Scalar m_airDrag;
+		Scalar m_groundFricion;
+
+		// Scratch buffers of force fields evaluation, reused between steps
+		std::vector<size_t> m_fieldBodies;
+		std::vector<Point> m_fieldPositions;
+		std::vector<fVec2D> m_fieldVelocities;
+		std::vector<Scalar> m_fieldMasses;
+		std::vector<fVec2D> m_fieldForces;
+
+		// Index of gathered state by body id, filled on steps with local fields
+		std::unordered_map<BodyId, size_t> m_fieldIndices;
+		std::vector<size_t> m_localIndices;
+		std::vector<Point> m_localPositions;
+		std::vector<fVec2D> m_localVelocities;
+		std::vector<Scalar> m_localMasses;
+		std::vector<fVec2D> m_localForces;
+	};
+} // namespace physic
+
+#endif // PHYS_ENGINE_IMPL_H
\ No newline at end of file
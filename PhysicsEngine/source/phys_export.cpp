@@ -0,0 +1,348 @@
+#include <phys_export.h>
+
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <new>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace physic;
+
+namespace
+{
+	static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+		"Atomics in shared memory must be lock free");
+
+	const uint32_t kMagic = 0x54535950; // "PYST"
+	const uint32_t kSlotCount = 3;
+	const uint32_t kNoSlot = UINT32_MAX;
+
+	// Readers give up after this number of snapshots overwritten under them
+	const int kMaxReadRetries = 16;
+
+	// Region starts with header followed by kSlotCount slots of slot_size bytes
+	struct alignas(64) SharedHeader
+	{
+		uint32_t magic;
+		uint32_t body_size;
+		uint64_t capacity;
+		uint64_t slot_size;
+		// Index of last published slot
+		std::atomic<uint32_t> latest;
+	};
+
+	struct alignas(64) SharedSlot
+	{
+		// Odd while slot is written
+		std::atomic<uint64_t> sequence;
+		uint64_t step;
+		uint64_t count;
+		uint64_t total;
+	};
+
+	size_t slotSize(size_t capacity)
+	{
+		const size_t size = sizeof(SharedSlot) + capacity * sizeof(ExportedBody);
+		return (size + alignof(SharedSlot) - 1) / alignof(SharedSlot) * alignof(SharedSlot);
+	}
+
+	// Named shared memory mapped into process
+	class SharedMemory
+	{
+	public:
+		SharedMemory() : m_data(nullptr), m_size(0), m_owner(false)
+#ifdef _WIN32
+			, m_handle(nullptr)
+#endif
+		{
+		}
+
+		~SharedMemory()
+		{
+#ifdef _WIN32
+			if (nullptr != m_data)
+				::UnmapViewOfFile(m_data);
+			if (nullptr != m_handle)
+				::CloseHandle(m_handle);
+#else
+			if (nullptr != m_data)
+				::munmap(m_data, m_size);
+			if (m_owner)
+				::shm_unlink(m_name.c_str());
+#endif
+		}
+
+		SharedMemory(const SharedMemory&) = delete;
+		SharedMemory& operator=(const SharedMemory&) = delete;
+
+		bool create(const std::string& name, size_t size)
+		{
+			m_name = objectName(name);
+			m_size = size;
+			m_owner = true;
+#ifdef _WIN32
+			m_handle = ::CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+				static_cast<DWORD>(static_cast<uint64_t>(size) >> 32), static_cast<DWORD>(size), m_name.c_str());
+			if (nullptr == m_handle)
+				return false;
+
+			m_data = ::MapViewOfFile(m_handle, FILE_MAP_ALL_ACCESS, 0, 0, size);
+			return nullptr != m_data;
+#else
+			// Stale region of crashed writer is replaced
+			::shm_unlink(m_name.c_str());
+			const int fd = ::shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+			if (fd < 0)
+				return false;
+
+			const bool sized = ::ftruncate(fd, static_cast<off_t>(size)) == 0;
+			void* data = sized ? ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+			::close(fd);
+
+			m_data = data != MAP_FAILED ? data : nullptr;
+			return nullptr != m_data;
+#endif
+		}
+
+		bool open(const std::string& name)
+		{
+			m_name = objectName(name);
+			m_owner = false;
+#ifdef _WIN32
+			m_handle = ::OpenFileMappingA(FILE_MAP_READ, FALSE, m_name.c_str());
+			if (nullptr == m_handle)
+				return false;
+
+			m_data = ::MapViewOfFile(m_handle, FILE_MAP_READ, 0, 0, 0);
+			if (nullptr == m_data)
+				return false;
+
+			MEMORY_BASIC_INFORMATION info;
+			if (0 == ::VirtualQuery(m_data, &info, sizeof(info)))
+				return false;
+			m_size = info.RegionSize;
+			return true;
+#else
+			const int fd = ::shm_open(m_name.c_str(), O_RDONLY, 0);
+			if (fd < 0)
+				return false;
+
+			struct stat info;
+			const bool sized = ::fstat(fd, &info) == 0 && info.st_size > 0;
+			m_size = sized ? static_cast<size_t>(info.st_size) : 0;
+			void* data = sized ? ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+			::close(fd);
+
+			m_data = data != MAP_FAILED ? data : nullptr;
+			return nullptr != m_data;
+#endif
+		}
+
+		uint8_t* data() const
+		{
+			return static_cast<uint8_t*>(m_data);
+		}
+
+		size_t size() const
+		{
+			return m_size;
+		}
+
+	private:
+		static std::string objectName(const std::string& name)
+		{
+#ifdef _WIN32
+			return "Local\\" + name;
+#else
+			return "/" + name;
+#endif
+		}
+
+		std::string m_name;
+		void* m_data;
+		size_t m_size;
+		bool m_owner;
+#ifdef _WIN32
+		HANDLE m_handle;
+#endif
+	};
+
+	class SharedStateExporter : public IStateExporter
+	{
+	public:
+		SharedStateExporter() : m_header(nullptr), m_writeSlot(kNoSlot), m_writeSequence(0) {}
+
+		bool create(const std::string& name, size_t capacity)
+		{
+			if (!m_memory.create(name, sizeof(SharedHeader) + kSlotCount * slotSize(capacity)))
+				return false;
+
+			m_header = new (m_memory.data()) SharedHeader();
+			m_header->magic = kMagic;
+			m_header->body_size = sizeof(ExportedBody);
+			m_header->capacity = capacity;
+			m_header->slot_size = slotSize(capacity);
+			m_header->latest.store(kNoSlot, std::memory_order_release);
+
+			for (uint32_t i = 0; i < kSlotCount; ++i)
+				new (slot(i)) SharedSlot();
+			return true;
+		}
+
+		virtual ExportedBody* BeginWrite(size_t& capacity) override
+		{
+			assert(kNoSlot == m_writeSlot);
+
+			// Slot after the latest one was published the longest time ago,
+			// readers of the latest snapshot have a whole step to finish
+			const uint32_t latest = m_header->latest.load(std::memory_order_relaxed);
+			m_writeSlot = kNoSlot == latest ? 0 : (latest + 1) % kSlotCount;
+
+			SharedSlot* target = slot(m_writeSlot);
+			m_writeSequence = target->sequence.load(std::memory_order_relaxed) + 1;
+			target->sequence.store(m_writeSequence, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+
+			capacity = static_cast<size_t>(m_header->capacity);
+			return bodies(target);
+		}
+
+		virtual void EndWrite(uint64_t step, size_t count, size_t total) override
+		{
+			assert(kNoSlot != m_writeSlot);
+			assert(count <= m_header->capacity);
+
+			SharedSlot* target = slot(m_writeSlot);
+			target->step = step;
+			target->count = count;
+			target->total = total;
+			target->sequence.store(m_writeSequence + 1, std::memory_order_release);
+
+			m_header->latest.store(m_writeSlot, std::memory_order_release);
+			m_writeSlot = kNoSlot;
+		}
+
+	private:
+		SharedSlot* slot(uint32_t index) const
+		{
+			return reinterpret_cast<SharedSlot*>(m_memory.data() + sizeof(SharedHeader) + index * m_header->slot_size);
+		}
+
+		static ExportedBody* bodies(SharedSlot* target)
+		{
+			return reinterpret_cast<ExportedBody*>(reinterpret_cast<uint8_t*>(target) + sizeof(SharedSlot));
+		}
+
+		SharedMemory m_memory;
+		SharedHeader* m_header;
+		uint32_t m_writeSlot;
+		uint64_t m_writeSequence;
+	};
+
+	class SharedStateReader : public IStateReader
+	{
+	public:
+		SharedStateReader() : m_header(nullptr) {}
+
+		bool open(const std::string& name)
+		{
+			if (!m_memory.open(name) || m_memory.size() < sizeof(SharedHeader))
+				return false;
+
+			m_header = reinterpret_cast<const SharedHeader*>(m_memory.data());
+			return m_header->magic == kMagic && m_header->body_size == sizeof(ExportedBody) &&
+				m_header->slot_size == slotSize(static_cast<size_t>(m_header->capacity)) &&
+				m_memory.size() >= sizeof(SharedHeader) + kSlotCount * m_header->slot_size;
+		}
+
+		virtual bool Acquire(StateView& view) const override
+		{
+			for (int attempt = 0; attempt < kMaxReadRetries; ++attempt)
+			{
+				const uint32_t latest = m_header->latest.load(std::memory_order_acquire);
+				if (kNoSlot == latest)
+					return false;
+
+				const SharedSlot* source = slot(latest);
+				const uint64_t sequence = source->sequence.load(std::memory_order_acquire);
+				if (sequence & 1)
+					continue;
+
+				view.step = source->step;
+				view.bodies = reinterpret_cast<const ExportedBody*>(reinterpret_cast<const uint8_t*>(source) + sizeof(SharedSlot));
+				view.count = static_cast<size_t>(source->count);
+				view.total = static_cast<size_t>(source->total);
+				view.sequence = sequence;
+				view.slot = latest;
+
+				if (Validate(view))
+					return true;
+			}
+
+			return false;
+		}
+
+		virtual bool Validate(const StateView& view) const override
+		{
+			std::atomic_thread_fence(std::memory_order_acquire);
+			return slot(view.slot)->sequence.load(std::memory_order_relaxed) == view.sequence;
+		}
+
+		virtual bool Read(std::vector<ExportedBody>& bodies, uint64_t& step) const override
+		{
+			for (int attempt = 0; attempt < kMaxReadRetries; ++attempt)
+			{
+				StateView view;
+				if (!Acquire(view))
+					return false;
+
+				bodies.resize(view.count);
+				if (view.count > 0)
+					std::memcpy(bodies.data(), view.bodies, view.count * sizeof(ExportedBody));
+
+				if (Validate(view))
+				{
+					step = view.step;
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+	private:
+		const SharedSlot* slot(uint32_t index) const
+		{
+			return reinterpret_cast<const SharedSlot*>(m_memory.data() + sizeof(SharedHeader) + index * m_header->slot_size);
+		}
+
+		SharedMemory m_memory;
+		const SharedHeader* m_header;
+	};
+}
+
+StateExporterPtr IStateExporter::Create(const std::string& name, size_t capacity)
+{
+	auto exporter = std::make_shared<SharedStateExporter>();
+	if (!exporter->create(name, capacity))
+		return nullptr;
+	return exporter;
+}
+
+StateReaderPtr IStateReader::Open(const std::string& name)
+{
+	auto reader = std::make_shared<SharedStateReader>();
+	if (!reader->open(name))
+		return nullptr;
+	return reader;
+}
@@ -0,0 +1,191 @@
+#include <phys_forcefield.h>
+
+#include <algorithm>
+
+using namespace physic;
+
+class UniformField : public IForceField
+{
+public:
+	explicit UniformField(const fVec2D& acceleration) : m_acceleration(acceleration) {}
+
+	virtual bool GetBounds(Point&, Point&) const override
+	{
+		return false;
+	}
+
+	virtual void Evaluate(const FieldBodies& bodies, fVec2D* forces) const override
+	{
+		for (size_t i = 0; i < bodies.count; ++i)
+		{
+			forces[i].x += m_acceleration.x * bodies.masses[i];
+			forces[i].y += m_acceleration.y * bodies.masses[i];
+		}
+	}
+
+private:
+	fVec2D m_acceleration;
+};
+
+class DragField : public IForceField
+{
+public:
+	explicit DragField(Scalar factor) : m_factor(factor) {}
+
+	virtual bool GetBounds(Point&, Point&) const override
+	{
+		return false;
+	}
+
+	virtual void Evaluate(const FieldBodies& bodies, fVec2D* forces) const override
+	{
+		for (size_t i = 0; i < bodies.count; ++i)
+		{
+			forces[i].x -= m_factor * bodies.velocities[i].x;
+			forces[i].y -= m_factor * bodies.velocities[i].y;
+		}
+	}
+
+private:
+	Scalar m_factor;
+};
+
+class WindField : public IForceField
+{
+public:
+	WindField(const Point& bot_left, const Point& top_right, const fVec2D& velocity, Scalar factor)
+		: m_botLeft(bot_left)
+		, m_topRight(top_right)
+		, m_velocity(velocity)
+		, m_factor(factor)
+	{}
+
+	virtual bool GetBounds(Point& bot_left, Point& top_right) const override
+	{
+		bot_left = m_botLeft;
+		top_right = m_topRight;
+		return true;
+	}
+
+	virtual void Evaluate(const FieldBodies& bodies, fVec2D* forces) const override
+	{
+		for (size_t i = 0; i < bodies.count; ++i)
+		{
+			forces[i].x += m_factor * (m_velocity.x - bodies.velocities[i].x);
+			forces[i].y += m_factor * (m_velocity.y - bodies.velocities[i].y);
+		}
+	}
+
+private:
+	Point m_botLeft;
+	Point m_topRight;
+	fVec2D m_velocity;
+	Scalar m_factor;
+};
+
+class RadialField : public IForceField
+{
+public:
+	RadialField(const Point& center, Scalar radius, Scalar strength)
+		: m_center(center)
+		, m_radius(radius)
+		, m_strength(strength)
+	{
+		assert(m_radius > Scalar(0));
+	}
+
+	virtual bool GetBounds(Point& bot_left, Point& top_right) const override
+	{
+		bot_left = Point{ m_center.x - m_radius, m_center.y - m_radius };
+		top_right = Point{ m_center.x + m_radius, m_center.y + m_radius };
+		return true;
+	}
+
+	virtual void Evaluate(const FieldBodies& bodies, fVec2D* forces) const override
+	{
+		const Scalar inv_radius = Scalar(1) / m_radius;
+		for (size_t i = 0; i < bodies.count; ++i)
+		{
+			const Scalar dx = m_center.x - bodies.positions[i].x;
+			const Scalar dy = m_center.y - bodies.positions[i].y;
+			const Scalar distance = sqrt(dx * dx + dy * dy);
+
+			// Linear falloff, zero outside of radius and in the very center
+			const Scalar falloff = std::max(Scalar(0), Scalar(1) - distance * inv_radius);
+			const Scalar scale = distance > Scalar(0) ? m_strength * bodies.masses[i] * falloff / distance : Scalar(0);
+
+			forces[i].x += dx * scale;
+			forces[i].y += dy * scale;
+		}
+	}
+
+private:
+	Point m_center;
+	Scalar m_radius;
+	Scalar m_strength;
+};
+
+class SpringField : public IForceField
+{
+public:
+	SpringField(const Point& anchor, Scalar radius, Scalar stiffness, Scalar damping)
+		: m_anchor(anchor)
+		, m_radius(radius)
+		, m_stiffness(stiffness)
+		, m_damping(damping)
+	{
+		assert(m_radius > Scalar(0));
+	}
+
+	virtual bool GetBounds(Point& bot_left, Point& top_right) const override
+	{
+		bot_left = Point{ m_anchor.x - m_radius, m_anchor.y - m_radius };
+		top_right = Point{ m_anchor.x + m_radius, m_anchor.y + m_radius };
+		return true;
+	}
+
+	virtual void Evaluate(const FieldBodies& bodies, fVec2D* forces) const override
+	{
+		const Scalar radius_sq = m_radius * m_radius;
+		for (size_t i = 0; i < bodies.count; ++i)
+		{
+			const Scalar dx = m_anchor.x - bodies.positions[i].x;
+			const Scalar dy = m_anchor.y - bodies.positions[i].y;
+			const Scalar inside = dx * dx + dy * dy <= radius_sq ? Scalar(1) : Scalar(0);
+
+			forces[i].x += inside * (m_stiffness * dx - m_damping * bodies.velocities[i].x);
+			forces[i].y += inside * (m_stiffness * dy - m_damping * bodies.velocities[i].y);
+		}
+	}
+
+private:
+	Point m_anchor;
+	Scalar m_radius;
+	Scalar m_stiffness;
+	Scalar m_damping;
+};
+
+ForceFieldPtr IForceField::CreateUniform(const fVec2D& acceleration)
+{
+	return std::make_shared<UniformField>(acceleration);
+}
+
+ForceFieldPtr IForceField::CreateDrag(Scalar factor)
+{
+	return std::make_shared<DragField>(factor);
+}
+
+ForceFieldPtr IForceField::CreateWind(const Point& bot_left, const Point& top_right, const fVec2D& velocity, Scalar factor)
+{
+	return std::make_shared<WindField>(bot_left, top_right, velocity, factor);
+}
+
+ForceFieldPtr IForceField::CreateRadial(const Point& center, Scalar radius, Scalar strength)
+{
+	return std::make_shared<RadialField>(center, radius, strength);
+}
+
+ForceFieldPtr IForceField::CreateSpring(const Point& anchor, Scalar radius, Scalar stiffness, Scalar damping)
+{
+	return std::make_shared<SpringField>(anchor, radius, stiffness, damping);
+}
\ No newline at end of file
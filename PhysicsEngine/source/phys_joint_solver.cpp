@@ -0,0 +1,526 @@
+#include "phys_joint_solver.h"
+
+#include <phys_workers.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <numeric>
+#include <thread>
+
+using namespace physic;
+
+namespace
+{
+	// Passes over all batches every step, more passes make long chains stiffer
+	const int kJointIterations = 8;
+	// Part of distance error corrected on every step
+	const Scalar kJointBaumgarte = Scalar(0.2);
+	// Passes over all batches moving bodies after the step
+	const int kJointPositionIterations = 4;
+	// Bodies of a slot are tracked by bit mask, the rest of joints share the last batch
+	const size_t kMaxJointBatches = 64;
+	// Don't wake up worker threads for less joints than this
+	const size_t kMinJointsPerThread = 2048;
+
+	// Threads wait for each other between batches. Batches are short,
+	// so waiting threads spin instead of sleeping on a condition variable.
+	class SpinBarrier
+	{
+	public:
+		explicit SpinBarrier(size_t threads)
+			: m_threads(threads)
+			, m_waiting(0)
+			, m_generation(0)
+		{
+		}
+
+		void wait()
+		{
+			const size_t generation = m_generation.load(std::memory_order_acquire);
+			if (m_waiting.fetch_add(1, std::memory_order_acq_rel) + 1 == m_threads)
+			{
+				m_waiting.store(0, std::memory_order_relaxed);
+				m_generation.fetch_add(1, std::memory_order_release);
+				return;
+			}
+
+			while (m_generation.load(std::memory_order_acquire) == generation)
+				std::this_thread::yield();
+		}
+
+	private:
+		const size_t m_threads;
+		std::atomic<size_t> m_waiting;
+		std::atomic<size_t> m_generation;
+	};
+} // namespace
+
+JointSolver::JointSolver(Workers& workers)
+	: m_nextId(0)
+	, m_batchesDirty(false)
+	, m_lastBatchShared(false)
+	, m_workers(workers)
+{
+}
+
+JointSolver::~JointSolver() = default;
+
+JointId JointSolver::add(const JointDef& def)
+{
+	assert(nullptr != def.first);
+	assert(nullptr != def.second);
+	assert(def.first != def.second);
+	assert(def.type != JointDef::Type::Spring || def.stiffness > Scalar(0));
+
+	const JointId id = m_nextId++;
+	insert(id, def);
+	return id;
+}
+
+bool JointSolver::remove(JointId id)
+{
+	auto found = m_indices.find(id);
+	if (found == std::end(m_indices))
+		return false;
+
+	removeAt(found->second);
+	return true;
+}
+
+void JointSolver::save(std::vector<Saved>& joints) const
+{
+	joints.clear();
+	joints.reserve(m_ids.size());
+	for (size_t i = 0; i < m_ids.size(); ++i)
+	{
+		const JointDef def = { m_types[i], m_bodies[m_first[i]], m_bodies[m_second[i]], m_length[i], m_stiffness[i], m_damping[i] };
+		joints.push_back({ m_ids[i], def, 0 != m_bodyActive[m_first[i]], 0 != m_bodyActive[m_second[i]] });
+	}
+}
+
+void JointSolver::restore(const std::vector<Saved>& joints)
+{
+	while (!m_ids.empty())
+		removeAt(m_ids.size() - 1);
+
+	// Ids given since the joints were saved are never given again
+	for (const auto& joint : joints)
+	{
+		insert(joint.id, joint.def);
+		m_nextId = std::max(m_nextId, joint.id + 1);
+		if (!joint.first_active)
+			m_bodyActive[m_first.back()] = 0;
+		if (!joint.second_active)
+			m_bodyActive[m_second.back()] = 0;
+	}
+}
+
+void JointSolver::insert(JointId id, const JointDef& def)
+{
+	m_indices[id] = m_ids.size();
+
+	m_ids.push_back(id);
+	m_types.push_back(def.type);
+	m_first.push_back(acquireSlot(def.first));
+	m_second.push_back(acquireSlot(def.second));
+	m_length.push_back(def.length);
+	m_stiffness.push_back(def.stiffness);
+	m_damping.push_back(def.damping);
+
+	m_batchesDirty = true;
+}
+
+void JointSolver::removeBody(const BodyPtr& body)
+{
+	auto found = m_slots.find(body->GetId());
+	if (found == std::end(m_slots))
+		return;
+
+	const uint32_t slot = found->second;
+	for (size_t i = 0; i < m_ids.size();)
+	{
+		if (m_first[i] == slot || m_second[i] == slot)
+			removeAt(i);
+		else
+			++i;
+	}
+}
+
+void JointSolver::freezeBody(const BodyPtr& body)
+{
+	auto found = m_slots.find(body->GetId());
+	if (found != std::end(m_slots))
+		m_bodyActive[found->second] = 0;
+}
+
+void JointSolver::rebindBody(const BodyPtr& body)
+{
+	auto found = m_slots.find(body->GetId());
+	if (found == std::end(m_slots))
+		return;
+
+	m_bodies[found->second] = body;
+	m_bodyActive[found->second] = 1;
+}
+
+void JointSolver::solve(Scalar dt, const std::vector<BodyId>& skipped)
+{
+	if (m_ids.empty() || dt <= Scalar(0))
+		return;
+
+	if (m_batchesDirty)
+		rebuildBatches();
+
+	gatherBodies(skipped);
+
+	const size_t count = m_ids.size();
+	m_normalX.resize(count);
+	m_normalY.resize(count);
+	m_bias.resize(count);
+	m_gamma.resize(count);
+	m_effectiveMass.resize(count);
+	m_impulse.assign(count, Scalar(0));
+
+	// Axis and error of every joint stay the same for all iterations
+	for (size_t i = 0; i < count; ++i)
+	{
+		const uint32_t a = m_first[i];
+		const uint32_t b = m_second[i];
+
+		const fVec2D axis{ m_positionX[b] - m_positionX[a], m_positionY[b] - m_positionY[a] };
+		const fVec2D normal = Normalized(axis);
+		const Scalar error = EuclideanNorm(axis) - m_length[i];
+		const Scalar inv_mass_sum = m_invMass[a] + m_invMass[b];
+
+		m_normalX[i] = normal.x;
+		m_normalY[i] = normal.y;
+
+		Scalar gamma = Scalar(0);
+		Scalar bias = kJointBaumgarte * error / dt;
+		switch (m_types[i])
+		{
+		case JointDef::Type::Spring:
+		{
+			// Soft constraint, same as implicit spring integrated over dt
+			const Scalar softness = dt * (m_damping[i] + dt * m_stiffness[i]);
+			gamma = softness > Scalar(0) ? Scalar(1) / softness : Scalar(0);
+			bias = error * dt * m_stiffness[i] * gamma;
+			break;
+		}
+		case JointDef::Type::Rope:
+			// Slack rope lets bodies approach until it is straight
+			if (error < Scalar(0))
+				bias = error / dt;
+			break;
+		default:
+			break;
+		}
+
+		const Scalar denominator = inv_mass_sum + gamma;
+		m_gamma[i] = gamma;
+		m_bias[i] = bias;
+		// Joint between two bodies of infinite mass does nothing
+		m_effectiveMass[i] = inv_mass_sum > Scalar(0) ? Scalar(1) / denominator : Scalar(0);
+	}
+
+	runBatches(kJointIterations, [this](size_t begin, size_t end) { solveRange(begin, end); });
+
+	// Bodies of infinite mass keep their velocity
+	for (size_t s = 0; s < m_bodies.size(); ++s)
+		if (nullptr != m_bodies[s] && m_invMass[s] != Scalar(0))
+			m_bodies[s]->SetVelocityVector(fVec2D{ m_velocityX[s], m_velocityY[s] });
+}
+
+void JointSolver::correct(const std::vector<BodyId>& skipped)
+{
+	if (m_ids.empty())
+		return;
+
+	if (m_batchesDirty)
+		rebuildBatches();
+
+	gatherBodies(skipped);
+
+	runBatches(kJointPositionIterations, [this](size_t begin, size_t end) { correctRange(begin, end); });
+
+	for (size_t s = 0; s < m_bodies.size(); ++s)
+		if (nullptr != m_bodies[s] && m_invMass[s] != Scalar(0))
+			m_bodies[s]->SetPosition(Point{ m_positionX[s], m_positionY[s] });
+}
+
+void JointSolver::gatherBodies(const std::vector<BodyId>& skipped)
+{
+	const size_t slots = m_bodies.size();
+	m_positionX.resize(slots);
+	m_positionY.resize(slots);
+	m_velocityX.resize(slots);
+	m_velocityY.resize(slots);
+	m_invMass.resize(slots);
+
+	for (size_t s = 0; s < slots; ++s)
+	{
+		const BodyPtr& body = m_bodies[s];
+		if (nullptr == body)
+			continue;
+
+		const Point position = body->GetPosition();
+		const fVec2D velocity = body->GetVelocityVector();
+		m_positionX[s] = position.x;
+		m_positionY[s] = position.y;
+		m_velocityX[s] = velocity.x;
+		m_velocityY[s] = velocity.y;
+		// Body not due on this step or out of active chunks is held like a body of infinite mass,
+		// write-back skips bodies of infinite mass
+		const bool held = 0 == m_bodyActive[s] ||
+			std::binary_search(std::begin(skipped), std::end(skipped), body->GetId());
+		m_invMass[s] = held ? Scalar(0) : body->GetMass().inv_mass;
+	}
+}
+
+template <class Pass>
+void JointSolver::runBatches(int iterations, const Pass& pass)
+{
+	// Joints of batch share no moving body, so every batch is split between threads
+	// and threads meet before the next batch
+	size_t largest_batch = 0;
+	for (size_t b = 0, begin = 0; b < m_batchEnds.size(); begin = m_batchEnds[b++])
+		largest_batch = std::max(largest_batch, m_batchEnds[b] - begin);
+
+	const size_t threads = std::min(m_workers.size(), largest_batch / kMinJointsPerThread);
+
+	// Small batches are solved inline
+	if (threads <= 1)
+	{
+		for (int iteration = 0; iteration < iterations; ++iteration)
+			for (size_t b = 0, begin = 0; b < m_batchEnds.size(); begin = m_batchEnds[b++])
+				pass(begin, m_batchEnds[b]);
+		return;
+	}
+
+	SpinBarrier barrier(threads);
+	const size_t last_batch = m_batchEnds.size() - 1;
+
+	auto work = [this, &barrier, &pass, iterations, threads, last_batch](size_t thread)
+	{
+		for (int iteration = 0; iteration < iterations; ++iteration)
+		{
+			for (size_t b = 0, begin = 0; b < m_batchEnds.size(); begin = m_batchEnds[b++])
+			{
+				const size_t end = m_batchEnds[b];
+				if (b == last_batch && m_lastBatchShared)
+				{
+					// Joints of shared batch may touch the same body
+					if (0 == thread)
+						pass(begin, end);
+				}
+				else
+				{
+					const size_t per_thread = (end - begin + threads - 1) / threads;
+					pass(std::min(end, begin + thread * per_thread),
+						std::min(end, begin + (thread + 1) * per_thread));
+				}
+				barrier.wait();
+			}
+		}
+	};
+
+	// Calling thread takes the first part
+	m_workers.run(threads, work);
+}
+
+void JointSolver::solveRange(size_t begin, size_t end)
+{
+	for (size_t i = begin; i < end; ++i)
+	{
+		const uint32_t a = m_first[i];
+		const uint32_t b = m_second[i];
+
+		const Scalar speed = m_normalX[i] * (m_velocityX[b] - m_velocityX[a]) +
+			m_normalY[i] * (m_velocityY[b] - m_velocityY[a]);
+
+		Scalar lambda = -m_effectiveMass[i] * (speed + m_bias[i] + m_gamma[i] * m_impulse[i]);
+
+		// Rope only pulls bodies together
+		Scalar impulse = m_impulse[i] + lambda;
+		if (m_types[i] == JointDef::Type::Rope && impulse > Scalar(0))
+			impulse = Scalar(0);
+		lambda = impulse - m_impulse[i];
+		m_impulse[i] = impulse;
+
+		const Scalar impulse_x = lambda * m_normalX[i];
+		const Scalar impulse_y = lambda * m_normalY[i];
+		m_velocityX[a] -= m_invMass[a] * impulse_x;
+		m_velocityY[a] -= m_invMass[a] * impulse_y;
+		m_velocityX[b] += m_invMass[b] * impulse_x;
+		m_velocityY[b] += m_invMass[b] * impulse_y;
+	}
+}
+
+void JointSolver::correctRange(size_t begin, size_t end)
+{
+	for (size_t i = begin; i < end; ++i)
+	{
+		// Springs are soft by design, slack ropes hold nothing
+		if (m_types[i] == JointDef::Type::Spring)
+			continue;
+
+		const uint32_t a = m_first[i];
+		const uint32_t b = m_second[i];
+		const Scalar inv_mass_sum = m_invMass[a] + m_invMass[b];
+		if (inv_mass_sum <= Scalar(0))
+			continue;
+
+		const fVec2D axis{ m_positionX[b] - m_positionX[a], m_positionY[b] - m_positionY[a] };
+		const Scalar distance = EuclideanNorm(axis);
+		const Scalar error = distance - m_length[i];
+		if (distance <= Scalar(0) || (m_types[i] == JointDef::Type::Rope && error <= Scalar(0)))
+			continue;
+
+		// Bodies move along joint in inverse proportion to their masses
+		const Scalar shift = error / (distance * inv_mass_sum);
+		const Scalar shift_x = shift * axis.x;
+		const Scalar shift_y = shift * axis.y;
+		m_positionX[a] += m_invMass[a] * shift_x;
+		m_positionY[a] += m_invMass[a] * shift_y;
+		m_positionX[b] -= m_invMass[b] * shift_x;
+		m_positionY[b] -= m_invMass[b] * shift_y;
+	}
+}
+
+uint32_t JointSolver::acquireSlot(const BodyPtr& body)
+{
+	auto found = m_slots.find(body->GetId());
+	if (found != std::end(m_slots))
+	{
+		++m_bodyJoints[found->second];
+		return found->second;
+	}
+
+	uint32_t slot;
+	if (!m_freeSlots.empty())
+	{
+		slot = m_freeSlots.back();
+		m_freeSlots.pop_back();
+		m_bodies[slot] = body;
+		m_bodyJoints[slot] = 1;
+		m_bodyActive[slot] = 1;
+	}
+	else
+	{
+		slot = static_cast<uint32_t>(m_bodies.size());
+		m_bodies.push_back(body);
+		m_bodyJoints.push_back(1);
+		m_bodyActive.push_back(1);
+	}
+
+	m_slots[body->GetId()] = slot;
+	return slot;
+}
+
+void JointSolver::releaseSlot(uint32_t slot)
+{
+	if (--m_bodyJoints[slot] != 0)
+		return;
+
+	m_slots.erase(m_bodies[slot]->GetId());
+	m_bodies[slot].reset();
+	m_freeSlots.push_back(slot);
+}
+
+void JointSolver::removeAt(size_t index)
+{
+	releaseSlot(m_first[index]);
+	releaseSlot(m_second[index]);
+	m_indices.erase(m_ids[index]);
+
+	// Last joint takes place of removed one, batches are rebuilt anyway
+	const size_t last = m_ids.size() - 1;
+	if (index != last)
+	{
+		swapJoints(index, last);
+		m_indices[m_ids[index]] = index;
+	}
+
+	m_ids.pop_back();
+	m_types.pop_back();
+	m_first.pop_back();
+	m_second.pop_back();
+	m_length.pop_back();
+	m_stiffness.pop_back();
+	m_damping.pop_back();
+
+	m_batchesDirty = true;
+}
+
+void JointSolver::swapJoints(size_t l, size_t r)
+{
+	std::swap(m_ids[l], m_ids[r]);
+	std::swap(m_types[l], m_types[r]);
+	std::swap(m_first[l], m_first[r]);
+	std::swap(m_second[l], m_second[r]);
+	std::swap(m_length[l], m_length[r]);
+	std::swap(m_stiffness[l], m_stiffness[r]);
+	std::swap(m_damping[l], m_damping[r]);
+}
+
+void JointSolver::rebuildBatches()
+{
+	const size_t count = m_ids.size();
+
+	// Greedy coloring: joint goes to the first batch none of its moving bodies is in.
+	// Bodies of infinite mass are never written, so they may be in every batch.
+	std::vector<uint64_t> used(m_bodies.size(), 0);
+	std::vector<size_t> batches(count);
+	size_t batch_count = 0;
+	m_lastBatchShared = false;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const uint32_t a = m_first[i];
+		const uint32_t b = m_second[i];
+		const bool moving_a = m_bodies[a]->GetBodyType() == IBody::BodyType::Dynamic;
+		const bool moving_b = m_bodies[b]->GetBodyType() == IBody::BodyType::Dynamic;
+
+		const uint64_t taken = (moving_a ? used[a] : 0) | (moving_b ? used[b] : 0);
+		size_t batch = 0;
+		while (batch < kMaxJointBatches - 1 && (taken & (uint64_t(1) << batch)) != 0)
+			++batch;
+		if ((taken & (uint64_t(1) << batch)) != 0)
+			m_lastBatchShared = true;
+
+		batches[i] = batch;
+		used[a] |= uint64_t(1) << batch;
+		used[b] |= uint64_t(1) << batch;
+		batch_count = std::max(batch_count, batch + 1);
+	}
+
+	// Joints of one batch are moved next to each other
+	std::vector<size_t> order(count);
+	std::iota(std::begin(order), std::end(order), size_t(0));
+	std::stable_sort(std::begin(order), std::end(order),
+		[&batches](size_t l, size_t r) { return batches[l] < batches[r]; });
+
+	auto permute = [&order](auto& values)
+	{
+		auto sorted = values;
+		for (size_t i = 0; i < order.size(); ++i)
+			sorted[i] = values[order[i]];
+		values.swap(sorted);
+	};
+	permute(m_ids);
+	permute(m_types);
+	permute(m_first);
+	permute(m_second);
+	permute(m_length);
+	permute(m_stiffness);
+	permute(m_damping);
+
+	for (size_t i = 0; i < count; ++i)
+		m_indices[m_ids[i]] = i;
+
+	m_batchEnds.assign(batch_count, 0);
+	for (size_t i = 0; i < count; ++i)
+		m_batchEnds[batches[order[i]]] = i + 1;
+
+	m_batchesDirty = false;
+}
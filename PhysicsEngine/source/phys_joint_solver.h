@@ -0,0 +1,116 @@
+#ifndef PHYS_JOINT_SOLVER_H
+#define PHYS_JOINT_SOLVER_H
+
+#include <phys_joint.h>
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace physic
+{
+	class Workers;
+
+	// Joints stored by component in contiguous arrays. Joints are grouped in batches where
+	// no moving body is used twice, so joints of one batch are solved independently.
+	class JointSolver
+	{
+	public:
+		// Joint as kept by checkpoints, with its id and whether its bodies are solved
+		struct Saved
+		{
+			JointId id;
+			JointDef def;
+			bool first_active;
+			bool second_active;
+		};
+
+		// Big batches are split between threads of workers
+		explicit JointSolver(Workers& workers);
+		~JointSolver();
+
+		JointId add(const JointDef& def);
+		bool remove(JointId id);
+		// Drop all joints of body leaving the world
+		void removeBody(const BodyPtr& body);
+		// Body of frozen chunk is held like a body of infinite mass and never written,
+		// its joints keep the body which is no longer simulated
+		void freezeBody(const BodyPtr& body);
+		// Joints of body with the same id move to this object, e.g. woken or read back from disk,
+		// and the body is solved again
+		void rebindBody(const BodyPtr& body);
+
+		bool empty() const { return m_ids.empty(); }
+
+		void save(std::vector<Saved>& joints) const;
+		// Replace all joints with saved ones, which keep their ids
+		void restore(const std::vector<Saved>& joints);
+
+		// Change velocities of jointed bodies so their joints hold after step of dt.
+		// Bodies of sorted skipped ids are not due on this step and keep their velocity.
+		void solve(Scalar dt, const std::vector<BodyId>& skipped);
+		// Move jointed bodies after they moved by their velocity, so distance joints and taut ropes
+		// don't stretch where velocities alone fail, e.g. fast spinning chains. Skipped bodies stay.
+		void correct(const std::vector<BodyId>& skipped);
+
+	private:
+		void insert(JointId id, const JointDef& def);
+		uint32_t acquireSlot(const BodyPtr& body);
+		void releaseSlot(uint32_t slot);
+		void removeAt(size_t index);
+		void rebuildBatches();
+		void swapJoints(size_t l, size_t r);
+		// Fill scratch state of jointed bodies
+		void gatherBodies(const std::vector<BodyId>& skipped);
+		// Run pass(begin, end) over every batch iterations times, split between threads for big batches
+		template <class Pass>
+		void runBatches(int iterations, const Pass& pass);
+		// One pass over joints [begin, end) of one batch
+		void solveRange(size_t begin, size_t end);
+		void correctRange(size_t begin, size_t end);
+
+		// Joints by index, reordered by batch
+		std::vector<JointId> m_ids;
+		std::vector<JointDef::Type> m_types;
+		std::vector<uint32_t> m_first;
+		std::vector<uint32_t> m_second;
+		std::vector<Scalar> m_length;
+		std::vector<Scalar> m_stiffness;
+		std::vector<Scalar> m_damping;
+		std::unordered_map<JointId, size_t> m_indices;
+		JointId m_nextId;
+
+		// End index of every batch
+		std::vector<size_t> m_batchEnds;
+		bool m_batchesDirty;
+		// Last batch took joints which didn't fit in any other, its bodies may repeat
+		bool m_lastBatchShared;
+
+		// Jointed bodies by slot, joints refer to bodies by slot
+		std::vector<BodyPtr> m_bodies;
+		std::vector<uint32_t> m_bodyJoints;
+		// Zero for bodies of frozen chunks
+		std::vector<uint8_t> m_bodyActive;
+		std::vector<uint32_t> m_freeSlots;
+		std::unordered_map<BodyId, uint32_t> m_slots;
+
+		// Scratch state of bodies by slot, filled every solve
+		std::vector<Scalar> m_positionX;
+		std::vector<Scalar> m_positionY;
+		std::vector<Scalar> m_velocityX;
+		std::vector<Scalar> m_velocityY;
+		std::vector<Scalar> m_invMass;
+
+		// Scratch state of joints by index, filled every solve
+		std::vector<Scalar> m_normalX;
+		std::vector<Scalar> m_normalY;
+		std::vector<Scalar> m_bias;
+		std::vector<Scalar> m_gamma;
+		std::vector<Scalar> m_effectiveMass;
+		std::vector<Scalar> m_impulse;
+
+		Workers& m_workers;
+	};
+} // namespace physic
+
+#endif // PHYS_JOINT_SOLVER_H
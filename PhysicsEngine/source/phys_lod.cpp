@@ -0,0 +1,92 @@
+#include "phys_engine_impl.h"
+
+#include <algorithm>
+
+using namespace physic;
+
+void EngineImpl::SetFocusPoints(const Point* points, size_t count)
+{
+	assert(nullptr != points || 0 == count);
+
+	m_focusPoints.assign(points, points + count);
+}
+
+void EngineImpl::SetLodTiers(const LodTier* tiers, size_t count)
+{
+	assert(nullptr != tiers || 0 == count);
+
+	m_lodTiers.assign(tiers, tiers + count);
+	std::sort(std::begin(m_lodTiers), std::end(m_lodTiers),
+		[](const LodTier& l, const LodTier& r) { return l.distance < r.distance; });
+
+	for (auto& tier : m_lodTiers)
+	{
+		assert(tier.interval > 0);
+		tier.interval = std::max(tier.interval, 1u);
+	}
+}
+
+void EngineImpl::scheduleBodies(double dt)
+{
+	const size_t count = m_bodies.size();
+	assert(m_bodyLod.size() == count);
+
+	m_bodyDt.resize(count);
+	m_skippedIds.clear();
+	for (size_t i = 0; i < count; ++i)
+	{
+		BodyLod& lod = m_bodyLod[i];
+		++lod.pending;
+		lod.elapsed += dt;
+
+		// Bodies of one tier are spread over steps by id, so cost of step stays even.
+		// Body coming from slower tier is stepped as soon as it is due in the new one.
+		const bool due = lod.pending >= lod.interval ||
+			0 == (m_stepIndex + m_bodies[i]->GetId()) % lod.interval;
+
+		m_bodyDt[i] = due ? lod.elapsed : 0;
+		if (due)
+		{
+			lod.pending = 0;
+			lod.elapsed = 0;
+		}
+		else
+			m_skippedIds.push_back(m_bodies[i]->GetId());
+	}
+
+	// Looked up by contacts carried over skipped steps
+	std::sort(std::begin(m_skippedIds), std::end(m_skippedIds));
+}
+
+void EngineImpl::updateTiers()
+{
+	if (m_focusPoints.empty() || m_lodTiers.empty())
+	{
+		// Everything goes back to full rate, pending steps are taken on next step
+		for (auto& lod : m_bodyLod)
+			lod.interval = 1;
+		return;
+	}
+
+	// Interval of skipped bodies changes on their next step only
+	for (size_t i = 0; i < m_bodies.size(); ++i)
+	{
+		if (0 == m_bodyDt[i])
+			continue;
+
+		const Point position = m_bodies[i]->GetPosition();
+		Scalar distance_sq = SquaredNorm(position - m_focusPoints.front());
+		for (const auto& focus : m_focusPoints)
+			distance_sq = std::min(distance_sq, SquaredNorm(position - focus));
+
+		uint32_t interval = 1;
+		for (const auto& tier : m_lodTiers)
+		{
+			if (distance_sq < tier.distance * tier.distance)
+				break;
+			interval = tier.interval;
+		}
+
+		m_bodyLod[i].interval = interval;
+	}
+}
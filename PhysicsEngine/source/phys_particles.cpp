@@ -0,0 +1,197 @@
+#include "phys_particles_impl.h"
+#include "phys_engine_impl.h"
+
+#include <algorithm>
+
+using namespace physic;
+
+ParticleSystem::ParticleSystem(size_t capacity, Scalar radius, Scalar bounce_factor, bool collide_with_statics)
+	: m_capacity(capacity)
+	, m_count(0)
+	, m_radius(radius)
+	, m_bounceFactor(bounce_factor)
+	, m_collideWithStatics(collide_with_statics)
+	, m_x(capacity)
+	, m_y(capacity)
+	, m_velocityX(capacity)
+	, m_velocityY(capacity)
+	, m_lifetime(capacity)
+{
+}
+
+bool ParticleSystem::Emit(const Point& position, const fVec2D& velocity, Scalar lifetime)
+{
+	if (m_count == m_capacity)
+		return false;
+
+	m_x[m_count] = position.x;
+	m_y[m_count] = position.y;
+	m_velocityX[m_count] = velocity.x;
+	m_velocityY[m_count] = velocity.y;
+	m_lifetime[m_count] = lifetime;
+	++m_count;
+	return true;
+}
+
+ParticleData ParticleSystem::GetParticles() const
+{
+	return { m_x.data(), m_y.data(), m_velocityX.data(), m_velocityY.data(), m_lifetime.data(), m_count };
+}
+
+size_t ParticleSystem::GetCapacity() const
+{
+	return m_capacity;
+}
+
+Scalar ParticleSystem::GetRadius() const
+{
+	return m_radius;
+}
+
+Scalar ParticleSystem::GetBounceFactor() const
+{
+	return m_bounceFactor;
+}
+
+bool ParticleSystem::CollidesWithStatics() const
+{
+	return m_collideWithStatics;
+}
+
+void ParticleSystem::update(Scalar dt, const ParticleWorld& world)
+{
+	Scalar* const x = m_x.data();
+	Scalar* const y = m_y.data();
+	Scalar* const velocity_x = m_velocityX.data();
+	Scalar* const velocity_y = m_velocityY.data();
+	Scalar* const lifetime = m_lifetime.data();
+
+	const Scalar left = world.bot_left.x + m_radius;
+	const Scalar right = world.top_right.x - m_radius;
+	const Scalar bottom = world.bot_left.y + m_radius;
+	const Scalar top = world.top_right.y - m_radius;
+
+	// Single branchless pass over all components, particles are massless
+	// so gravity and drag are accelerations
+	for (size_t i = 0; i < m_count; ++i)
+	{
+		Scalar vx = velocity_x[i] + (world.gravity.x - world.air_drag * velocity_x[i]) * dt;
+		Scalar vy = velocity_y[i] + (world.gravity.y - world.air_drag * velocity_y[i]) * dt;
+		Scalar px = x[i] + vx * dt;
+		Scalar py = y[i] + vy * dt;
+
+		// Bounce off world borders
+		vx = (px < left || px > right) ? -m_bounceFactor * vx : vx;
+		vy = (py < bottom || py > top) ? -m_bounceFactor * vy : vy;
+		px = std::min(std::max(px, left), right);
+		py = std::min(std::max(py, bottom), top);
+
+		x[i] = px;
+		y[i] = py;
+		velocity_x[i] = vx;
+		velocity_y[i] = vy;
+		lifetime[i] -= dt;
+	}
+
+	// Expired particles are replaced by the last ones
+	for (size_t i = 0; i < m_count;)
+	{
+		if (lifetime[i] > Scalar(0))
+		{
+			++i;
+			continue;
+		}
+
+		--m_count;
+		x[i] = x[m_count];
+		y[i] = y[m_count];
+		velocity_x[i] = velocity_x[m_count];
+		velocity_y[i] = velocity_y[m_count];
+		lifetime[i] = lifetime[m_count];
+	}
+}
+
+void ParticleSystem::collideCircle(size_t index, const Point& center, Scalar radius)
+{
+	const fVec2D distance{ m_x[index] - center.x, m_y[index] - center.y };
+	const Scalar reach = radius + m_radius;
+	const Scalar distance_sq = distance.x * distance.x + distance.y * distance.y;
+	if (distance_sq > reach * reach || distance_sq == Scalar(0))
+		return;
+
+	const Scalar distance_norm = EuclideanNorm(distance);
+	pushOut(index, distance / distance_norm, reach - distance_norm);
+}
+
+void ParticleSystem::pushOut(size_t index, const fVec2D& normal, Scalar depth)
+{
+	m_x[index] += normal.x * depth;
+	m_y[index] += normal.y * depth;
+
+	// Reflect velocity only if particle moves inside
+	const fVec2D velocity{ m_velocityX[index], m_velocityY[index] };
+	const Scalar normal_speed = DotProduct(velocity, normal);
+	if (normal_speed >= Scalar(0))
+		return;
+
+	const fVec2D reflected = velocity - (Scalar(1) + m_bounceFactor) * normal_speed * normal;
+	m_velocityX[index] = reflected.x;
+	m_velocityY[index] = reflected.y;
+}
+
+ParticleSystemPtr IParticleSystem::Create(size_t capacity, Scalar radius, Scalar bounce_factor, bool collide_with_statics)
+{
+	return std::make_shared<ParticleSystem>(capacity, radius, bounce_factor, collide_with_statics);
+}
+
+void EngineImpl::AddParticleSystem(const ParticleSystemPtr& system)
+{
+	assert(nullptr != system);
+	m_particleSystems.push_back(system);
+}
+
+void EngineImpl::RemoveParticleSystem(const ParticleSystemPtr& system)
+{
+	assert(nullptr != system);
+	m_particleSystems.erase(std::remove(std::begin(m_particleSystems), std::end(m_particleSystems), system),
+		std::end(m_particleSystems));
+}
+
+void EngineImpl::updateParticles(Scalar dt)
+{
+	const ParticleWorld world = { m_gravity, m_airDrag, m_botLeft, m_topRight };
+
+	for (auto& system : m_particleSystems)
+	{
+		// Only ParticleSystem may derive from IParticleSystem
+		ParticleSystem& particles = static_cast<ParticleSystem&>(*system);
+		particles.update(dt, world);
+
+		if (!particles.CollidesWithStatics() || (m_staticBodies.empty() && m_terrain.empty()))
+			continue;
+
+		// Dynamic bodies are never touched, only static tree is looked up
+		const ParticleData data = particles.GetParticles();
+		const Scalar radius = particles.GetRadius();
+		for (size_t i = 0; i < data.count; ++i)
+		{
+			// Only chunks around particle are looked up, not every chunk of the world
+			const Point bot_left{ data.x[i] - radius, data.y[i] - radius };
+			const Point top_right{ data.x[i] + radius, data.y[i] + radius };
+			// Static tree is refilled at the start of step once any static body changed,
+			// so entry keeps actual position and radius
+			auto collide_with = [&](const ChunkTree<BodyPtr>::Entry& entry)
+			{
+				particles.collideCircle(i, entry.position, entry.radius);
+				return true;
+			};
+			m_staticTree.query(bot_left, top_right, collide_with);
+
+			auto touch_terrain = [&](const fVec2D& normal, Scalar depth)
+			{
+				particles.pushOut(i, normal, depth);
+			};
+			m_terrain.collide(Point{ data.x[i], data.y[i] }, radius, touch_terrain);
+		}
+	}
+}
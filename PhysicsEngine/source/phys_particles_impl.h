@@ -0,0 +1,62 @@
+#ifndef PHYS_PARTICLES_IMPL_H
+#define PHYS_PARTICLES_IMPL_H
+
+#include <phys_particles.h>
+
+#include <vector>
+
+namespace physic
+{
+	// World state particles are moved by
+	struct ParticleWorld
+	{
+		fVec2D gravity;
+		Scalar air_drag;
+		Point bot_left;
+		Point top_right;
+	};
+
+	// The only implementation of IParticleSystem, engine updates it through this type
+	class ParticleSystem : public IParticleSystem
+	{
+	public:
+		ParticleSystem(size_t capacity, Scalar radius, Scalar bounce_factor, bool collide_with_statics);
+		virtual ~ParticleSystem() = default;
+
+		ParticleSystem(const ParticleSystem&) = delete;
+		ParticleSystem& operator=(const ParticleSystem&) = delete;
+
+		virtual bool Emit(const Point& position, const fVec2D& velocity, Scalar lifetime) override;
+
+		virtual ParticleData GetParticles() const override;
+		virtual size_t GetCapacity() const override;
+		virtual Scalar GetRadius() const override;
+		virtual Scalar GetBounceFactor() const override;
+		virtual bool CollidesWithStatics() const override;
+
+		// Move all particles in one pass and drop expired ones
+		void update(Scalar dt, const ParticleWorld& world);
+
+		// Bounce particle off circle of static body
+		void collideCircle(size_t index, const Point& center, Scalar radius);
+
+		// Move particle by normal * depth and reflect its velocity if it moves against normal
+		void pushOut(size_t index, const fVec2D& normal, Scalar depth);
+
+	private:
+		size_t m_capacity;
+		size_t m_count;
+		Scalar m_radius;
+		Scalar m_bounceFactor;
+		bool m_collideWithStatics;
+
+		// Components are kept apart, so update loops are vectorized
+		std::vector<Scalar> m_x;
+		std::vector<Scalar> m_y;
+		std::vector<Scalar> m_velocityX;
+		std::vector<Scalar> m_velocityY;
+		std::vector<Scalar> m_lifetime;
+	};
+} // namespace physic
+
+#endif // PHYS_PARTICLES_IMPL_H
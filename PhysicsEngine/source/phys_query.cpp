@@ -0,0 +1,294 @@
+#include "phys_engine_impl.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace physic;
+
+namespace
+{
+	using Entry = ChunkTree<BodyPtr>::Entry;
+
+	// Don't wake up worker threads for less rays than this
+	const size_t kMinRaysPerThread = 256;
+
+	// Squared distance from point to the closest point of rectangle
+	Scalar squaredDistanceToRect(const Point& p, const Point& bot_left, const Point& top_right)
+	{
+		const Scalar dx = std::max(std::max(bot_left.x - p.x, p.x - top_right.x), Scalar(0));
+		const Scalar dy = std::max(std::max(bot_left.y - p.y, p.y - top_right.y), Scalar(0));
+		return dx * dx + dy * dy;
+	}
+
+	bool rectsOverlap(const Point& bot_left, const Point& top_right, const Point& other_bot_left, const Point& other_top_right)
+	{
+		return bot_left.x <= other_top_right.x && other_bot_left.x <= top_right.x &&
+			bot_left.y <= other_top_right.y && other_bot_left.y <= top_right.y;
+	}
+
+	// Slab test of segment from + direction * [0, max_fraction] against rectangle
+	bool segmentIntersectsRect(const Point& from, const fVec2D& direction, Scalar max_fraction,
+		const Point& bot_left, const Point& top_right)
+	{
+		Scalar t_min = 0;
+		Scalar t_max = max_fraction;
+
+		const Scalar origin[2] = { from.x, from.y };
+		const Scalar dir[2] = { direction.x, direction.y };
+		const Scalar low[2] = { bot_left.x, bot_left.y };
+		const Scalar high[2] = { top_right.x, top_right.y };
+
+		for (int axis = 0; axis < 2; ++axis)
+		{
+			if (dir[axis] == Scalar(0))
+			{
+				if (origin[axis] < low[axis] || origin[axis] > high[axis])
+					return false;
+				continue;
+			}
+
+			Scalar t1 = (low[axis] - origin[axis]) / dir[axis];
+			Scalar t2 = (high[axis] - origin[axis]) / dir[axis];
+			if (t1 > t2)
+				std::swap(t1, t2);
+
+			t_min = std::max(t_min, t1);
+			t_max = std::min(t_max, t2);
+			if (t_min > t_max)
+				return false;
+		}
+
+		return true;
+	}
+
+	// First intersection of segment from + direction * [0, 1] with circle
+	bool segmentIntersectsCircle(const Point& from, const fVec2D& direction, const Entry& entry, Scalar& fraction)
+	{
+		const fVec2D offset = from - entry.position;
+		const Scalar c = SquaredNorm(offset) - entry.radius * entry.radius;
+
+		// Segment starts inside of circle
+		if (c <= Scalar(0))
+		{
+			fraction = 0;
+			return true;
+		}
+
+		const Scalar a = SquaredNorm(direction);
+		if (a == Scalar(0))
+			return false;
+
+		const Scalar b = DotProduct(offset, direction);
+		const Scalar discriminant = b * b - a * c;
+		if (discriminant < Scalar(0))
+			return false;
+
+		const Scalar t = (-b - sqrt(discriminant)) / a;
+		if (t < Scalar(0) || t > Scalar(1))
+			return false;
+
+		fraction = t;
+		return true;
+	}
+
+	RaycastHit makeHit(const Point& from, const fVec2D& direction, const Entry& entry, Scalar fraction)
+	{
+		RaycastHit hit;
+		hit.body = entry.object;
+		hit.point = from + direction * fraction;
+		hit.normal = Normalized(hit.point - entry.position);
+		hit.fraction = fraction;
+		return hit;
+	}
+}
+
+bool EngineImpl::Raycast(const Point& from, const Point& to, RaycastHit& hit) const
+{
+	const fVec2D direction = to - from;
+
+	Scalar best_fraction = 1;
+	const Entry* best_entry = nullptr;
+
+	// Nodes behind the closest hit so far are skipped
+	auto accept = [&](const Point& bot_left, const Point& top_right)
+	{
+		return segmentIntersectsRect(from, direction, best_fraction, bot_left, top_right);
+	};
+
+	auto visit = [&](const Entry& entry)
+	{
+		Scalar fraction;
+		if (segmentIntersectsCircle(from, direction, entry, fraction) && fraction <= best_fraction)
+		{
+			best_fraction = fraction;
+			best_entry = &entry;
+		}
+		return true;
+	};
+
+	traverseTrees(accept, visit);
+
+	if (nullptr == best_entry)
+	{
+		hit = RaycastHit();
+		return false;
+	}
+
+	hit = makeHit(from, direction, *best_entry, best_fraction);
+	return true;
+}
+
+void EngineImpl::RaycastAll(const Point& from, const Point& to, IRaycastCallback& callback) const
+{
+	const fVec2D direction = to - from;
+
+	auto accept = [&](const Point& bot_left, const Point& top_right)
+	{
+		return segmentIntersectsRect(from, direction, Scalar(1), bot_left, top_right);
+	};
+
+	auto visit = [&](const Entry& entry)
+	{
+		Scalar fraction;
+		if (!segmentIntersectsCircle(from, direction, entry, fraction))
+			return true;
+
+		return callback.OnHit(makeHit(from, direction, entry, fraction));
+	};
+
+	traverseTrees(accept, visit);
+}
+
+void EngineImpl::RaycastBatch(const RaycastRequest* rays, RaycastHit* hits, size_t count) const
+{
+	assert(nullptr != rays || 0 == count);
+	assert(nullptr != hits || 0 == count);
+
+	// Tree is not modified by queries, so rays are traced concurrently
+	const size_t threads = std::min(m_workers.size(), (count + kMinRaysPerThread - 1) / kMinRaysPerThread);
+
+	auto trace = [this, rays, hits](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+			Raycast(rays[i].from, rays[i].to, hits[i]);
+	};
+
+	if (threads <= 1)
+	{
+		trace(0, count);
+		return;
+	}
+
+	// Calling thread takes the first part
+	const size_t per_thread = (count + threads - 1) / threads;
+	m_workers.run(threads, [&trace, count, per_thread](size_t thread)
+	{
+		trace(std::min(count, thread * per_thread), std::min(count, (thread + 1) * per_thread));
+	});
+}
+
+void EngineImpl::QueryRect(const Point& bot_left, const Point& top_right, IQueryCallback& callback) const
+{
+	auto accept = [&](const Point& node_bot_left, const Point& node_top_right)
+	{
+		return rectsOverlap(bot_left, top_right, node_bot_left, node_top_right);
+	};
+
+	auto visit = [&](const Entry& entry)
+	{
+		if (squaredDistanceToRect(entry.position, bot_left, top_right) > entry.radius * entry.radius)
+			return true;
+
+		return callback.OnBody(entry.object);
+	};
+
+	traverseTrees(accept, visit);
+}
+
+void EngineImpl::QueryCircle(const Point& center, Scalar radius, IQueryCallback& callback) const
+{
+	auto accept = [&](const Point& bot_left, const Point& top_right)
+	{
+		return squaredDistanceToRect(center, bot_left, top_right) <= radius * radius;
+	};
+
+	auto visit = [&](const Entry& entry)
+	{
+		const Scalar reach = radius + entry.radius;
+		if (SquaredNorm(entry.position - center) > reach * reach)
+			return true;
+
+		return callback.OnBody(entry.object);
+	};
+
+	traverseTrees(accept, visit);
+}
+
+size_t EngineImpl::ExportBodiesInRect(const Point& bot_left, const Point& top_right,
+	ExportedBody* exported, size_t capacity) const
+{
+	assert(nullptr != exported || 0 == capacity);
+
+	auto accept = [&](const Point& node_bot_left, const Point& node_top_right)
+	{
+		return rectsOverlap(bot_left, top_right, node_bot_left, node_top_right);
+	};
+
+	// Bodies which don't fit are still counted
+	size_t count = 0;
+	auto visit = [&](const Entry& entry)
+	{
+		if (squaredDistanceToRect(entry.position, bot_left, top_right) > entry.radius * entry.radius)
+			return true;
+
+		if (count < capacity)
+		{
+			exported[count].id = entry.object->GetId();
+			exported[count].position = entry.position;
+			exported[count].velocity = entry.object->GetVelocityVector();
+		}
+		++count;
+		return true;
+	};
+
+	traverseTrees(accept, visit);
+	return count;
+}
+
+size_t EngineImpl::QueryNearest(const Point& point, size_t k, NearestHit* hits) const
+{
+	assert(nullptr != hits || 0 == k);
+
+	size_t found = 0;
+	if (0 == k)
+		return found;
+
+	// Once k bodies are found, nodes farther than the worst of them are skipped
+	auto accept = [&](const Point& bot_left, const Point& top_right)
+	{
+		if (found < k)
+			return true;
+
+		const Scalar worst = hits[k - 1].distance;
+		return squaredDistanceToRect(point, bot_left, top_right) <= worst * worst;
+	};
+
+	// Hits are kept sorted by insertion into caller's buffer
+	auto visit = [&](const Entry& entry)
+	{
+		const Scalar distance = EuclideanNorm(entry.position - point);
+		if (found == k && distance >= hits[k - 1].distance)
+			return true;
+
+		size_t i = found < k ? found++ : k - 1;
+		for (; i > 0 && hits[i - 1].distance > distance; --i)
+			hits[i] = std::move(hits[i - 1]);
+
+		hits[i].body = entry.object;
+		hits[i].distance = distance;
+		return true;
+	};
+
+	traverseTrees(accept, visit);
+	return found;
+}
\ No newline at end of file
@@ -0,0 +1,484 @@
+#include <phys_region.h>
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace physic;
+
+namespace
+{
+	// Every node sends one message to every neighbour per step,
+	// handoff and then ghost states follow the header
+	struct RegionMessage
+	{
+		uint64_t step;
+		uint32_t handoffs;
+		uint32_t ghosts;
+	};
+
+	// Messages are written field by field in little endian order, so padding of BodyState never
+	// goes on the wire and nodes don't depend on layout of structs. Scalar is sent as is,
+	// all nodes should run a build with the same Scalar.
+	bool IsLittleEndianHost()
+	{
+		const uint16_t probe = 1;
+		uint8_t first = 0;
+		std::memcpy(&first, &probe, 1);
+		return 1 == first;
+	}
+
+	template <typename T>
+	void writeField(std::vector<uint8_t>& buffer, const T& value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "field must be trivially copyable");
+		uint8_t bytes[sizeof(T)];
+		std::memcpy(bytes, &value, sizeof(T));
+		if (!IsLittleEndianHost())
+			std::reverse(std::begin(bytes), std::end(bytes));
+		buffer.insert(buffer.end(), std::begin(bytes), std::end(bytes));
+	}
+
+	// Moves data past the field, fails if message ends before it
+	template <typename T>
+	bool readField(const uint8_t*& data, const uint8_t* end, T& value)
+	{
+		if (static_cast<size_t>(end - data) < sizeof(T))
+			return false;
+
+		uint8_t bytes[sizeof(T)];
+		std::memcpy(bytes, data, sizeof(T));
+		if (!IsLittleEndianHost())
+			std::reverse(std::begin(bytes), std::end(bytes));
+		std::memcpy(&value, bytes, sizeof(T));
+		data += sizeof(T);
+		return true;
+	}
+
+	void writeHeader(std::vector<uint8_t>& buffer, const RegionMessage& header)
+	{
+		writeField(buffer, header.step);
+		writeField(buffer, header.handoffs);
+		writeField(buffer, header.ghosts);
+	}
+
+	bool readHeader(const uint8_t*& data, const uint8_t* end, RegionMessage& header)
+	{
+		return readField(data, end, header.step) && readField(data, end, header.handoffs) &&
+			readField(data, end, header.ghosts);
+	}
+
+	// Bytes of state on the wire, written by writeState
+	const size_t kStateSize = sizeof(BodyId) + 2 * sizeof(uint8_t) + sizeof(ShapeId) + 6 * sizeof(Scalar) +
+		sizeof(uint8_t) + 3 * sizeof(uint16_t);
+
+	void writeState(std::vector<uint8_t>& buffer, const BodyState& state)
+	{
+		const size_t start = buffer.size();
+		writeField(buffer, state.id);
+		writeField(buffer, static_cast<uint8_t>(state.type));
+		writeField(buffer, static_cast<uint8_t>(state.shape));
+		writeField(buffer, state.shape_id);
+		writeField(buffer, state.position.x);
+		writeField(buffer, state.position.y);
+		writeField(buffer, state.velocity.x);
+		writeField(buffer, state.velocity.y);
+		writeField(buffer, state.mass);
+		writeField(buffer, state.bounce_factor);
+		writeField(buffer, static_cast<uint8_t>(state.sensor));
+		writeField(buffer, state.filter.category);
+		writeField(buffer, state.filter.mask);
+		writeField(buffer, state.filter.group);
+		assert(buffer.size() - start == kStateSize);
+		(void)start;
+	}
+
+	bool readState(const uint8_t*& data, const uint8_t* end, BodyState& state)
+	{
+		uint8_t type = 0;
+		uint8_t shape = 0;
+		uint8_t sensor = 0;
+		if (!(readField(data, end, state.id) && readField(data, end, type) && readField(data, end, shape) &&
+			readField(data, end, state.shape_id) && readField(data, end, state.position.x) &&
+			readField(data, end, state.position.y) && readField(data, end, state.velocity.x) &&
+			readField(data, end, state.velocity.y) && readField(data, end, state.mass) &&
+			readField(data, end, state.bounce_factor) && readField(data, end, sensor) &&
+			readField(data, end, state.filter.category) && readField(data, end, state.filter.mask) &&
+			readField(data, end, state.filter.group)))
+			return false;
+
+		state.type = static_cast<IBody::BodyType>(type);
+		state.shape = static_cast<IShape::ShapeType>(shape);
+		state.sensor = 0 != sensor;
+		return true;
+	}
+
+	class RegionNode : public IRegionNode
+	{
+	public:
+		RegionNode(IEngine& engine, const TransportPtr& transport, const RegionGrid& grid);
+		virtual ~RegionNode() = default;
+
+		RegionNode(const RegionNode&) = delete;
+		RegionNode& operator=(const RegionNode&) = delete;
+
+		virtual int GetRegion() const override;
+
+		virtual void AddBody(BodyPtr&) override;
+		virtual void RemoveBody(const BodyPtr&) override;
+
+		virtual const std::vector<BodyPtr>& GetOwnedBodies() const override;
+
+		virtual bool Step(double dt) override;
+
+	private:
+		struct Neighbour
+		{
+			int region;
+			Point bot_left;
+			Point top_right;
+
+			// Outgoing states of current step
+			std::vector<BodyState> handoffs;
+			std::vector<BodyState> ghosts;
+		};
+
+		struct Ghost
+		{
+			BodyPtr body;
+			// Last step the ghost was received on
+			uint64_t step;
+		};
+
+		int regionOf(const Point&) const;
+		void getRegionBounds(int region, Point& bot_left, Point& top_right) const;
+		Neighbour& neighbourTowards(int region);
+
+		void sortOwnedBodies();
+		bool sendMessages();
+		bool receiveMessages();
+		bool applyMessage(const std::vector<uint8_t>&);
+
+		IEngine& m_engine;
+		TransportPtr m_transport;
+		RegionGrid m_grid;
+		int m_region;
+		Point m_botLeft;
+		Point m_topRight;
+
+		std::vector<Neighbour> m_neighbours;
+		std::vector<BodyPtr> m_owned;
+		std::unordered_map<BodyId, Ghost> m_ghosts;
+
+		uint64_t m_step;
+
+		// Neighbours may finish their step before we received from all the others
+		std::vector<std::vector<uint8_t>> m_earlyMessages;
+		std::vector<uint8_t> m_buffer;
+	};
+
+	RegionNode::RegionNode(IEngine& engine, const TransportPtr& transport, const RegionGrid& grid)
+		: m_engine(engine)
+		, m_transport(transport)
+		, m_grid(grid)
+		, m_region(transport->GetSelf())
+		, m_botLeft()
+		, m_topRight()
+		, m_neighbours()
+		, m_owned()
+		, m_ghosts()
+		, m_step(0)
+		, m_earlyMessages()
+		, m_buffer()
+	{
+		assert(grid.columns > 0 && grid.rows > 0);
+		assert(transport->GetPeerCount() == grid.columns * grid.rows);
+
+		getRegionBounds(m_region, m_botLeft, m_topRight);
+
+		const int column = m_region % m_grid.columns;
+		const int row = m_region / m_grid.columns;
+		for (int y = std::max(row - 1, 0); y <= std::min(row + 1, m_grid.rows - 1); ++y)
+			for (int x = std::max(column - 1, 0); x <= std::min(column + 1, m_grid.columns - 1); ++x)
+			{
+				if (x == column && y == row)
+					continue;
+
+				Neighbour neighbour;
+				neighbour.region = y * m_grid.columns + x;
+				getRegionBounds(neighbour.region, neighbour.bot_left, neighbour.top_right);
+				m_neighbours.push_back(std::move(neighbour));
+			}
+	}
+
+	int RegionNode::GetRegion() const
+	{
+		return m_region;
+	}
+
+	void RegionNode::AddBody(BodyPtr& body)
+	{
+		assert(nullptr != body);
+
+		m_engine.AddBody(body);
+		if (body->GetBodyType() != IBody::BodyType::Static)
+			m_owned.push_back(body);
+	}
+
+	void RegionNode::RemoveBody(const BodyPtr& body)
+	{
+		assert(nullptr != body);
+
+		m_engine.RemoveBody(body);
+		m_owned.erase(std::remove(std::begin(m_owned), std::end(m_owned), body), std::end(m_owned));
+	}
+
+	const std::vector<BodyPtr>& RegionNode::GetOwnedBodies() const
+	{
+		return m_owned;
+	}
+
+	bool RegionNode::Step(double dt)
+	{
+		m_engine.Step(dt);
+		++m_step;
+
+		sortOwnedBodies();
+		return sendMessages() && receiveMessages();
+	}
+
+	int RegionNode::regionOf(const Point& pos) const
+	{
+		const double width = static_cast<double>(m_grid.top_right.x - m_grid.bot_left.x) / m_grid.columns;
+		const double height = static_cast<double>(m_grid.top_right.y - m_grid.bot_left.y) / m_grid.rows;
+
+		const int column = Clip(static_cast<int>(std::floor(static_cast<double>(pos.x - m_grid.bot_left.x) / width)), 0, m_grid.columns - 1);
+		const int row = Clip(static_cast<int>(std::floor(static_cast<double>(pos.y - m_grid.bot_left.y) / height)), 0, m_grid.rows - 1);
+		return row * m_grid.columns + column;
+	}
+
+	void RegionNode::getRegionBounds(int region, Point& bot_left, Point& top_right) const
+	{
+		const Scalar width = (m_grid.top_right.x - m_grid.bot_left.x) / Scalar(m_grid.columns);
+		const Scalar height = (m_grid.top_right.y - m_grid.bot_left.y) / Scalar(m_grid.rows);
+
+		const int column = region % m_grid.columns;
+		const int row = region / m_grid.columns;
+		bot_left = Point{ m_grid.bot_left.x + width * Scalar(column), m_grid.bot_left.y + height * Scalar(row) };
+		top_right = Point{ bot_left.x + width, bot_left.y + height };
+	}
+
+	RegionNode::Neighbour& RegionNode::neighbourTowards(int region)
+	{
+		// Body which skipped a region is forwarded further by the neighbour on its next step
+		const int column = m_region % m_grid.columns;
+		const int row = m_region / m_grid.columns;
+		const int target_column = region % m_grid.columns;
+		const int target_row = region / m_grid.columns;
+
+		const int next = (row + (target_row > row) - (target_row < row)) * m_grid.columns +
+			column + (target_column > column) - (target_column < column);
+
+		auto it = std::find_if(std::begin(m_neighbours), std::end(m_neighbours),
+			[next](const Neighbour& neighbour) { return neighbour.region == next; });
+		assert(it != std::end(m_neighbours));
+		return *it;
+	}
+
+	void RegionNode::sortOwnedBodies()
+	{
+		for (auto& neighbour : m_neighbours)
+		{
+			neighbour.handoffs.clear();
+			neighbour.ghosts.clear();
+		}
+
+		const Scalar margin = m_grid.ghost_margin;
+
+		size_t kept = 0;
+		for (size_t i = 0; i < m_owned.size(); ++i)
+		{
+			const BodyPtr& body = m_owned[i];
+			const Point position = body->GetPosition();
+
+			const int region = regionOf(position);
+			if (region != m_region)
+			{
+				neighbourTowards(region).handoffs.push_back(body->GetState());
+				m_engine.RemoveBody(body);
+				continue;
+			}
+
+			// Most of bodies are far from borders
+			const bool inner = position.x - margin > m_botLeft.x && position.x + margin < m_topRight.x &&
+				position.y - margin > m_botLeft.y && position.y + margin < m_topRight.y;
+			if (!inner)
+			{
+				// Ghost keeps its mass, so contact impulse is split between bodies as if both were local
+				const BodyState ghost = body->GetState();
+
+				for (auto& neighbour : m_neighbours)
+				{
+					const Scalar dx = std::max(std::max(neighbour.bot_left.x - position.x, position.x - neighbour.top_right.x), Scalar(0));
+					const Scalar dy = std::max(std::max(neighbour.bot_left.y - position.y, position.y - neighbour.top_right.y), Scalar(0));
+					if (dx <= margin && dy <= margin)
+						neighbour.ghosts.push_back(ghost);
+				}
+			}
+
+			if (kept != i)
+				m_owned[kept] = std::move(m_owned[i]);
+			++kept;
+		}
+
+		m_owned.resize(kept);
+	}
+
+	bool RegionNode::sendMessages()
+	{
+		for (const auto& neighbour : m_neighbours)
+		{
+			RegionMessage header;
+			header.step = m_step;
+			header.handoffs = static_cast<uint32_t>(neighbour.handoffs.size());
+			header.ghosts = static_cast<uint32_t>(neighbour.ghosts.size());
+
+			m_buffer.clear();
+			writeHeader(m_buffer, header);
+			for (const auto& state : neighbour.handoffs)
+				writeState(m_buffer, state);
+			for (const auto& state : neighbour.ghosts)
+				writeState(m_buffer, state);
+
+			if (!m_transport->Send(neighbour.region, m_buffer.data(), m_buffer.size()))
+				return false;
+		}
+
+		return true;
+	}
+
+	bool RegionNode::receiveMessages()
+	{
+		size_t pending = m_neighbours.size();
+
+		// Message without full header is broken
+		auto read_step = [](const std::vector<uint8_t>& message, uint64_t& step)
+		{
+			RegionMessage header;
+			const uint8_t* data = message.data();
+			if (!readHeader(data, data + message.size(), header))
+				return false;
+			step = header.step;
+			return true;
+		};
+
+		// Messages of this step which came while waiting for previous one
+		for (auto it = std::begin(m_earlyMessages); it != std::end(m_earlyMessages);)
+		{
+			uint64_t step = 0;
+			if (!read_step(*it, step) || step != m_step)
+			{
+				++it;
+				continue;
+			}
+
+			if (!applyMessage(*it))
+				return false;
+			it = m_earlyMessages.erase(it);
+			--pending;
+		}
+
+		while (pending > 0)
+		{
+			int peer = -1;
+			uint64_t step = 0;
+			if (!m_transport->Receive(peer, m_buffer) || !read_step(m_buffer, step))
+				return false;
+
+			if (step != m_step)
+			{
+				m_earlyMessages.push_back(m_buffer);
+				continue;
+			}
+
+			if (!applyMessage(m_buffer))
+				return false;
+			--pending;
+		}
+
+		// Bodies which left margins of all neighbours
+		for (auto it = std::begin(m_ghosts); it != std::end(m_ghosts);)
+		{
+			if (it->second.step == m_step)
+			{
+				++it;
+				continue;
+			}
+
+			m_engine.RemoveBody(it->second.body);
+			it = m_ghosts.erase(it);
+		}
+
+		return true;
+	}
+
+	bool RegionNode::applyMessage(const std::vector<uint8_t>& message)
+	{
+		const uint8_t* data = message.data();
+		const uint8_t* const end = data + message.size();
+
+		RegionMessage header;
+		if (!readHeader(data, end, header))
+			return false;
+
+		// Whole message is checked before any state is applied
+		const size_t count = static_cast<size_t>(header.handoffs) + header.ghosts;
+		if (static_cast<size_t>(end - data) != count * kStateSize)
+			return false;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			BodyState state;
+			if (!readState(data, end, state))
+				return false;
+
+			auto ghost = m_ghosts.find(state.id);
+
+			if (i < header.handoffs)
+			{
+				// Ghost becomes the real body
+				if (ghost != std::end(m_ghosts))
+				{
+					m_engine.RemoveBody(ghost->second.body);
+					m_ghosts.erase(ghost);
+				}
+
+				BodyPtr body = IBody::CreateBody(state);
+				AddBody(body);
+				continue;
+			}
+
+			if (ghost != std::end(m_ghosts))
+			{
+				ghost->second.body->SetPosition(state.position);
+				ghost->second.body->SetVelocityVector(state.velocity);
+				ghost->second.step = m_step;
+				continue;
+			}
+
+			Ghost added = { IBody::CreateBody(state), m_step };
+			m_engine.AddBody(added.body);
+			m_ghosts.emplace(state.id, std::move(added));
+		}
+
+		return true;
+	}
+}
+
+RegionNodePtr IRegionNode::Create(IEngine& engine, const TransportPtr& transport, const RegionGrid& grid)
+{
+	assert(nullptr != transport);
+	return std::make_shared<RegionNode>(engine, transport, grid);
+}
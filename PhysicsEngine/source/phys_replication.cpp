@@ -0,0 +1,652 @@
+#include <phys_replication.h>
+#include <phys_engine.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+using namespace physic;
+
+namespace
+{
+	// Both sides keep this many snapshots to be used as baselines
+	const size_t kMaxSnapshots = 32;
+
+	// Sequences start from 1, zero baseline means full state
+	const uint32_t kNoBaseline = 0;
+
+	// First byte of packet: version in high bits, Scalar type in low ones.
+	// Scalars are sent as raw bytes, so packets of other Scalar type are rejected.
+	const uint8_t kPacketVersion = 1;
+	const uint8_t kScalarTag = static_cast<uint8_t>(kScalarKind);
+	const uint8_t kPacketFormat = static_cast<uint8_t>(kPacketVersion << 4 | kScalarTag);
+
+	// Flags of body record in packet
+	const uint8_t kBodyNew = 1 << 0;
+	const uint8_t kBodyPosition = 1 << 1;
+	const uint8_t kBodyVelocity = 1 << 2;
+	const uint8_t kBodyProperties = 1 << 3;
+
+	struct QuantizedBody
+	{
+		BodyId id;
+		int32_t position[2];
+		int32_t velocity[2];
+
+		// Rarely changed, sent only for new bodies and when changed
+		IBody::BodyType type;
+		ShapeId shape;
+		bool sensor;
+		CollisionFilter filter;
+		Scalar mass;
+		Scalar bounce_factor;
+	};
+
+	bool sameProperties(const QuantizedBody& l, const QuantizedBody& r)
+	{
+		return l.type == r.type && l.shape == r.shape && l.sensor == r.sensor && l.filter.category == r.filter.category &&
+			l.filter.mask == r.filter.mask && l.filter.group == r.filter.group &&
+			l.mass == r.mass && l.bounce_factor == r.bounce_factor;
+	}
+
+	bool lessId(const QuantizedBody& l, const QuantizedBody& r)
+	{
+		return l.id < r.id;
+	}
+
+	// Bodies sorted by id
+	struct Snapshot
+	{
+		uint32_t sequence;
+		std::vector<QuantizedBody> bodies;
+	};
+
+	// Values out of range of int32 saturate, NaN is sent as zero
+	int32_t quantize(Scalar value, Scalar precision)
+	{
+		const double scaled = std::round(static_cast<double>(value) / static_cast<double>(precision));
+		if (scaled != scaled)
+			return 0;
+
+		return static_cast<int32_t>(std::min(std::max(scaled, static_cast<double>(INT32_MIN)), static_cast<double>(INT32_MAX)));
+	}
+
+	Scalar dequantize(int32_t value, Scalar precision)
+	{
+		return static_cast<Scalar>(static_cast<double>(value) * static_cast<double>(precision));
+	}
+
+	QuantizedBody quantize(const BodyState& state, const ReplicationConfig& config)
+	{
+		QuantizedBody body;
+		body.id = state.id;
+		body.position[0] = quantize(state.position.x, config.position_precision);
+		body.position[1] = quantize(state.position.y, config.position_precision);
+		body.velocity[0] = quantize(state.velocity.x, config.velocity_precision);
+		body.velocity[1] = quantize(state.velocity.y, config.velocity_precision);
+		body.type = state.type;
+		body.shape = state.shape_id;
+		body.sensor = state.sensor;
+		body.filter = state.filter;
+		body.mass = state.mass;
+		body.bounce_factor = state.bounce_factor;
+		return body;
+	}
+
+	BodyState dequantize(const QuantizedBody& body, const ReplicationConfig& config)
+	{
+		BodyState state;
+		state.id = body.id;
+		state.type = body.type;
+		state.shape = IShape::ShapeType::Circle;
+		state.shape_id = body.shape;
+		state.position = Point{ dequantize(body.position[0], config.position_precision), dequantize(body.position[1], config.position_precision) };
+		state.velocity = fVec2D{ dequantize(body.velocity[0], config.velocity_precision), dequantize(body.velocity[1], config.velocity_precision) };
+		state.mass = body.mass;
+		state.bounce_factor = body.bounce_factor;
+		state.sensor = body.sensor;
+		state.filter = body.filter;
+		return state;
+	}
+
+	// Integers are written as LEB128 varints, signed ones zigzag encoded first
+	class PacketWriter
+	{
+	public:
+		explicit PacketWriter(std::vector<uint8_t>& packet) : m_packet(packet) {}
+
+		void byte(uint8_t value)
+		{
+			m_packet.push_back(value);
+		}
+
+		void varint(uint64_t value)
+		{
+			while (value >= 0x80)
+			{
+				m_packet.push_back(static_cast<uint8_t>(value | 0x80));
+				value >>= 7;
+			}
+			m_packet.push_back(static_cast<uint8_t>(value));
+		}
+
+		void zigzag(int64_t value)
+		{
+			varint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+		}
+
+		void scalar(Scalar value)
+		{
+			const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+			m_packet.insert(m_packet.end(), bytes, bytes + sizeof(value));
+		}
+
+	private:
+		std::vector<uint8_t>& m_packet;
+	};
+
+	class PacketReader
+	{
+	public:
+		PacketReader(const uint8_t* data, size_t size) : m_data(data), m_end(data + size) {}
+
+		bool atEnd() const
+		{
+			return m_data == m_end;
+		}
+
+		bool byte(uint8_t& value)
+		{
+			if (m_data == m_end)
+				return false;
+
+			value = *m_data++;
+			return true;
+		}
+
+		bool varint(uint64_t& value)
+		{
+			value = 0;
+			for (int shift = 0; shift < 64; shift += 7)
+			{
+				uint8_t part;
+				if (!byte(part))
+					return false;
+
+				value |= static_cast<uint64_t>(part & 0x7F) << shift;
+				if (0 == (part & 0x80))
+					return true;
+			}
+			return false;
+		}
+
+		bool zigzag(int64_t& value)
+		{
+			uint64_t raw;
+			if (!varint(raw))
+				return false;
+
+			value = static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+			return true;
+		}
+
+		bool scalar(Scalar& value)
+		{
+			if (static_cast<size_t>(m_end - m_data) < sizeof(value))
+				return false;
+
+			std::memcpy(&value, m_data, sizeof(value));
+			m_data += sizeof(value);
+			return true;
+		}
+
+	private:
+		const uint8_t* m_data;
+		const uint8_t* m_end;
+	};
+
+	void writeProperties(PacketWriter& writer, const QuantizedBody& body)
+	{
+		writer.byte(static_cast<uint8_t>(body.type));
+		writer.varint(body.shape);
+		writer.byte(body.sensor ? 1 : 0);
+		writer.varint(body.filter.category);
+		writer.varint(body.filter.mask);
+		writer.zigzag(body.filter.group);
+		writer.scalar(body.mass);
+		writer.scalar(body.bounce_factor);
+	}
+
+	bool readProperties(PacketReader& reader, QuantizedBody& body)
+	{
+		uint8_t type;
+		uint64_t shape;
+		uint8_t sensor;
+		uint64_t category;
+		uint64_t mask;
+		int64_t group;
+		if (!reader.byte(type) || !reader.varint(shape) || !reader.byte(sensor) || !reader.varint(category) || !reader.varint(mask) ||
+			!reader.zigzag(group) || !reader.scalar(body.mass) || !reader.scalar(body.bounce_factor))
+			return false;
+
+		if (type > static_cast<uint8_t>(IBody::BodyType::Kinematic) || shape > UINT32_MAX)
+			return false;
+
+		body.type = static_cast<IBody::BodyType>(type);
+		body.shape = static_cast<ShapeId>(shape);
+		body.sensor = sensor != 0;
+		body.filter.category = static_cast<uint16_t>(category);
+		body.filter.mask = static_cast<uint16_t>(mask);
+		body.filter.group = static_cast<int16_t>(group);
+		return true;
+	}
+
+	class ReplicationEncoder : public IReplicationEncoder
+	{
+	public:
+		explicit ReplicationEncoder(const ReplicationConfig& config)
+			: m_config(config)
+			, m_sequence(0)
+			, m_acknowledged(kNoBaseline)
+		{
+		}
+
+		virtual uint32_t Encode(const BodyState* states, size_t count, std::vector<uint8_t>& packet) override
+		{
+			assert(nullptr != states || 0 == count);
+
+			Snapshot current;
+			current.sequence = ++m_sequence;
+			current.bodies.reserve(count);
+			for (size_t i = 0; i < count; ++i)
+				current.bodies.push_back(quantize(states[i], m_config));
+			std::sort(std::begin(current.bodies), std::end(current.bodies), lessId);
+
+			static const std::vector<QuantizedBody> kEmpty;
+			const Snapshot* baseline = findSnapshot(m_acknowledged);
+			const std::vector<QuantizedBody>& base = nullptr != baseline ? baseline->bodies : kEmpty;
+
+			// Merge sorted bodies of baseline and current snapshot
+			m_updates.clear();
+			m_removed.clear();
+			auto prev = std::begin(base);
+			auto curr = std::begin(current.bodies);
+			while (prev != std::end(base) || curr != std::end(current.bodies))
+			{
+				if (curr == std::end(current.bodies) || (prev != std::end(base) && prev->id < curr->id))
+				{
+					m_removed.push_back((prev++)->id);
+					continue;
+				}
+
+				if (prev == std::end(base) || curr->id < prev->id)
+				{
+					m_updates.push_back({ &*curr++, nullptr, static_cast<uint8_t>(kBodyNew | kBodyPosition | kBodyVelocity | kBodyProperties) });
+					continue;
+				}
+
+				uint8_t flags = 0;
+				if (curr->position[0] != prev->position[0] || curr->position[1] != prev->position[1])
+					flags |= kBodyPosition;
+				if (curr->velocity[0] != prev->velocity[0] || curr->velocity[1] != prev->velocity[1])
+					flags |= kBodyVelocity;
+				if (!sameProperties(*curr, *prev))
+					flags |= kBodyProperties;
+
+				// Resting bodies are not sent at all
+				if (0 != flags)
+					m_updates.push_back({ &*curr, &*prev, flags });
+				++curr;
+				++prev;
+			}
+
+			PacketWriter writer(packet);
+			writer.byte(kPacketFormat);
+			writer.varint(current.sequence);
+			writer.varint(nullptr != baseline ? baseline->sequence : kNoBaseline);
+			writer.varint(m_updates.size());
+			writer.varint(m_removed.size());
+
+			// Ids are ascending, so only differences are written
+			BodyId last_id = 0;
+			for (const auto& update : m_updates)
+			{
+				const QuantizedBody& body = *update.body;
+				const int32_t zero[2] = { 0, 0 };
+				const int32_t* base_position = nullptr != update.base ? update.base->position : zero;
+				const int32_t* base_velocity = nullptr != update.base ? update.base->velocity : zero;
+
+				writer.varint(body.id - last_id);
+				last_id = body.id;
+				writer.byte(update.flags);
+
+				if (update.flags & kBodyProperties)
+					writeProperties(writer, body);
+				if (update.flags & kBodyPosition)
+				{
+					writer.zigzag(static_cast<int64_t>(body.position[0]) - base_position[0]);
+					writer.zigzag(static_cast<int64_t>(body.position[1]) - base_position[1]);
+				}
+				if (update.flags & kBodyVelocity)
+				{
+					writer.zigzag(static_cast<int64_t>(body.velocity[0]) - base_velocity[0]);
+					writer.zigzag(static_cast<int64_t>(body.velocity[1]) - base_velocity[1]);
+				}
+			}
+
+			last_id = 0;
+			for (BodyId id : m_removed)
+			{
+				writer.varint(id - last_id);
+				last_id = id;
+			}
+
+			m_snapshots.push_back(std::move(current));
+			if (m_snapshots.size() > kMaxSnapshots)
+			{
+				// Client is too far behind, next packet has full state
+				if (m_snapshots.front().sequence == m_acknowledged)
+					m_acknowledged = kNoBaseline;
+				m_snapshots.pop_front();
+			}
+
+			return m_sequence;
+		}
+
+		virtual void Acknowledge(uint32_t sequence) override
+		{
+			if (sequence <= m_acknowledged || nullptr == findSnapshot(sequence))
+				return;
+
+			m_acknowledged = sequence;
+
+			// Older snapshots will never be baselines again
+			while (m_snapshots.front().sequence < sequence)
+				m_snapshots.pop_front();
+		}
+
+	private:
+		struct Update
+		{
+			const QuantizedBody* body;
+			// nullptr for new bodies
+			const QuantizedBody* base;
+			uint8_t flags;
+		};
+
+		const Snapshot* findSnapshot(uint32_t sequence) const
+		{
+			if (kNoBaseline == sequence)
+				return nullptr;
+
+			for (const auto& snapshot : m_snapshots)
+				if (snapshot.sequence == sequence)
+					return &snapshot;
+			return nullptr;
+		}
+
+		ReplicationConfig m_config;
+		uint32_t m_sequence;
+		uint32_t m_acknowledged;
+		std::deque<Snapshot> m_snapshots;
+
+		std::vector<Update> m_updates;
+		std::vector<BodyId> m_removed;
+	};
+
+	class ReplicationDecoder : public IReplicationDecoder
+	{
+	public:
+		explicit ReplicationDecoder(const ReplicationConfig& config)
+			: m_config(config)
+		{
+		}
+
+		virtual bool Decode(const uint8_t* data, size_t size, IEngine& mirror, uint32_t& sequence) override
+		{
+			assert(nullptr != data || 0 == size);
+
+			PacketReader reader(data, size);
+			uint8_t format;
+			if (!reader.byte(format) || format != kPacketFormat)
+				return false;
+
+			uint64_t packet_sequence;
+			uint64_t baseline_sequence;
+			uint64_t update_count;
+			uint64_t removed_count;
+			if (!reader.varint(packet_sequence) || !reader.varint(baseline_sequence) ||
+				!reader.varint(update_count) || !reader.varint(removed_count))
+				return false;
+
+			const uint32_t last = m_snapshots.empty() ? kNoBaseline : m_snapshots.back().sequence;
+			if (packet_sequence <= last || packet_sequence > UINT32_MAX)
+				return false;
+
+			static const std::vector<QuantizedBody> kEmpty;
+			const Snapshot* baseline = findSnapshot(static_cast<uint32_t>(baseline_sequence));
+			if (kNoBaseline != baseline_sequence && nullptr == baseline)
+				return false;
+			const std::vector<QuantizedBody>& base = nullptr != baseline ? baseline->bodies : kEmpty;
+
+			if (!readUpdates(reader, base, update_count) || !readRemoved(reader, removed_count) || !reader.atEnd())
+				return false;
+
+			// New snapshot is baseline with updates and without removed bodies
+			Snapshot current;
+			current.sequence = static_cast<uint32_t>(packet_sequence);
+			current.bodies.reserve(base.size() + m_updates.size());
+
+			auto prev = std::begin(base);
+			auto update = std::begin(m_updates);
+			auto removed = std::begin(m_removed);
+			while (prev != std::end(base) || update != std::end(m_updates))
+			{
+				if (update == std::end(m_updates) || (prev != std::end(base) && prev->id < update->id))
+				{
+					while (removed != std::end(m_removed) && *removed < prev->id)
+						++removed;
+					if (removed == std::end(m_removed) || *removed != prev->id)
+						current.bodies.push_back(*prev);
+					++prev;
+					continue;
+				}
+
+				if (prev != std::end(base) && prev->id == update->id)
+					++prev;
+				current.bodies.push_back(*update++);
+			}
+
+			applyToMirror(current.bodies, mirror);
+
+			m_snapshots.push_back(std::move(current));
+			if (m_snapshots.size() > kMaxSnapshots)
+				m_snapshots.pop_front();
+
+			sequence = static_cast<uint32_t>(packet_sequence);
+			return true;
+		}
+
+	private:
+		const Snapshot* findSnapshot(uint32_t sequence) const
+		{
+			if (kNoBaseline == sequence)
+				return nullptr;
+
+			for (const auto& snapshot : m_snapshots)
+				if (snapshot.sequence == sequence)
+					return &snapshot;
+			return nullptr;
+		}
+
+		bool readUpdates(PacketReader& reader, const std::vector<QuantizedBody>& base, uint64_t count)
+		{
+			m_updates.clear();
+
+			uint64_t id = 0;
+			for (uint64_t i = 0; i < count; ++i)
+			{
+				uint64_t id_delta;
+				uint8_t flags;
+				if (!reader.varint(id_delta) || !reader.byte(flags))
+					return false;
+
+				id += id_delta;
+				if (id > UINT32_MAX || (i > 0 && 0 == id_delta))
+					return false;
+
+				QuantizedBody body = QuantizedBody();
+				body.id = static_cast<BodyId>(id);
+
+				if (0 == (flags & kBodyNew))
+				{
+					// Changed body starts from its baseline state
+					auto found = std::lower_bound(std::begin(base), std::end(base), body, lessId);
+					if (found == std::end(base) || found->id != body.id)
+						return false;
+					body = *found;
+				}
+				else if (0 == (flags & kBodyProperties))
+					return false;
+
+				if ((flags & kBodyProperties) && !readProperties(reader, body))
+					return false;
+
+				if ((flags & kBodyPosition) && !readDelta(reader, body.position))
+					return false;
+
+				if ((flags & kBodyVelocity) && !readDelta(reader, body.velocity))
+					return false;
+
+				m_updates.push_back(body);
+			}
+
+			return true;
+		}
+
+		bool readRemoved(PacketReader& reader, uint64_t count)
+		{
+			m_removed.clear();
+
+			uint64_t id = 0;
+			for (uint64_t i = 0; i < count; ++i)
+			{
+				uint64_t id_delta;
+				if (!reader.varint(id_delta))
+					return false;
+
+				id += id_delta;
+				if (id > UINT32_MAX)
+					return false;
+				m_removed.push_back(static_cast<BodyId>(id));
+			}
+
+			return true;
+		}
+
+		static bool readDelta(PacketReader& reader, int32_t value[2])
+		{
+			int64_t dx;
+			int64_t dy;
+			if (!reader.zigzag(dx) || !reader.zigzag(dy))
+				return false;
+
+			value[0] = static_cast<int32_t>(value[0] + dx);
+			value[1] = static_cast<int32_t>(value[1] + dy);
+			return true;
+		}
+
+		// Bodies are added, removed and get properties only where decoded snapshot differs from the previous
+		// one. Position and velocity are compared with the mirror body, which could be stepped meanwhile.
+		void applyToMirror(const std::vector<QuantizedBody>& bodies, IEngine& mirror)
+		{
+			static const std::vector<QuantizedBody> kEmpty;
+			const std::vector<QuantizedBody>& applied = m_snapshots.empty() ? kEmpty : m_snapshots.back().bodies;
+
+			auto prev = std::begin(applied);
+			auto curr = std::begin(bodies);
+			while (prev != std::end(applied) || curr != std::end(bodies))
+			{
+				if (curr == std::end(bodies) || (prev != std::end(applied) && prev->id < curr->id))
+				{
+					removeMirrored((prev++)->id, mirror);
+					continue;
+				}
+
+				if (prev == std::end(applied) || curr->id < prev->id)
+				{
+					addMirrored(*curr++, mirror);
+					continue;
+				}
+
+				auto found = m_mirrored.find(curr->id);
+				assert(found != std::end(m_mirrored));
+				const BodyPtr& body = found->second;
+				const BodyState state = dequantize(*curr, m_config);
+
+				if (curr->type != prev->type || curr->shape != prev->shape)
+				{
+					// Type and shape are fixed at creation
+					removeMirrored(curr->id, mirror);
+					addMirrored(*curr, mirror);
+				}
+				else
+				{
+					if (!sameProperties(*curr, *prev))
+					{
+						body->SetMass(Mass(state.mass));
+						body->SetBounceFactor(state.bounce_factor);
+						body->SetSensor(state.sensor);
+						body->SetCollisionFilter(state.filter);
+					}
+					if (body->GetPosition() != state.position)
+						body->SetPosition(state.position);
+					if (body->GetVelocityVector() != state.velocity)
+						body->SetVelocityVector(state.velocity);
+				}
+
+				++prev;
+				++curr;
+			}
+		}
+
+		void addMirrored(const QuantizedBody& quantized, IEngine& mirror)
+		{
+			BodyPtr body = IBody::CreateBody(dequantize(quantized, m_config));
+			mirror.AddBody(body);
+			m_mirrored[quantized.id] = body;
+		}
+
+		void removeMirrored(BodyId id, IEngine& mirror)
+		{
+			auto found = m_mirrored.find(id);
+			if (found == std::end(m_mirrored))
+				return;
+
+			mirror.RemoveBody(found->second);
+			m_mirrored.erase(found);
+		}
+
+		ReplicationConfig m_config;
+		std::deque<Snapshot> m_snapshots;
+		std::unordered_map<BodyId, BodyPtr> m_mirrored;
+
+		std::vector<QuantizedBody> m_updates;
+		std::vector<BodyId> m_removed;
+	};
+}
+
+ReplicationEncoderPtr IReplicationEncoder::Create(const ReplicationConfig& config)
+{
+	assert(config.position_precision > Scalar(0) && config.velocity_precision > Scalar(0));
+	return std::make_shared<ReplicationEncoder>(config);
+}
+
+ReplicationDecoderPtr IReplicationDecoder::Create(const ReplicationConfig& config)
+{
+	assert(config.position_precision > Scalar(0) && config.velocity_precision > Scalar(0));
+	return std::make_shared<ReplicationDecoder>(config);
+}
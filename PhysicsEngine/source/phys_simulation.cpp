@@ -0,0 +1,172 @@
+#include "phys_engine_impl.h"
+
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+using namespace physic;
+
+namespace
+{
+	// Simulation more than this many steps behind schedule skips them instead of catching up
+	const int kMaxLateSteps = 5;
+
+	// Released frames kept for refilling, the rest are freed
+	const size_t kFramePoolSize = 2;
+}
+
+std::future<void> EngineImpl::StepAsync(double dt)
+{
+	// Promise is shared, callbacks must be copyable
+	auto promise = std::make_shared<std::promise<void>>();
+	std::future<void> future = promise->get_future();
+	if (!StepAsync(dt, [promise]() { promise->set_value(); }))
+		promise->set_exception(std::make_exception_ptr(std::logic_error("simulation thread is running")));
+	return future;
+}
+
+bool EngineImpl::StepAsync(double dt, std::function<void()> done)
+{
+	assert(dt > 0);
+
+	// Both threads would step the engine at once
+	if (m_simulationRunning)
+		return false;
+
+	{
+		std::lock_guard<std::mutex> lock(m_stepMutex);
+		m_asyncSteps.push_back({ dt, std::move(done) });
+
+		// Completion of a step may request the next one from the worker itself,
+		// so the worker is checked and started under the same lock
+		if (!m_stepThread.joinable())
+			m_stepThread = std::thread(&EngineImpl::runSteps, this);
+	}
+	m_stepCondition.notify_one();
+
+	return true;
+}
+
+void EngineImpl::runSteps()
+{
+	std::unique_lock<std::mutex> lock(m_stepMutex);
+	while (true)
+	{
+		m_stepCondition.wait(lock, [this]() { return m_stepThreadStopping || !m_asyncSteps.empty(); });
+
+		// Requested steps are finished before stopping
+		if (m_asyncSteps.empty())
+			return;
+
+		AsyncStep step = std::move(m_asyncSteps.front());
+		m_asyncSteps.pop_front();
+		lock.unlock();
+
+		Step(step.dt);
+		publishFrame();
+
+		if (step.done)
+			step.done();
+
+		lock.lock();
+	}
+}
+
+void EngineImpl::stopStepThread()
+{
+	if (!m_stepThread.joinable())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_stepMutex);
+		m_stepThreadStopping = true;
+	}
+	m_stepCondition.notify_one();
+	m_stepThread.join();
+	m_stepThreadStopping = false;
+}
+
+void EngineImpl::StartSimulation(double dt)
+{
+	assert(dt > 0);
+
+	StopSimulation();
+	// Steps requested by StepAsync are finished first, they must not run along the simulation thread
+	stopStepThread();
+
+	m_simulationRunning = true;
+	m_simulationThread = std::thread(&EngineImpl::simulate, this, dt);
+}
+
+void EngineImpl::StopSimulation()
+{
+	m_simulationRunning = false;
+	if (m_simulationThread.joinable())
+		m_simulationThread.join();
+}
+
+FramePtr EngineImpl::GetFrame() const
+{
+	std::lock_guard<std::mutex> lock(m_frameMutex);
+	return m_frame;
+}
+
+void EngineImpl::simulate(double dt)
+{
+	using clock = std::chrono::steady_clock;
+	const auto period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(dt));
+
+	auto next_step = clock::now();
+	while (m_simulationRunning)
+	{
+		Step(dt);
+		publishFrame();
+
+		next_step += period;
+		const auto now = clock::now();
+		if (now - next_step > kMaxLateSteps * period)
+			next_step = now;
+
+		std::this_thread::sleep_until(next_step);
+	}
+}
+
+void EngineImpl::publishFrame()
+{
+	// Reuse a frame released by its last reader, readers may hold old frames as long as they like
+	std::unique_ptr<Frame> frame;
+	{
+		std::lock_guard<std::mutex> lock(m_framePool->mutex);
+		if (!m_framePool->frames.empty())
+		{
+			frame = std::move(m_framePool->frames.back());
+			m_framePool->frames.pop_back();
+		}
+	}
+
+	if (nullptr == frame)
+		frame = std::make_unique<Frame>();
+
+	frame->step = m_stepIndex;
+	frame->bodies.resize(m_bodies.size() + m_kinematicBodies.size() + m_staticBodies.size());
+	ExportBodies(frame->bodies.data(), frame->bodies.size());
+
+	// Deleter runs once the last reader drops the frame and hands it back to the pool
+	std::shared_ptr<FramePool> pool = m_framePool;
+	FramePtr published(frame.release(), [pool](const Frame* released)
+	{
+		std::unique_ptr<Frame> owned(const_cast<Frame*>(released));
+		std::lock_guard<std::mutex> lock(pool->mutex);
+		if (pool->frames.size() < kFramePoolSize)
+			pool->frames.push_back(std::move(owned));
+	});
+
+	// Previous frame is released outside the lock
+	{
+		std::lock_guard<std::mutex> lock(m_frameMutex);
+		m_frame.swap(published);
+	}
+}
@@ -0,0 +1,385 @@
+#include "phys_engine_impl.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace physic;
+
+namespace
+{
+	// Suffix of chunk files with a truncated record, they are kept aside and never read again
+	const char* const kDamagedSuffix = ".bad";
+
+	// Records are written field by field, so padding of BodyState never reaches the file.
+	// Files are read back only by a build with the same Scalar.
+	template <typename T>
+	void writeField(std::ostream& file, const T& value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "field must be trivially copyable");
+		file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+	}
+
+	template <typename T>
+	bool readField(std::istream& file, T& value)
+	{
+		return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(value)));
+	}
+
+	void writeState(std::ostream& file, const BodyState& state)
+	{
+		writeField(file, state.id);
+		writeField(file, static_cast<uint8_t>(state.type));
+		writeField(file, static_cast<uint8_t>(state.shape));
+		writeField(file, state.shape_id);
+		writeField(file, state.position.x);
+		writeField(file, state.position.y);
+		writeField(file, state.velocity.x);
+		writeField(file, state.velocity.y);
+		writeField(file, state.mass);
+		writeField(file, state.bounce_factor);
+		writeField(file, static_cast<uint8_t>(state.sensor));
+		writeField(file, state.filter.category);
+		writeField(file, state.filter.mask);
+		writeField(file, state.filter.group);
+	}
+
+	bool readState(std::istream& file, BodyState& state)
+	{
+		uint8_t type = 0;
+		uint8_t shape = 0;
+		uint8_t sensor = 0;
+		if (!(readField(file, state.id) && readField(file, type) && readField(file, shape) &&
+			readField(file, state.shape_id) && readField(file, state.position.x) && readField(file, state.position.y) &&
+			readField(file, state.velocity.x) && readField(file, state.velocity.y) && readField(file, state.mass) &&
+			readField(file, state.bounce_factor) && readField(file, sensor) && readField(file, state.filter.category) &&
+			readField(file, state.filter.mask) && readField(file, state.filter.group)))
+			return false;
+
+		state.type = static_cast<IBody::BodyType>(type);
+		state.shape = static_cast<IShape::ShapeType>(shape);
+		state.sensor = 0 != sensor;
+		return true;
+	}
+}
+
+void EngineImpl::SetActivityRegions(const ActivityRegion* regions, size_t count)
+{
+	assert(nullptr != regions || 0 == count);
+
+	m_activityRegions.assign(regions, regions + count);
+	m_activityChanged = true;
+}
+
+void EngineImpl::SetStreamingDirectory(const std::string& directory)
+{
+	m_streamingDirectory = directory;
+}
+
+void EngineImpl::SetChunkListener(IChunkListener* listener)
+{
+	m_chunkListener = listener;
+}
+
+void EngineImpl::updateActivity()
+{
+	// Whole world is active and nothing is left to wake up
+	if (m_activityRegions.empty() && !m_activityChanged)
+		return;
+
+	if (m_activityChanged)
+		wakeChunks();
+
+	bool frozen = freezeBodies(m_bodies, &m_bodyLod);
+	frozen = freezeBodies(m_kinematicBodies) || frozen;
+	if (frozen)
+		m_treeDirty = true;
+
+	// Static bodies never move, check them only when they or regions change
+	if ((m_activityChanged || m_staticTreeDirty) && freezeBodies(m_staticBodies))
+		m_staticTreeDirty = true;
+
+	m_activityChanged = false;
+
+	if (!m_streamingDirectory.empty())
+		streamOutChunks();
+}
+
+bool EngineImpl::isChunkActive(const ChunkCoord& coord) const
+{
+	if (m_activityRegions.empty())
+		return true;
+
+	Point bot_left;
+	Point top_right;
+	GetChunkBounds(coord, kWorldChunkSize, bot_left, top_right);
+
+	for (const auto& region : m_activityRegions)
+		if (bot_left.x <= region.top_right.x && region.bot_left.x <= top_right.x &&
+			bot_left.y <= region.top_right.y && region.bot_left.y <= top_right.y)
+			return true;
+
+	return false;
+}
+
+bool EngineImpl::freezeBodies(std::vector<BodyPtr>& bodies, std::vector<BodyLod>* lod)
+{
+	assert(nullptr == lod || lod->size() == bodies.size());
+
+	// Move bodies of inactive chunks out, keeping order of the rest
+	size_t kept = 0;
+	for (size_t i = 0; i < bodies.size(); ++i)
+	{
+		const ChunkCoord coord = GetChunkCoord(bodies[i]->GetPosition(), kWorldChunkSize);
+		if (!isChunkActive(coord))
+		{
+			// Jointed bodies still in active chunks must not move it
+			m_joints.freezeBody(bodies[i]);
+			m_frozenChunks[GetChunkKey(coord)].push_back(std::move(bodies[i]));
+			continue;
+		}
+
+		if (kept != i)
+		{
+			bodies[kept] = std::move(bodies[i]);
+			if (nullptr != lod)
+				(*lod)[kept] = (*lod)[i];
+		}
+		++kept;
+	}
+
+	const bool frozen = kept != bodies.size();
+	if (frozen)
+		m_membership.reset();
+
+	bodies.resize(kept);
+	if (nullptr != lod)
+		lod->resize(kept);
+	return frozen;
+}
+
+void EngineImpl::wakeChunks()
+{
+	for (auto it = std::begin(m_frozenChunks); it != std::end(m_frozenChunks);)
+	{
+		if (!isChunkActive(GetChunkCoord(it->first)))
+		{
+			++it;
+			continue;
+		}
+
+		for (auto& body : it->second)
+		{
+			AddBody(body);
+			m_joints.rebindBody(body);
+		}
+		it = m_frozenChunks.erase(it);
+		m_membership.reset();
+	}
+
+	std::vector<BodyPtr> loaded;
+	for (auto it = std::begin(m_streamedChunks); it != std::end(m_streamedChunks);)
+	{
+		if (!isChunkActive(GetChunkCoord(it->first)))
+		{
+			++it;
+			continue;
+		}
+
+		// Chunk which can't be opened stays on disk to be tried again
+		loaded.clear();
+		bool truncated = false;
+		if (!readChunk(it->second.path, loaded, truncated))
+		{
+			++it;
+			continue;
+		}
+
+		// Damaged file is reported once and kept aside, so it is never read again
+		const uint64_t key = it->first;
+		const std::string path = it->second.path;
+		it = m_streamedChunks.erase(it);
+		m_membership.reset();
+		if (truncated)
+		{
+			const std::string damaged = path + kDamagedSuffix;
+			std::remove(damaged.c_str());
+			if (0 != std::rename(path.c_str(), damaged.c_str()))
+				std::remove(path.c_str());
+
+			if (nullptr != m_chunkListener)
+				m_chunkListener->OnChunkDamaged(path);
+		}
+		else
+		{
+			retireChunkFile(key, path);
+		}
+
+		if (!m_removedStreamed.empty())
+			loaded.erase(std::remove_if(std::begin(loaded), std::end(loaded),
+				[this](const BodyPtr& body) { return m_removedStreamed.erase(body->GetId()) != 0; }), std::end(loaded));
+
+		// Joints of streamed bodies still hold the old objects
+		for (auto& body : loaded)
+		{
+			AddBody(body);
+			m_joints.rebindBody(body);
+		}
+
+		if (nullptr != m_chunkListener && !loaded.empty())
+			m_chunkListener->OnBodiesLoaded(loaded.data(), loaded.size());
+	}
+}
+
+void EngineImpl::streamOutChunks()
+{
+	for (auto it = std::begin(m_frozenChunks); it != std::end(m_frozenChunks);)
+	{
+		if (it->second.empty())
+		{
+			it = m_frozenChunks.erase(it);
+			continue;
+		}
+
+		// Bodies entering already streamed chunk are appended to its file
+		auto streamed = m_streamedChunks.find(it->first);
+		const bool append = streamed != std::end(m_streamedChunks);
+		const std::string path = append ? streamed->second.path : chunkFilePath(it->first);
+
+		// Chunk which failed to be written is kept in memory
+		uint64_t size = 0;
+		if (!writeChunk(path, append, it->second, size))
+		{
+			++it;
+			continue;
+		}
+
+		m_streamedChunks[it->first] = { path, size };
+		m_membership.reset();
+
+		if (nullptr != m_chunkListener)
+			m_chunkListener->OnBodiesUnloaded(it->second.data(), it->second.size());
+
+		it = m_frozenChunks.erase(it);
+	}
+}
+
+bool EngineImpl::writeChunk(const std::string& path, bool append, const std::vector<BodyPtr>& bodies, uint64_t& size) const
+{
+	std::ofstream file(path, std::ios::binary | (append ? std::ios::app : std::ios::trunc));
+	if (!file)
+		return false;
+
+	for (const auto& body : bodies)
+		writeState(file, body->GetState());
+
+	if (!file.flush())
+		return false;
+
+	size = static_cast<uint64_t>(file.tellp());
+	return true;
+}
+
+bool EngineImpl::readChunk(const std::string& path, std::vector<BodyPtr>& bodies, bool& truncated) const
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+
+	BodyState state;
+	std::streampos record_end = 0;
+	while (readState(file, state))
+	{
+		bodies.push_back(IBody::CreateBody(state));
+		record_end = file.tellg();
+	}
+
+	// Anything after the last whole record is a truncated one
+	file.clear();
+	file.seekg(0, std::ios::end);
+	truncated = file.tellg() != record_end;
+	return true;
+}
+
+std::string EngineImpl::chunkFilePath(uint64_t key)
+{
+	const ChunkCoord coord = GetChunkCoord(key);
+
+	std::string path = m_streamingDirectory;
+	if (path.back() != '/' && path.back() != '\\')
+		path += '/';
+
+	return path + "chunk_" + std::to_string(coord.x) + "_" + std::to_string(coord.y) + "_" +
+		std::to_string(m_chunkFileCount++) + ".bin";
+}
+
+void EngineImpl::retireChunkFile(uint64_t key, const std::string& path)
+{
+	if (0 == m_checkpointCount)
+		std::remove(path.c_str());
+	else
+		m_retiredChunks.push_back({ key, path, m_stepIndex });
+}
+
+void EngineImpl::deleteRetiredChunkFiles()
+{
+	uint64_t oldest = UINT64_MAX;
+	for (const auto& checkpoint : m_checkpoints)
+		oldest = std::min(oldest, checkpoint.step);
+
+	// Checkpoints of later steps have seen the chunk in memory
+	for (auto it = std::begin(m_retiredChunks); it != std::end(m_retiredChunks);)
+	{
+		if (it->step < oldest)
+		{
+			std::remove(it->path.c_str());
+			it = m_retiredChunks.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+void EngineImpl::restoreChunkFiles(const std::unordered_map<uint64_t, StreamedChunk>& streamed, uint64_t step)
+{
+	auto isStreamed = [&streamed](uint64_t key, const std::string& path)
+	{
+		auto found = streamed.find(key);
+		return found != std::end(streamed) && found->second.path == path;
+	};
+
+	// Files written since the checkpoint hold bodies which are in memory again
+	for (const auto& chunk : m_streamedChunks)
+		if (!isStreamed(chunk.first, chunk.second.path))
+			std::remove(chunk.second.path.c_str());
+
+	// Files read back since the checkpoint are streamed again, the rest was written after it
+	for (auto it = std::begin(m_retiredChunks); it != std::end(m_retiredChunks);)
+	{
+		if (it->step < step)
+		{
+			++it;
+			continue;
+		}
+
+		if (!isStreamed(it->key, it->path))
+			std::remove(it->path.c_str());
+		it = m_retiredChunks.erase(it);
+	}
+
+	// Records appended since the checkpoint are cut off
+	for (const auto& chunk : streamed)
+	{
+		std::error_code error;
+		const uintmax_t size = std::filesystem::file_size(chunk.second.path, error);
+		if (!error && size > chunk.second.size)
+			std::filesystem::resize_file(chunk.second.path, chunk.second.size, error);
+	}
+
+	m_streamedChunks = streamed;
+}
@@ -0,0 +1,214 @@
+#include "phys_terrain_grid.h"
+#include "phys_engine_impl.h"
+
+#include <algorithm>
+
+using namespace physic;
+
+Terrain::Terrain(Scalar cell_size)
+	: m_cellSize(cell_size)
+	, m_nextId(0)
+	, m_dirty(false)
+	, m_stamp(0)
+{
+	assert(cell_size > Scalar(0));
+}
+
+TerrainId Terrain::addChain(const Point* points, size_t count, bool closed)
+{
+	assert(nullptr != points || 0 == count);
+
+	const TerrainId id = m_nextId++;
+	if (count < 2)
+		return id;
+
+	const size_t first = m_segments.size();
+	for (size_t i = 0; i + 1 < count; ++i)
+		m_segments.push_back({ points[i], points[i + 1], id, Point(), Point(), false, false });
+
+	if (closed && count > 2)
+		m_segments.push_back({ points[count - 1], points[0], id, Point(), Point(), false, false });
+
+	// Link neighbours, last segment of closed chain is followed by the first one
+	const size_t last = m_segments.size() - 1;
+	for (size_t i = first; i <= last; ++i)
+	{
+		Segment& segment = m_segments[i];
+		if (i > first || closed)
+		{
+			segment.before = m_segments[i > first ? i - 1 : last].a;
+			segment.has_before = true;
+		}
+		if (i < last || closed)
+		{
+			segment.after = m_segments[i < last ? i + 1 : first].b;
+			segment.has_after = true;
+		}
+	}
+
+	m_dirty = true;
+	return id;
+}
+
+TerrainId Terrain::addHeightfield(const Point& origin, Scalar spacing, const Scalar* heights, size_t count)
+{
+	assert(spacing > Scalar(0));
+	assert(nullptr != heights || 0 == count);
+
+	const TerrainId id = m_nextId++;
+	if (count < 2)
+		return id;
+
+	Field field;
+	field.id = id;
+	field.origin = origin;
+	field.spacing = spacing;
+	field.heights.assign(heights, heights + count);
+	m_fields.push_back(std::move(field));
+	return id;
+}
+
+bool Terrain::remove(TerrainId id)
+{
+	const size_t segments = m_segments.size();
+	m_segments.erase(std::remove_if(std::begin(m_segments), std::end(m_segments),
+		[id](const Segment& segment) { return segment.id == id; }), std::end(m_segments));
+
+	const size_t fields = m_fields.size();
+	m_fields.erase(std::remove_if(std::begin(m_fields), std::end(m_fields),
+		[id](const Field& field) { return field.id == id; }), std::end(m_fields));
+
+	if (segments != m_segments.size())
+		m_dirty = true;
+
+	return segments != m_segments.size() || fields != m_fields.size();
+}
+
+void Terrain::build()
+{
+	if (!m_dirty)
+		return;
+
+	m_cells.clear();
+	m_stamps.assign(m_segments.size(), 0);
+	m_stamp = 0;
+
+	// Segment goes to every cell its bounding box overlaps
+	for (size_t index = 0; index < m_segments.size(); ++index)
+	{
+		const Segment& segment = m_segments[index];
+		const ChunkCoord low = GetChunkCoord(Point{ std::min(segment.a.x, segment.b.x), std::min(segment.a.y, segment.b.y) }, m_cellSize);
+		const ChunkCoord high = GetChunkCoord(Point{ std::max(segment.a.x, segment.b.x), std::max(segment.a.y, segment.b.y) }, m_cellSize);
+
+		for (int32_t x = low.x; x <= high.x; ++x)
+			for (int32_t y = low.y; y <= high.y; ++y)
+				m_cells[GetChunkKey({ x, y })].push_back(static_cast<uint32_t>(index));
+	}
+
+	m_dirty = false;
+}
+
+bool Terrain::collideSegment(const Point& a, const Point& b, const Point& center, Scalar radius,
+	fVec2D& normal, Scalar& depth)
+{
+	const fVec2D segment = b - a;
+	const Scalar length_sq = SquaredNorm(segment);
+	if (length_sq <= Scalar(0))
+		return false;
+
+	const Scalar t = DotProduct(center - a, segment) / length_sq;
+	if (t < Scalar(0) || t >= Scalar(1))
+		return false;
+
+	const Point closest = a + segment * t;
+	const fVec2D offset = center - closest;
+	const Scalar distance_sq = SquaredNorm(offset);
+	if (distance_sq >= radius * radius)
+		return false;
+
+	const Scalar distance = EuclideanNorm(offset);
+	if (distance > Scalar(0))
+		normal = offset / distance;
+	else
+		// Center right on segment, push it to either side
+		normal = Normalized(fVec2D{ -segment.y, segment.x });
+
+	depth = radius - distance;
+	return true;
+}
+
+bool Terrain::collideSurface(const Point& a, const Point& b, const Point& center, Scalar radius,
+	fVec2D& normal, Scalar& depth)
+{
+	const fVec2D segment = b - a;
+	const fVec2D up = Normalized(fVec2D{ -segment.y, segment.x });
+	const Scalar height = DotProduct(center - a, up);
+	if (height >= radius)
+		return false;
+
+	const Scalar t = DotProduct(center - a, segment) / SquaredNorm(segment);
+	if (t < Scalar(0) || t >= Scalar(1))
+		return false;
+
+	// Over or under the segment, even center below ground is pushed up
+	normal = up;
+	depth = radius - height;
+	return true;
+}
+
+bool Terrain::collideCorner(const Point& corner, const Point* before, const Point* after, bool surface,
+	const Point& center, Scalar radius, fVec2D& normal, Scalar& depth)
+{
+	const fVec2D offset = center - corner;
+	if (nullptr != before)
+	{
+		const fVec2D segment = corner - *before;
+		if (DotProduct(offset, segment) < Scalar(0))
+			return false;
+		if (surface && DotProduct(offset, fVec2D{ -segment.y, segment.x }) < Scalar(0))
+			return false;
+	}
+
+	if (nullptr != after)
+	{
+		const fVec2D segment = *after - corner;
+		if (DotProduct(offset, segment) >= Scalar(0))
+			return false;
+		if (surface && DotProduct(offset, fVec2D{ -segment.y, segment.x }) < Scalar(0))
+			return false;
+	}
+
+	const Scalar distance_sq = SquaredNorm(offset);
+	if (distance_sq >= radius * radius)
+		return false;
+
+	const Scalar distance = EuclideanNorm(offset);
+	if (distance > Scalar(0))
+	{
+		normal = offset / distance;
+	}
+	else
+	{
+		// Center right on corner, push it out of either neighbour
+		const fVec2D segment = nullptr != before ? corner - *before : *after - corner;
+		normal = Normalized(fVec2D{ -segment.y, segment.x });
+	}
+
+	depth = radius - distance;
+	return true;
+}
+
+TerrainId EngineImpl::AddSegmentChain(const Point* points, size_t count, bool closed)
+{
+	return m_terrain.addChain(points, count, closed);
+}
+
+TerrainId EngineImpl::AddHeightfield(const Point& origin, Scalar spacing, const Scalar* heights, size_t count)
+{
+	return m_terrain.addHeightfield(origin, spacing, heights, count);
+}
+
+bool EngineImpl::RemoveTerrain(TerrainId id)
+{
+	return m_terrain.remove(id);
+}
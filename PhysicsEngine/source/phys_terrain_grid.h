@@ -0,0 +1,161 @@
+#ifndef PHYS_TERRAIN_GRID_H
+#define PHYS_TERRAIN_GRID_H
+
+#include <phys_terrain.h>
+#include <phys_chunktree.h>
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+
+namespace physic
+{
+	// Segments of chains are indexed by a hash grid, heightfields are looked up by x directly
+	class Terrain
+	{
+	public:
+		explicit Terrain(Scalar cell_size);
+
+		TerrainId addChain(const Point* points, size_t count, bool closed);
+		TerrainId addHeightfield(const Point& origin, Scalar spacing, const Scalar* heights, size_t count);
+		bool remove(TerrainId id);
+
+		bool empty() const { return m_segments.empty() && m_fields.empty(); }
+
+		// Grid is refilled only after terrain was added or removed
+		void build();
+
+		// Call visit(normal, depth) for every piece of terrain overlapping circle.
+		// Normal points out of terrain, moving circle by normal * depth separates it.
+		template <class Visit>
+		void collide(const Point& center, Scalar radius, Visit& visit)
+		{
+			Scalar depth;
+			fVec2D normal;
+
+			if (!m_cells.empty())
+			{
+				// Segment crossing several cells is tested once
+				if (0 == ++m_stamp)
+				{
+					std::fill(m_stamps.begin(), m_stamps.end(), 0);
+					m_stamp = 1;
+				}
+
+				const ChunkCoord low = GetChunkCoord(Point{ center.x - radius, center.y - radius }, m_cellSize);
+				const ChunkCoord high = GetChunkCoord(Point{ center.x + radius, center.y + radius }, m_cellSize);
+				for (int32_t x = low.x; x <= high.x; ++x)
+					for (int32_t y = low.y; y <= high.y; ++y)
+					{
+						auto cell = m_cells.find(GetChunkKey({ x, y }));
+						if (cell == m_cells.end())
+							continue;
+
+						for (const uint32_t index : cell->second)
+						{
+							if (m_stamps[index] == m_stamp)
+								continue;
+							m_stamps[index] = m_stamp;
+
+							// Shared corner is tested by the segment starting at it only
+							const Segment& segment = m_segments[index];
+							if (collideSegment(segment.a, segment.b, center, radius, normal, depth))
+								visit(normal, depth);
+							if (collideCorner(segment.a, segment.has_before ? &segment.before : nullptr, &segment.b,
+								false, center, radius, normal, depth))
+								visit(normal, depth);
+							if (!segment.has_after && collideCorner(segment.b, &segment.a, nullptr,
+								false, center, radius, normal, depth))
+								visit(normal, depth);
+						}
+					}
+			}
+
+			for (const auto& field : m_fields)
+			{
+				const double spacing = static_cast<double>(field.spacing);
+				const double from = (static_cast<double>(center.x - radius - field.origin.x)) / spacing;
+				const double to = (static_cast<double>(center.x + radius - field.origin.x)) / spacing;
+				const double last = static_cast<double>(field.heights.size() - 1);
+				if (to < 0 || from >= last)
+					continue;
+
+				const size_t first = static_cast<size_t>(std::max(0., std::floor(from)));
+				const size_t end = static_cast<size_t>(std::min(last, std::ceil(to)));
+				for (size_t i = first; i < end; ++i)
+				{
+					const Point a = field.point(i);
+					const Point b = field.point(i + 1);
+					if (collideSurface(a, b, center, radius, normal, depth))
+						visit(normal, depth);
+				}
+
+				for (size_t i = first; i <= end; ++i)
+				{
+					const Point before = 0 == i ? Point() : field.point(i - 1);
+					const Point after = field.heights.size() == i + 1 ? Point() : field.point(i + 1);
+					if (collideCorner(field.point(i), 0 == i ? nullptr : &before,
+						field.heights.size() == i + 1 ? nullptr : &after, true, center, radius, normal, depth))
+						visit(normal, depth);
+				}
+			}
+		}
+
+	private:
+		struct Segment
+		{
+			Point a;
+			Point b;
+			TerrainId id;
+			// Neighbour points of chain, corners shared with neighbours are tested once
+			Point before;
+			Point after;
+			bool has_before;
+			bool has_after;
+		};
+
+		struct Field
+		{
+			TerrainId id;
+			Point origin;
+			Scalar spacing;
+			std::vector<Scalar> heights;
+
+			Point point(size_t index) const
+			{
+				return Point{ origin.x + spacing * Scalar(static_cast<int>(index)), origin.y + heights[index] };
+			}
+		};
+
+		// Pieces of terrain don't overlap: segments own circles with center beside them, corners own
+		// the rest, so a circle resting on a vertex of straight ground is pushed straight out of it.
+
+		// Two-sided segment from a to b, for centers beside [a, b)
+		static bool collideSegment(const Point& a, const Point& b, const Point& center, Scalar radius,
+			fVec2D& normal, Scalar& depth);
+		// One-sided segment of surface from left to right, solid below it, for centers beside [a, b)
+		static bool collideSurface(const Point& a, const Point& b, const Point& center, Scalar radius,
+			fVec2D& normal, Scalar& depth);
+		// Corner between segments from before and to after, nullptr for end of chain, for centers beside neither
+		// of them. Corner of surface is solid only seen from above.
+		static bool collideCorner(const Point& corner, const Point* before, const Point* after, bool surface,
+			const Point& center, Scalar radius, fVec2D& normal, Scalar& depth);
+
+		Scalar m_cellSize;
+		TerrainId m_nextId;
+
+		std::vector<Segment> m_segments;
+		std::vector<Field> m_fields;
+
+		// Indices of segments overlapping cell by cell key
+		std::unordered_map<uint64_t, std::vector<uint32_t>> m_cells;
+		bool m_dirty;
+
+		// Last query each segment was tested by
+		std::vector<uint32_t> m_stamps;
+		uint32_t m_stamp;
+	};
+} // namespace physic
+
+#endif // PHYS_TERRAIN_GRID_H
@@ -0,0 +1,97 @@
+#include "phys_engine_impl.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace physic;
+
+namespace
+{
+	// Part of radius a body may travel in one substep
+	const double kMaxTravel = 0.5;
+
+	// Overlap relative to the smaller radius substep is shrunk above
+	const double kMaxPenetration = 0.25;
+}
+
+void EngineImpl::SetAdaptiveStep(double min_dt, double max_dt)
+{
+	// Zero substep would never finish the step
+	assert(max_dt == 0 || (min_dt > 0 && max_dt >= min_dt));
+
+	m_minStep = min_dt > 0 ? std::min(min_dt, max_dt) : max_dt;
+	m_maxStep = max_dt;
+}
+
+StepStats EngineImpl::GetStepStats() const
+{
+	return m_stepStats;
+}
+
+void EngineImpl::Step(double dt)
+{
+	m_stepStats.dt = dt;
+	m_stepStats.substeps = 0;
+	m_stepStats.min_substep = dt;
+	m_stepStats.max_substep = 0;
+	m_stepStats.max_speed = Scalar(0);
+	m_stepStats.max_penetration = Scalar(0);
+
+	if (m_maxStep <= 0)
+	{
+		m_stepStats.substeps = 1;
+		m_stepStats.max_substep = dt;
+		stepOnce(dt);
+		m_stepStats.max_penetration = m_maxPenetration;
+		return;
+	}
+
+	double remaining = dt;
+	while (remaining > 0)
+	{
+		// Split the rest evenly, so there is no tiny last substep
+		const double substep = std::max(m_minStep, chooseSubstep());
+		const double count = std::ceil(remaining / substep - 1e-9);
+		const double current = count > 1 ? remaining / count : remaining;
+
+		stepOnce(current);
+		remaining -= current;
+
+		++m_stepStats.substeps;
+		m_stepStats.min_substep = std::min(m_stepStats.min_substep, current);
+		m_stepStats.max_substep = std::max(m_stepStats.max_substep, current);
+		m_stepStats.max_penetration = std::max(m_stepStats.max_penetration, m_maxPenetration);
+	}
+}
+
+double EngineImpl::chooseSubstep()
+{
+	// Fastest body relative to its size, squared to take root only once
+	Scalar max_ratio_sq = Scalar(0);
+	auto check = [&max_ratio_sq](const std::vector<BodyPtr>& bodies)
+	{
+		for (const auto& body : bodies)
+		{
+			const Scalar radius = body->GetRadius();
+			if (radius <= Scalar(0))
+				continue;
+
+			const Scalar speed_sq = SquaredNorm(body->GetVelocityVector());
+			max_ratio_sq = std::max(max_ratio_sq, speed_sq / (radius * radius));
+		}
+	};
+	check(m_bodies);
+	check(m_kinematicBodies);
+
+	const double max_ratio = std::sqrt(static_cast<double>(max_ratio_sq));
+	m_stepStats.max_speed = std::max(m_stepStats.max_speed, static_cast<Scalar>(max_ratio));
+
+	double substep = max_ratio > 0 ? kMaxTravel / max_ratio : m_maxStep;
+
+	// Contacts of last substep overlapped too deep, velocities alone let bodies sink into each other
+	const double penetration = static_cast<double>(m_maxPenetration);
+	if (penetration > kMaxPenetration)
+		substep *= kMaxPenetration / penetration;
+
+	return Clip(substep, m_minStep, m_maxStep);
+}
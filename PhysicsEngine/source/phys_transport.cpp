@@ -0,0 +1,492 @@
+#include <phys_transport.h>
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#include <cerrno>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using namespace physic;
+
+namespace
+{
+	// Inbox of every node, shared by all local transports
+	struct LocalHub
+	{
+		struct Inbox
+		{
+			std::mutex mutex;
+			std::condition_variable ready;
+			std::deque<std::pair<int, std::vector<uint8_t>>> messages;
+		};
+
+		explicit LocalHub(int count) : inboxes(count) {}
+
+		std::vector<Inbox> inboxes;
+	};
+
+	class LocalTransport : public ITransport
+	{
+	public:
+		LocalTransport(std::shared_ptr<LocalHub> hub, int self)
+			: m_hub(std::move(hub))
+			, m_self(self)
+		{
+		}
+
+		virtual int GetSelf() const override
+		{
+			return m_self;
+		}
+
+		virtual int GetPeerCount() const override
+		{
+			return static_cast<int>(m_hub->inboxes.size());
+		}
+
+		virtual bool Send(int peer, const void* data, size_t size) override
+		{
+			assert(peer >= 0 && peer < GetPeerCount());
+			assert(nullptr != data || 0 == size);
+
+			const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+			LocalHub::Inbox& inbox = m_hub->inboxes[peer];
+			{
+				std::lock_guard<std::mutex> lock(inbox.mutex);
+				inbox.messages.emplace_back(m_self, std::vector<uint8_t>(bytes, bytes + size));
+			}
+			inbox.ready.notify_one();
+			return true;
+		}
+
+		virtual bool Receive(int& peer, std::vector<uint8_t>& message) override
+		{
+			LocalHub::Inbox& inbox = m_hub->inboxes[m_self];
+
+			std::unique_lock<std::mutex> lock(inbox.mutex);
+			inbox.ready.wait(lock, [&inbox] { return !inbox.messages.empty(); });
+
+			peer = inbox.messages.front().first;
+			message = std::move(inbox.messages.front().second);
+			inbox.messages.pop_front();
+			return true;
+		}
+
+	private:
+		std::shared_ptr<LocalHub> m_hub;
+		int m_self;
+	};
+
+#ifdef _WIN32
+	using Socket = SOCKET;
+	const Socket kNoSocket = INVALID_SOCKET;
+	const int kSendFlags = 0;
+	const int kShutdownBoth = SD_BOTH;
+
+	// Winsock is started once and never cleaned up, sockets may live until exit
+	bool startSockets()
+	{
+		static const bool started = []
+		{
+			WSADATA data;
+			return ::WSAStartup(MAKEWORD(2, 2), &data) == 0;
+		}();
+		return started;
+	}
+
+	void closeSocket(Socket socket)
+	{
+		::closesocket(socket);
+	}
+
+	int pollSockets(pollfd* fds, size_t count)
+	{
+		return ::WSAPoll(fds, static_cast<ULONG>(count), -1);
+	}
+
+	bool interrupted()
+	{
+		return false;
+	}
+#else
+	using Socket = int;
+	const Socket kNoSocket = -1;
+	const int kSendFlags = MSG_NOSIGNAL;
+	const int kShutdownBoth = SHUT_RDWR;
+
+	bool startSockets()
+	{
+		return true;
+	}
+
+	void closeSocket(Socket socket)
+	{
+		::close(socket);
+	}
+
+	int pollSockets(pollfd* fds, size_t count)
+	{
+		return ::poll(fds, static_cast<nfds_t>(count), -1);
+	}
+
+	bool interrupted()
+	{
+		return errno == EINTR;
+	}
+#endif
+
+	// Time given to other nodes to start listening
+	const auto kConnectTimeout = std::chrono::seconds(30);
+	const auto kConnectRetryDelay = std::chrono::milliseconds(10);
+
+	// Address is "host:port", port after the last colon
+	addrinfo* resolve(const std::string& address, bool passive)
+	{
+		const size_t colon = address.rfind(':');
+		if (colon == std::string::npos)
+			return nullptr;
+
+		const std::string host = address.substr(0, colon);
+		const std::string port = address.substr(colon + 1);
+
+		addrinfo hints = addrinfo();
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = SOCK_STREAM;
+		hints.ai_protocol = IPPROTO_TCP;
+		hints.ai_flags = passive ? AI_PASSIVE : 0;
+
+		addrinfo* result = nullptr;
+		if (::getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &result) != 0)
+			return nullptr;
+		return result;
+	}
+
+	bool writeAll(Socket socket, const void* data, size_t size)
+	{
+		const char* bytes = static_cast<const char*>(data);
+		while (size > 0)
+		{
+			const int chunk = static_cast<int>(std::min<size_t>(size, INT_MAX));
+			const auto written = ::send(socket, bytes, chunk, kSendFlags);
+			if (written < 0 && interrupted())
+				continue;
+			if (written <= 0)
+				return false;
+
+			bytes += written;
+			size -= static_cast<size_t>(written);
+		}
+		return true;
+	}
+
+	bool readAll(Socket socket, void* data, size_t size)
+	{
+		char* bytes = static_cast<char*>(data);
+		while (size > 0)
+		{
+			const int chunk = static_cast<int>(std::min<size_t>(size, INT_MAX));
+			const auto read = ::recv(socket, bytes, chunk, 0);
+			if (read < 0 && interrupted())
+				continue;
+			if (read <= 0)
+				return false;
+
+			bytes += read;
+			size -= static_cast<size_t>(read);
+		}
+		return true;
+	}
+
+	// Full mesh of TCP connections, every message is prefixed by its size.
+	// Dedicated thread reads all peers into inbox as soon as data arrives, so a blocked Send
+	// is always drained by the peer and nodes sending to each other at once don't deadlock.
+	class SocketTransport : public ITransport
+	{
+	public:
+		SocketTransport(int self, int count)
+			: m_self(self)
+			, m_peers(count, kNoSocket)
+			, m_broken(false)
+		{
+		}
+
+		virtual ~SocketTransport()
+		{
+			// Receiving thread sees closed connections and stops
+			for (Socket socket : m_peers)
+				if (socket != kNoSocket)
+					::shutdown(socket, kShutdownBoth);
+
+			if (m_receiver.joinable())
+				m_receiver.join();
+
+			for (Socket socket : m_peers)
+				if (socket != kNoSocket)
+					closeSocket(socket);
+		}
+
+		SocketTransport(const SocketTransport&) = delete;
+		SocketTransport& operator=(const SocketTransport&) = delete;
+
+		// Lower nodes are connected to, higher ones are accepted from
+		bool connect(const std::vector<std::string>& addresses)
+		{
+			if (!startSockets())
+				return false;
+
+			const Socket listener = listen(addresses[m_self]);
+			if (listener == kNoSocket)
+				return false;
+
+			bool connected = true;
+			for (int peer = 0; connected && peer < m_self; ++peer)
+				connected = connectTo(addresses[peer], peer);
+
+			for (int accepted = m_self + 1; connected && accepted < static_cast<int>(m_peers.size()); ++accepted)
+				connected = acceptFrom(listener);
+
+			closeSocket(listener);
+			if (!connected)
+				return false;
+
+			m_receiver = std::thread(&SocketTransport::receiveLoop, this);
+			return true;
+		}
+
+		virtual int GetSelf() const override
+		{
+			return m_self;
+		}
+
+		virtual int GetPeerCount() const override
+		{
+			return static_cast<int>(m_peers.size());
+		}
+
+		virtual bool Send(int peer, const void* data, size_t size) override
+		{
+			assert(peer >= 0 && peer < GetPeerCount() && peer != m_self);
+			assert(nullptr != data || 0 == size);
+
+			const uint32_t length = static_cast<uint32_t>(size);
+			const Socket socket = m_peers[peer];
+			return socket != kNoSocket && writeAll(socket, &length, sizeof(length)) && writeAll(socket, data, size);
+		}
+
+		virtual bool Receive(int& peer, std::vector<uint8_t>& message) override
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_ready.wait(lock, [this] { return !m_inbox.empty() || m_broken; });
+
+			// Messages which came before connection was lost are still delivered
+			if (m_inbox.empty())
+				return false;
+
+			peer = m_inbox.front().first;
+			message = std::move(m_inbox.front().second);
+			m_inbox.pop_front();
+			return true;
+		}
+
+	private:
+		Socket listen(const std::string& address)
+		{
+			addrinfo* info = resolve(address, true);
+			if (nullptr == info)
+				return kNoSocket;
+
+			Socket listener = ::socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+			if (listener != kNoSocket)
+			{
+				const int reuse = 1;
+				::setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+				if (::bind(listener, info->ai_addr, static_cast<int>(info->ai_addrlen)) != 0 ||
+					::listen(listener, static_cast<int>(m_peers.size())) != 0)
+				{
+					closeSocket(listener);
+					listener = kNoSocket;
+				}
+			}
+
+			::freeaddrinfo(info);
+			return listener;
+		}
+
+		bool connectTo(const std::string& address, int peer)
+		{
+			addrinfo* info = resolve(address, false);
+			if (nullptr == info)
+				return false;
+
+			const auto deadline = std::chrono::steady_clock::now() + kConnectTimeout;
+			Socket socket = kNoSocket;
+			while (socket == kNoSocket && std::chrono::steady_clock::now() < deadline)
+			{
+				socket = ::socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+				if (socket == kNoSocket)
+					break;
+
+				if (::connect(socket, info->ai_addr, static_cast<int>(info->ai_addrlen)) != 0)
+				{
+					closeSocket(socket);
+					socket = kNoSocket;
+					std::this_thread::sleep_for(kConnectRetryDelay);
+				}
+			}
+			::freeaddrinfo(info);
+
+			if (socket == kNoSocket)
+				return false;
+
+			// Introduce ourselves, accepting side doesn't know who connected
+			const int32_t self = m_self;
+			if (!writeAll(socket, &self, sizeof(self)))
+			{
+				closeSocket(socket);
+				return false;
+			}
+
+			m_peers[peer] = configure(socket);
+			return true;
+		}
+
+		bool acceptFrom(Socket listener)
+		{
+			const Socket socket = ::accept(listener, nullptr, nullptr);
+			if (socket == kNoSocket)
+				return false;
+
+			int32_t peer = -1;
+			if (!readAll(socket, &peer, sizeof(peer)) || peer <= m_self || peer >= GetPeerCount() || m_peers[peer] != kNoSocket)
+			{
+				closeSocket(socket);
+				return false;
+			}
+
+			m_peers[peer] = configure(socket);
+			return true;
+		}
+
+		// Messages are sent at once, so they shouldn't wait for more data
+		static Socket configure(Socket socket)
+		{
+			const int no_delay = 1;
+			::setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&no_delay), sizeof(no_delay));
+			return socket;
+		}
+
+		void receiveLoop()
+		{
+			std::vector<pollfd> fds;
+			std::vector<int> owners;
+			for (int peer = 0; peer < GetPeerCount(); ++peer)
+				if (m_peers[peer] != kNoSocket)
+				{
+					pollfd fd = {};
+					fd.fd = m_peers[peer];
+					fd.events = POLLIN;
+					fds.push_back(fd);
+					owners.push_back(peer);
+				}
+
+			bool lost = false;
+			while (!lost && !fds.empty())
+			{
+				if (pollSockets(fds.data(), fds.size()) < 0)
+				{
+					if (interrupted())
+						continue;
+					break;
+				}
+
+				for (size_t i = 0; !lost && i < fds.size(); ++i)
+				{
+					if (0 == (fds[i].revents & (POLLIN | POLLHUP | POLLERR)))
+						continue;
+
+					uint32_t length = 0;
+					std::vector<uint8_t> message;
+					if (!readAll(fds[i].fd, &length, sizeof(length)))
+					{
+						lost = true;
+						break;
+					}
+					message.resize(length);
+					if (!readAll(fds[i].fd, message.data(), length))
+					{
+						lost = true;
+						break;
+					}
+
+					{
+						std::lock_guard<std::mutex> lock(m_mutex);
+						m_inbox.emplace_back(owners[i], std::move(message));
+					}
+					m_ready.notify_one();
+				}
+			}
+
+			// Node can't go on without any of its peers
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_broken = true;
+			}
+			m_ready.notify_all();
+		}
+
+		int m_self;
+		std::vector<Socket> m_peers;
+
+		// Filled by receiving thread
+		std::thread m_receiver;
+		std::mutex m_mutex;
+		std::condition_variable m_ready;
+		std::deque<std::pair<int, std::vector<uint8_t>>> m_inbox;
+		bool m_broken;
+	};
+}
+
+std::vector<TransportPtr> ITransport::CreateLocal(int count)
+{
+	assert(count > 0);
+
+	const auto hub = std::make_shared<LocalHub>(count);
+
+	std::vector<TransportPtr> transports;
+	for (int i = 0; i < count; ++i)
+		transports.push_back(std::make_shared<LocalTransport>(hub, i));
+	return transports;
+}
+
+TransportPtr ITransport::CreateSocket(const std::vector<std::string>& addresses, int self)
+{
+	assert(self >= 0 && self < static_cast<int>(addresses.size()));
+
+	auto transport = std::make_shared<SocketTransport>(self, static_cast<int>(addresses.size()));
+	if (!transport->connect(addresses))
+		return nullptr;
+	return transport;
+}
@@ -3,6 +3,7 @@
 #include <Windows.h>
 #include <Windowsx.h>
 #include <phys_engine.h>
+#include <unordered_map>
 #include <vector>
 
 namespace draw
@@ -31,7 +32,10 @@ namespace draw
 		Entity(Entity&&);
 		Entity& operator=(Entity&&) = delete;
 
-		virtual void Draw(HWND);
+		// Position is taken from frame published by simulation thread, not from body
+		virtual void Draw(HWND, const physic::Point&);
+
+		physic::BodyId GetBodyId() const;
 
 	private:
 		physic::BodyPtr m_body;
@@ -59,6 +63,9 @@ namespace draw
 
 		using EntityPtr = std::shared_ptr<Entity>;
 		std::vector<EntityPtr> m_enteties;
+
+		// Positions of last drawn frame by body id
+		std::unordered_map<physic::BodyId, physic::Point> m_framePositions;
 	};
 }
 
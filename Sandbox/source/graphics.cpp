@@ -8,6 +8,7 @@ namespace draw
 	Render::Render()
 		: m_hWnd(0)
 		, m_enteties()
+		, m_framePositions()
 	{
 
 	}
@@ -31,9 +32,22 @@ namespace draw
 	void Render::Draw()
 	{
 		assert(0 != m_hWnd);
+
+		// Bodies belong to simulation thread, draw the last frame it published
+		const physic::FramePtr frame = physic::IEngine::Instance()->GetFrame();
+		if (nullptr == frame)
+			return;
+
+		m_framePositions.clear();
+		for (const auto& body : frame->bodies)
+			m_framePositions[body.id] = body.position;
+
 		for (const auto& entity : m_enteties)
 		{
-			entity->Draw(m_hWnd);
+			// Body is not simulated yet
+			auto position = m_framePositions.find(entity->GetBodyId());
+			if (position != m_framePositions.end())
+				entity->Draw(m_hWnd, position->second);
 		}
 
 		DrawCoordinates();
@@ -103,7 +117,12 @@ namespace draw
 
 	}
 
-	void Entity::Draw(HWND hWnd)
+	physic::BodyId Entity::GetBodyId() const
+	{
+		return m_body->GetId();
+	}
+
+	void Entity::Draw(HWND hWnd, const physic::Point& pos)
 	{
 		HDC hdc;
 		hdc = GetDC(hWnd);
@@ -137,7 +156,6 @@ namespace draw
 		SelectObject(hdc, blackPen);
 		
 		// 2. Draw new object
-		physic::Point pos = m_body->GetPosition();
 		Ellipse(hdc,
 			(int)pos.x - m_radius,
 			(int)pos.y - m_radius,
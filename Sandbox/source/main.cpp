@@ -37,18 +37,18 @@ LRESULT CALLBACK WinProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 		{
 			const physic::Point pos { static_cast<physic::Point::type>(draw::kAxisCrossPoint.x + draw::kDefaultEntityRadius + 1),
 				static_cast<physic::Point::type>(draw::kAxisCrossPoint.y + draw::kDefaultEntityRadius + 1) };
-			const physic::fVec2D vel = physic::fVec2D(150, physic::fAngle(45));
+			const physic::fVec2D vel = physic::PolarVector(physic::Scalar(150), physic::fAngle(45));
 
 			// Physical body. Should be wrapped for correct drawing.
 			physic::BodyPtr body = physic::IBody::CreateBody(physic::IShape::ShapeType::Circle, pos, vel, 20);
 
-			// Add body into engine for simulation
-			physic::IEngine* engine = physic::IEngine::Instance();
-			engine->AddBody(body);
-
 			// Add body to drawing queue
 			draw::Render* render = draw::Render::Instance();
 			render->AddBody(body);
+
+			// Engine runs on its own thread, body is added on its next step
+			physic::IEngine* engine = physic::IEngine::Instance();
+			engine->PushCommand({ physic::BodyCommand::Type::Add, body, physic::fVec2D{ 0, 0 } });
 		}
 		break;
 	case WM_LBUTTONDOWN:
@@ -67,14 +67,14 @@ LRESULT CALLBACK WinProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 		// Physical body. Should be wrapped for correct drawing.
 		physic::BodyPtr body = physic::IBody::CreateBody(physic::IShape::ShapeType::Circle, mouse_down, vec, 20);
 
-		// Add body into engine for simulation
-		physic::IEngine* engine = physic::IEngine::Instance();
-		engine->AddBody(body);
-
 		// Add body to drawing queue
 		draw::Render* render = draw::Render::Instance();
 		render->AddBody(body);
 
+		// Engine runs on its own thread, body is added on its next step
+		physic::IEngine* engine = physic::IEngine::Instance();
+		engine->PushCommand({ physic::BodyCommand::Type::Add, body, physic::fVec2D{ 0, 0 } });
+
 		break;
 	}
 	case WM_MOUSEMOVE:
@@ -147,7 +147,7 @@ int main(int argc, char* argv[])
 	if (0 != param)
 	{
 		float value = std::stof(param);
-		argVelocity = { value, argAngle };
+		argVelocity = physic::PolarVector(physic::Scalar(value), argAngle);
 	}
 	else
 		return failedCommandParam();
@@ -236,39 +236,24 @@ int main(int argc, char* argv[])
 
 			render->Clear();
 
-			const double dt = 1.0f / 60.0;
-			auto current_time = std::chrono::steady_clock::now();
-			double accumulator = 0.0;
+			// Simulation steps on its own thread, window thread only draws published frames
+			const double dt = 1.0 / 60.0;
+			// Calm scenes take one step per frame, fast bodies get up to eight shorter ones
+			engine->SetAdaptiveStep(dt / 8, dt);
+			engine->StartSimulation(dt);
 
 			MSG msg { 0 };
 
-			while (TRUE)
+			while (GetMessage(&msg, NULL, 0, 0) > 0)
 			{
-				if (GetMessage(&msg, NULL, 0, 0) >= 0)
-				{
-					TranslateMessage(&msg);
-					DispatchMessage(&msg);
-
-					auto new_time = std::chrono::steady_clock::now();
-					double frame_time = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(new_time - current_time).count();
-					current_time = new_time;
-
-					if (frame_time > dt)
-						frame_time = dt;
+				TranslateMessage(&msg);
+				DispatchMessage(&msg);
 
-					accumulator += frame_time;
-
-					while (accumulator >= dt)
-					{
-						engine->Step(dt / 2);
-						accumulator -= dt;
-					}
-
-					// Render all objects
-					draw::Render::Instance()->Draw();
-
-				}
+				// Render all objects
+				draw::Render::Instance()->Draw();
 			}
+
+			engine->StopSimulation();
 		}
 	}
 
@@ -0,0 +1,39 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+
+namespace bench
+{
+	// Best of several runs in milliseconds, the first run warms caches up
+	template <typename F>
+	double Measure(F&& f, int runs = 10)
+	{
+		double best = std::numeric_limits<double>::max();
+		for (int i = 0; i < runs; ++i)
+		{
+			auto start = std::chrono::steady_clock::now();
+			f();
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+			best = std::min(best, elapsed.count());
+		}
+		return best;
+	}
+
+	inline void Report(const std::string& name, double legacy_ms, double current_ms)
+	{
+		std::cout << std::left << std::setw(32) << name << std::right << std::fixed << std::setprecision(2)
+			<< std::setw(10) << legacy_ms << " ms" << std::setw(10) << current_ms << " ms" << std::endl;
+	}
+
+	// Benchmarks, one per source file
+	void VectorMath();
+
+} // namespace bench
+
+#endif // BENCH_H
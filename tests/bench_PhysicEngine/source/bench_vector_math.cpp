@@ -0,0 +1,194 @@
+#include <bench.h>
+
+#include <phys_utils.h>
+
+#include <array>
+#include <vector>
+
+using namespace physic;
+
+namespace
+{
+	// Vector and point as declared before they became aggregates: user-provided copy and move
+	// make them non-trivially copyable and nothing about them can be evaluated at compile time
+	template <typename T>
+	struct LegacyVec2D
+	{
+		T x;
+		T y;
+
+		LegacyVec2D(T vx = 0, T vy = 0) : x(vx), y(vy) {}
+		~LegacyVec2D() = default;
+
+		LegacyVec2D(const LegacyVec2D& v) : x(v.x), y(v.y) {}
+		LegacyVec2D& operator=(const LegacyVec2D& v) { x = v.x; y = v.y; return *this; }
+
+		LegacyVec2D(LegacyVec2D&& v) : x(std::move(v.x)), y(std::move(v.y)) {}
+		LegacyVec2D& operator=(LegacyVec2D&& v) { x = std::move(v.x); y = std::move(v.y); return *this; }
+
+		LegacyVec2D& operator*=(T s) { x *= s; y *= s; return *this; }
+	};
+
+	template <typename T>
+	struct LegacyPoint2D
+	{
+		T x;
+		T y;
+
+		LegacyPoint2D(T vx = 0, T vy = 0) : x(vx), y(vy) {}
+		~LegacyPoint2D() = default;
+
+		LegacyPoint2D(const LegacyPoint2D& v) : x(v.x), y(v.y) {}
+		LegacyPoint2D& operator=(const LegacyPoint2D& v) { x = v.x; y = v.y; return *this; }
+
+		LegacyPoint2D(LegacyPoint2D&& v) : x(std::move(v.x)), y(std::move(v.y)) {}
+		LegacyPoint2D& operator=(LegacyPoint2D&& v) { x = std::move(v.x); y = std::move(v.y); return *this; }
+
+		LegacyPoint2D& operator+=(const LegacyVec2D<T>& v) { x += v.x; y += v.y; return *this; }
+	};
+
+	template <typename T>
+	LegacyVec2D<T> operator-(const LegacyPoint2D<T>& l, const LegacyPoint2D<T>& r) { return LegacyVec2D<T>(l.x - r.x, l.y - r.y); }
+	template <typename T>
+	LegacyVec2D<T> operator*(const LegacyVec2D<T>& v, T s) { return LegacyVec2D<T>(v) *= s; }
+	template <typename T>
+	T LegacyDotProduct(const LegacyVec2D<T>& a, const LegacyVec2D<T>& b) { return a.x * b.x + a.y * b.y; }
+
+	using LegacyVec = LegacyVec2D<Scalar>;
+	using LegacyPoint = LegacyPoint2D<Scalar>;
+
+	static_assert(!std::is_trivially_copyable<LegacyPoint>::value, "legacy point must keep user-provided copy");
+	static_assert(std::is_trivially_copyable<Point>::value, "Point must be trivially copyable");
+	static_assert(sizeof(LegacyPoint) == sizeof(Point), "both points must have the same layout");
+
+	const size_t kBodies = 64 * 1024;
+	const size_t kPairwise = 2048;
+	const int kRepeats = 100;
+
+	// Grid of body origins, the current one is filled by the compiler
+	const size_t kGridSide = 32;
+
+	constexpr std::array<Point, kGridSide * kGridSide> MakeGrid()
+	{
+		std::array<Point, kGridSide * kGridSide> grid{};
+		for (size_t i = 0; i < grid.size(); ++i)
+			grid[i] = Point{ Scalar(int(i % kGridSide) * 10), Scalar(int(i / kGridSide) * 10) } + fVec2D{ 5, 5 };
+		return grid;
+	}
+
+	std::vector<LegacyPoint> MakeLegacyGrid()
+	{
+		std::vector<LegacyPoint> grid(kGridSide * kGridSide);
+		for (size_t i = 0; i < grid.size(); ++i)
+		{
+			grid[i] = LegacyPoint(Scalar(int(i % kGridSide) * 10), Scalar(int(i / kGridSide) * 10));
+			grid[i] += LegacyVec(5, 5);
+		}
+		return grid;
+	}
+
+	constexpr auto kGrid = MakeGrid();
+	static_assert(kGrid[kGridSide + 1] == Point{ 15, 15 }, "grid must be evaluated at compile time");
+	static_assert(DotProduct(fVec2D{ 3, 4 }, fVec2D{ 3, 4 }) == 25, "dot product must be constexpr");
+
+	// Both versions integrate through the same code, so the optimizer knows exactly as much
+	// about aliasing of position and velocity buffers for either of them
+	template <typename P, typename V>
+	void Integrate(std::vector<P>& points, const std::vector<V>& velocities, Scalar dt)
+	{
+		for (int r = 0; r < kRepeats; ++r)
+			for (size_t i = 0; i < points.size(); ++i)
+				points[i] += velocities[i] * dt;
+	}
+
+	// Results are summed up and printed so that the optimizer keeps the loops
+	volatile double g_sink = 0;
+}
+
+namespace bench
+{
+	void VectorMath()
+	{
+		std::vector<LegacyPoint> legacy_points;
+		std::vector<LegacyVec> legacy_velocities;
+		std::vector<Point> points;
+		std::vector<fVec2D> velocities;
+		for (size_t i = 0; i < kBodies; ++i)
+		{
+			Scalar x = Scalar(int(i % 1024)), y = Scalar(int(i / 1024));
+			legacy_points.emplace_back(x, y);
+			legacy_velocities.emplace_back(Scalar(1), Scalar(-1));
+			points.push_back(Point{ x, y });
+			velocities.push_back(fVec2D{ 1, -1 });
+		}
+		const Scalar dt = Scalar(1) / Scalar(60);
+
+		// Bulk copy into preallocated buffer: element by element for legacy points,
+		// memmove for trivially copyable ones
+		std::vector<LegacyPoint> legacy_copy(kBodies);
+		std::vector<Point> copy(kBodies);
+		Report("vector<Point> copy x100",
+			Measure([&] {
+				for (int r = 0; r < kRepeats; ++r)
+				{
+					legacy_copy = legacy_points;
+					g_sink = g_sink + double(legacy_copy.back().x);
+				}
+			}),
+			Measure([&] {
+				for (int r = 0; r < kRepeats; ++r)
+				{
+					copy = points;
+					g_sink = g_sink + double(copy.back().x);
+				}
+			}));
+
+		// Integration: inlined copies cost nothing in either version
+		Report("integration x100",
+			Measure([&] {
+				Integrate(legacy_points, legacy_velocities, dt);
+				g_sink = g_sink + double(legacy_points[0].y);
+			}),
+			Measure([&] {
+				Integrate(points, velocities, dt);
+				g_sink = g_sink + double(points[0].y);
+			}));
+
+		// Pairwise squared distances as in brute force broad phase
+		Report("pairwise distance",
+			Measure([&] {
+				Scalar sum = 0;
+				for (size_t i = 0; i < kPairwise; ++i)
+					for (size_t j = i + 1; j < kPairwise; ++j)
+					{
+						LegacyVec d = legacy_points[i] - legacy_points[j];
+						sum += LegacyDotProduct(d, d);
+					}
+				g_sink = g_sink + double(sum);
+			}),
+			Measure([&] {
+				Scalar sum = 0;
+				for (size_t i = 0; i < kPairwise; ++i)
+					for (size_t j = i + 1; j < kPairwise; ++j)
+						sum += SquaredNorm(points[i] - points[j]);
+				g_sink = g_sink + double(sum);
+			}));
+
+		// Constant data: legacy grid is built on every call, current one is a compile time constant
+		Report("constant grid x1000",
+			Measure([&] {
+				for (int r = 0; r < 10 * kRepeats; ++r)
+				{
+					std::vector<LegacyPoint> grid = MakeLegacyGrid();
+					g_sink = g_sink + double(grid[r % grid.size()].x);
+				}
+			}),
+			Measure([&] {
+				for (int r = 0; r < 10 * kRepeats; ++r)
+					g_sink = g_sink + double(kGrid[r % kGrid.size()].x);
+			}));
+
+		std::cout << "checksum " << g_sink << std::endl;
+	}
+
+} // namespace bench
@@ -0,0 +1,10 @@
+#include <bench.h>
+
+#include <iostream>
+
+int main()
+{
+	std::cout << "Best of 10 runs, legacy vs current" << std::endl;
+	bench::VectorMath();
+	return 0;
+}
@@ -0,0 +1,52 @@
+#include "CppUnitTest.h"
+
+#include <phys_engine.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace physic;
+
+namespace test_PhysicEngine
+{
+	TEST_CLASS(AdaptiveStepTest)
+	{
+	public:
+
+		TEST_METHOD(AdaptiveStepSplitsFastMotion)
+		{
+			EnginePtr engine = IEngine::Create();
+			engine->SetAdaptiveStep(1.0 / 480, 1.0 / 60);
+
+			BodyPtr slow = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 100, 100 }, fVec2D{ 5, 0 }, 1);
+			engine->AddBody(slow);
+			engine->Step(1.0 / 60);
+
+			StepStats stats = engine->GetStepStats();
+			Assert::AreEqual(size_t(1), stats.substeps);
+			Assert::AreEqual(uint64_t(1), engine->GetStepIndex());
+
+			BodyPtr fast = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 300, 100 }, fVec2D{ 2000, 0 }, 1);
+			engine->AddBody(fast);
+			for (int i = 0; i < 10; ++i)
+			{
+				const uint64_t index = engine->GetStepIndex();
+				engine->Step(1.0 / 60);
+				stats = engine->GetStepStats();
+
+				// Split ends within bounds and covers whole dt
+				Assert::IsTrue(stats.substeps > 1 && stats.substeps <= 8);
+				Assert::IsTrue(stats.min_substep >= 1.0 / 480 - 1e-9);
+				Assert::IsTrue(stats.max_substep <= 1.0 / 60 + 1e-9);
+				Assert::AreEqual(1.0 / 60, stats.dt, 1e-9);
+				Assert::AreEqual(index + stats.substeps, engine->GetStepIndex());
+			}
+
+			// Faster than the shortest substep allows, split stops at min_dt
+			BodyPtr bullet = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 100, 1000 }, fVec2D{ 100000, 0 }, 1);
+			engine->AddBody(bullet);
+			engine->Step(1.0 / 60);
+			stats = engine->GetStepStats();
+			Assert::IsTrue(stats.substeps <= 8);
+			Assert::IsTrue(stats.min_substep >= 1.0 / 480 - 1e-9);
+		}
+	};
+}
@@ -0,0 +1,192 @@
+#include "CppUnitTest.h"
+
+#include <phys_async.h>
+#include <phys_engine.h>
+
+#include <chrono>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace physic;
+
+namespace test_PhysicEngine
+{
+#ifdef __cpp_impl_coroutine
+	namespace
+	{
+		// Coroutine runs at once and frees itself when it returns
+		struct DetachedTask
+		{
+			struct promise_type
+			{
+				DetachedTask get_return_object() { return {}; }
+				std::suspend_never initial_suspend() noexcept { return {}; }
+				std::suspend_never final_suspend() noexcept { return {}; }
+				void return_void() {}
+				void unhandled_exception() { std::terminate(); }
+			};
+		};
+
+		struct AwaitedSteps
+		{
+			std::vector<bool> results;
+			std::vector<uint64_t> steps;
+			std::vector<std::thread::id> threads;
+		};
+
+		// Awaits steps one after another and records what it sees after each of them
+		DetachedTask AwaitSteps(IEngine& engine, int count, AwaitedSteps& awaited, std::shared_ptr<std::promise<void>> done)
+		{
+			for (int i = 0; i < count; ++i)
+			{
+				const bool stepped = co_await StepAwaitable{ engine, 1.0 / 60 };
+				awaited.results.push_back(stepped);
+				awaited.steps.push_back(engine.GetStepIndex());
+				awaited.threads.push_back(std::this_thread::get_id());
+			}
+			done->set_value();
+		}
+	}
+#endif
+
+	TEST_CLASS(AsyncStepTest)
+	{
+	public:
+
+		TEST_METHOD(StepsRunInOrder)
+		{
+			EnginePtr engine = IEngine::Create();
+			engine->SetWorldConstants(0, 0, 0);
+			BodyPtr body = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 100, 100 }, fVec2D{ 60, 0 }, 1);
+			engine->AddBody(body);
+
+			// Callbacks run one after another on worker thread
+			std::vector<uint64_t> done_steps;
+			for (int i = 0; i < 4; ++i)
+				Assert::IsTrue(engine->StepAsync(1.0 / 60, [&]() { done_steps.push_back(engine->GetStepIndex()); }));
+			std::future<void> last = engine->StepAsync(1.0 / 60);
+			Assert::IsTrue(std::future_status::ready == last.wait_for(std::chrono::seconds(5)));
+			last.get();
+
+			Assert::AreEqual(size_t(4), done_steps.size());
+			for (size_t i = 0; i < done_steps.size(); ++i)
+				Assert::AreEqual(uint64_t(i + 1), done_steps[i]);
+
+			// Frame of the last step is published before its future is ready
+			FramePtr frame = engine->GetFrame();
+			Assert::IsTrue(nullptr != frame);
+			Assert::AreEqual(uint64_t(5), frame->step);
+			Assert::AreEqual(static_cast<float>(body->GetPosition().x), static_cast<float>(frame->bodies[0].position.x), 1e-3f);
+			Assert::AreEqual(105.f, static_cast<float>(body->GetPosition().x), 0.05f);
+		}
+
+		TEST_METHOD(FailsWhileSimulationRuns)
+		{
+			EnginePtr engine = IEngine::Create();
+			engine->StartSimulation(1.0 / 60);
+
+			bool called = false;
+			Assert::IsFalse(engine->StepAsync(1.0 / 60, [&called]() { called = true; }));
+			std::future<void> future = engine->StepAsync(1.0 / 60);
+			Assert::ExpectException<std::logic_error>([&future]() { future.get(); });
+
+			engine->StopSimulation();
+			Assert::IsFalse(called);
+
+			// Worker steps again once simulation thread is stopped
+			const uint64_t index = engine->GetStepIndex();
+			engine->StepAsync(1.0 / 60).get();
+			Assert::AreEqual(index + 1, engine->GetStepIndex());
+		}
+
+#ifdef __cpp_impl_coroutine
+		TEST_METHOD(CoroutineAwaitsSteps)
+		{
+			EnginePtr engine = IEngine::Create();
+			engine->SetWorldConstants(0, 0, 0);
+			BodyPtr body = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 100, 100 }, fVec2D{ 60, 0 }, 1);
+			engine->AddBody(body);
+
+			// Each step is awaited on worker thread, the next one is requested from there
+			AwaitedSteps awaited;
+			auto done = std::make_shared<std::promise<void>>();
+			std::future<void> finished = done->get_future();
+			AwaitSteps(*engine, 3, awaited, done);
+			Assert::IsTrue(std::future_status::ready == finished.wait_for(std::chrono::seconds(5)));
+
+			Assert::AreEqual(size_t(3), awaited.steps.size());
+			for (size_t i = 0; i < awaited.steps.size(); ++i)
+			{
+				Assert::IsTrue(awaited.results[i]);
+				Assert::AreEqual(uint64_t(i + 1), awaited.steps[i]);
+				Assert::IsTrue(std::this_thread::get_id() != awaited.threads[i]);
+			}
+			Assert::AreEqual(103.f, static_cast<float>(body->GetPosition().x), 0.05f);
+		}
+
+		TEST_METHOD(CoroutineIsNotSuspendedWhileSimulationRuns)
+		{
+			EnginePtr engine = IEngine::Create();
+			engine->StartSimulation(1.0 / 60);
+
+			// Refused step resumes coroutine at once on calling thread
+			AwaitedSteps awaited;
+			auto done = std::make_shared<std::promise<void>>();
+			std::future<void> finished = done->get_future();
+			AwaitSteps(*engine, 1, awaited, done);
+			Assert::IsTrue(std::future_status::ready == finished.wait_for(std::chrono::seconds(0)));
+
+			engine->StopSimulation();
+
+			Assert::AreEqual(size_t(1), awaited.results.size());
+			Assert::IsFalse(awaited.results[0]);
+			Assert::IsTrue(std::this_thread::get_id() == awaited.threads[0]);
+		}
+#endif
+
+		TEST_METHOD(StartSimulationFinishesRequestedSteps)
+		{
+			// Enough bodies for requested steps to be still queued when simulation starts
+			EnginePtr engine = IEngine::Create();
+			for (int i = 0; i < 2000; ++i)
+			{
+				const Point position{ Scalar(20 + (i % 50) * 30), Scalar(20 + (i / 50) * 30) };
+				BodyPtr body = IBody::CreateBody(IShape::ShapeType::Circle, position, fVec2D{ Scalar(i % 7), 0 }, 1);
+				engine->AddBody(body);
+			}
+
+			std::mutex mutex;
+			std::vector<uint64_t> done_steps;
+			for (int i = 0; i < 20; ++i)
+			{
+				engine->StepAsync(1.0 / 60, [&]()
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					done_steps.push_back(engine->GetStepIndex());
+				});
+			}
+
+			// No requested step is left to run along the simulation thread
+			engine->StartSimulation(1.0 / 60);
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				Assert::AreEqual(size_t(20), done_steps.size());
+				for (size_t i = 0; i < done_steps.size(); ++i)
+					Assert::AreEqual(uint64_t(i + 1), done_steps[i]);
+			}
+			engine->StopSimulation();
+
+			// Worker is started again by the next request
+			const uint64_t index = engine->GetStepIndex();
+			std::future<void> future = engine->StepAsync(1.0 / 60);
+			Assert::IsTrue(std::future_status::ready == future.wait_for(std::chrono::seconds(5)));
+			Assert::AreEqual(index + 1, engine->GetStepIndex());
+		}
+	};
+}
@@ -0,0 +1,90 @@
+#include "CppUnitTest.h"
+
+#include <phys_engine.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace physic;
+
+namespace test_PhysicEngine
+{
+	TEST_CLASS(BodyTypeTest)
+	{
+	public:
+
+		TEST_METHOD(KinematicFollowsVelocityOnly)
+		{
+			EnginePtr engine = IEngine::Create();
+			engine->SetWorldConstants(200, 0, 0);
+
+			BodyPtr body = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 100, 100 }, fVec2D{ 60, 0 }, 5,
+				IBody::BodyType::Kinematic);
+			engine->AddBody(body);
+			Assert::IsTrue(IBody::BodyType::Kinematic == body->GetBodyType());
+
+			// Mass is infinite whatever was asked for
+			Assert::AreEqual(0.f, static_cast<float>(body->GetMass().inv_mass));
+			body->SetMass(Mass(2));
+			Assert::AreEqual(0.f, static_cast<float>(body->GetMass().inv_mass));
+
+			// Neither gravity nor forces nor impulses change velocity
+			for (int i = 0; i < 60; ++i)
+			{
+				body->ApplyForce(fVec2D{ 0, 1000 });
+				body->ApplyImpulse(fVec2D{ -50, 0 });
+				engine->Step(1.0 / 60);
+			}
+
+			Assert::AreEqual(60.f, static_cast<float>(body->GetVelocityVector().x), 1e-4f);
+			Assert::AreEqual(0.f, static_cast<float>(body->GetVelocityVector().y), 1e-4f);
+			Assert::AreEqual(160.f, static_cast<float>(body->GetPosition().x), 0.05f);
+			Assert::AreEqual(100.f, static_cast<float>(body->GetPosition().y), 1e-4f);
+
+			// Velocity set by host is followed from the next step
+			body->SetVelocityVector(fVec2D{ 0, -60 });
+			engine->Step(0.5);
+			Assert::AreEqual(70.f, static_cast<float>(body->GetPosition().y), 1e-2f);
+		}
+
+		TEST_METHOD(KinematicPushesDynamicBody)
+		{
+			EnginePtr engine = IEngine::Create();
+			engine->SetWorldConstants(0, 0, 0);
+
+			BodyPtr pusher = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 200, 100 }, fVec2D{ -30, 0 }, 1,
+				IBody::BodyType::Kinematic);
+			BodyPtr ball = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 100, 100 }, fVec2D{ 30, 0 }, 1);
+			engine->AddBody(pusher);
+			engine->AddBody(ball);
+
+			for (int i = 0; i < 120; ++i)
+				engine->Step(1.0 / 60);
+
+			// Only the dynamic body bounced
+			Assert::AreEqual(-30.f, static_cast<float>(pusher->GetVelocityVector().x), 1e-4f);
+			Assert::IsTrue(ball->GetVelocityVector().x < -30);
+			Assert::IsTrue(ball->GetPosition().x < pusher->GetPosition().x);
+		}
+
+		TEST_METHOD(StaticNeverMoves)
+		{
+			EnginePtr engine = IEngine::Create();
+			engine->SetWorldConstants(0, 0, 0);
+
+			BodyPtr wall = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 200, 100 }, fVec2D{ 0, 0 }, 1,
+				IBody::BodyType::Static);
+			BodyPtr ball = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 100, 100 }, fVec2D{ 60, 0 }, 1);
+			engine->AddBody(wall);
+			engine->AddBody(ball);
+			Assert::AreEqual(0.f, static_cast<float>(wall->GetMass().inv_mass));
+
+			for (int i = 0; i < 120; ++i)
+			{
+				wall->ApplyImpulse(fVec2D{ 100, 100 });
+				engine->Step(1.0 / 60);
+			}
+
+			Assert::IsTrue(Point{ 200, 100 } == wall->GetPosition());
+			Assert::IsTrue(ball->GetVelocityVector().x < 0);
+		}
+	};
+}
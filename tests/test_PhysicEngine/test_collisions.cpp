@@ -0,0 +1,131 @@
+#include "CppUnitTest.h"
+
+#include <phys_constants.h>
+#include <phys_engine.h>
+
+#include <cstdlib>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace physic;
+
+namespace test_PhysicEngine
+{
+	namespace
+	{
+		// Two bodies along x in empty world, stepped until they have separated
+		void Collide(BodyPtr& left, BodyPtr& right)
+		{
+			EnginePtr engine = IEngine::Create();
+			engine->SetWorldConstants(0, 0, 0);
+			engine->AddBody(left);
+			engine->AddBody(right);
+			for (int i = 0; i < 60; ++i)
+				engine->Step(1.0 / 60);
+		}
+	}
+
+	TEST_CLASS(CollisionTest)
+	{
+	public:
+
+		TEST_METHOD(HeadOnCollisionKeepsMomentum)
+		{
+			BodyPtr left = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 100, 100 }, fVec2D{ 50, 0 }, 1);
+			BodyPtr right = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 150, 100 }, fVec2D{ -50, 0 }, 1);
+			Collide(left, right);
+
+			// Impulse is applied once, relative speed is scaled by restitution
+			const float speed = 50 * static_cast<float>(kBounceFactor);
+			Assert::AreEqual(-speed, static_cast<float>(left->GetVelocityVector().x), 1e-3f);
+			Assert::AreEqual(speed, static_cast<float>(right->GetVelocityVector().x), 1e-3f);
+			Assert::AreEqual(0.f, static_cast<float>(left->GetVelocityVector().y), 1e-3f);
+		}
+
+		TEST_METHOD(UnequalMassesKeepMomentum)
+		{
+			BodyPtr light = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 100, 100 }, fVec2D{ 60, 0 }, 1);
+			BodyPtr heavy = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 150, 100 }, fVec2D{ -20, 0 }, 3);
+			Collide(light, heavy);
+
+			const float light_velocity = static_cast<float>(light->GetVelocityVector().x);
+			const float heavy_velocity = static_cast<float>(heavy->GetVelocityVector().x);
+			Assert::AreEqual(0.f, light_velocity + 3 * heavy_velocity, 1e-2f);
+			Assert::AreEqual(80 * static_cast<float>(kBounceFactor), heavy_velocity - light_velocity, 1e-2f);
+		}
+
+		TEST_METHOD(StaticBodyReflectsVelocity)
+		{
+			BodyPtr wall = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 150, 100 }, fVec2D{ 0, 0 }, 1, IBody::BodyType::Static);
+			BodyPtr body = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 100, 100 }, fVec2D{ 50, 0 }, 1);
+			Collide(body, wall);
+
+			Assert::AreEqual(-50 * static_cast<float>(kBounceFactor), static_cast<float>(body->GetVelocityVector().x), 1e-3f);
+			Assert::IsTrue(Point{ 150, 100 } == wall->GetPosition());
+		}
+
+		TEST_METHOD(TeleportedBodyCollidesWithOlderOne)
+		{
+			EnginePtr engine = IEngine::Create();
+			engine->SetWorldConstants(0, 0, 0);
+			BodyPtr resting = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 100, 100 }, fVec2D{ 0, 0 }, 1);
+			engine->AddBody(resting);
+
+			// Enough bodies around to split the tree, so stale entry lands in other node
+			for (int i = 0; i < 1600; ++i)
+			{
+				const int x = -485 + 30 * (i % 40);
+				const int y = -485 + 30 * (i / 40);
+				if (std::abs(x - 100) < 60 && std::abs(y - 100) < 60)
+					continue;
+				BodyPtr filler = IBody::CreateBody(IShape::ShapeType::Circle, Point{ Scalar(x), Scalar(y) }, fVec2D{ 0, 0 }, 1);
+				engine->AddBody(filler);
+			}
+
+			BodyPtr moved = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 2000, 2000 }, fVec2D{ 0, 0 }, 1);
+			engine->AddBody(moved);
+			engine->Step(1.0 / 60);
+
+			moved->SetPosition(Point{ 115, 100 });
+			moved->SetVelocityVector(fVec2D{ -50, 0 });
+			engine->Step(1.0 / 60);
+
+			Assert::IsTrue(resting->GetVelocityVector().x < 0);
+			Assert::IsTrue(moved->GetVelocityVector().x > -50);
+		}
+
+		TEST_METHOD(StaticFilterChangeTakesEffect)
+		{
+			EnginePtr engine = IEngine::Create();
+			engine->SetWorldConstants(0, 0, 0);
+			BodyPtr wall = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 150, 100 }, fVec2D{ 0, 0 }, 1, IBody::BodyType::Static);
+			BodyPtr body = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 100, 100 }, fVec2D{ 50, 0 }, 1);
+			engine->AddBody(wall);
+			engine->AddBody(body);
+			engine->Step(1.0 / 60);
+
+			wall->SetCollisionFilter({ 0x0002, 0x0000, 0 });
+			for (int i = 0; i < 120; ++i)
+				engine->Step(1.0 / 60);
+
+			Assert::AreEqual(50.f, static_cast<float>(body->GetVelocityVector().x), 1e-3f);
+			Assert::IsTrue(body->GetPosition().x > wall->GetPosition().x);
+		}
+
+		TEST_METHOD(MovedStaticBodyCollidesAtNewPlace)
+		{
+			EnginePtr engine = IEngine::Create();
+			engine->SetWorldConstants(0, 0, 0);
+			BodyPtr wall = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 5000, 5000 }, fVec2D{ 0, 0 }, 1, IBody::BodyType::Static);
+			BodyPtr body = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 100, 300 }, fVec2D{ 50, 0 }, 1);
+			engine->AddBody(wall);
+			engine->AddBody(body);
+			engine->Step(1.0 / 60);
+
+			wall->SetPosition(Point{ 150, 300 });
+			for (int i = 0; i < 60; ++i)
+				engine->Step(1.0 / 60);
+
+			Assert::AreEqual(-50 * static_cast<float>(kBounceFactor), static_cast<float>(body->GetVelocityVector().x), 1e-3f);
+		}
+	};
+}
@@ -0,0 +1,127 @@
+#include "CppUnitTest.h"
+
+#include <phys_command_queue.h>
+#include <phys_engine.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace physic;
+
+namespace test_PhysicEngine
+{
+	TEST_CLASS(CommandQueueTest)
+	{
+	public:
+
+		TEST_METHOD(BoundedCapacity)
+		{
+			CommandQueue<int> queue(4);
+			for (int i = 0; i < 4; ++i)
+				Assert::IsTrue(queue.push(int(i)));
+			Assert::IsFalse(queue.push(4));
+
+			int value = -1;
+			Assert::IsTrue(queue.pop(value));
+			Assert::AreEqual(0, value);
+			// Freed cell is reused on the next lap
+			Assert::IsTrue(queue.push(4));
+
+			for (int i = 1; i <= 4; ++i)
+			{
+				Assert::IsTrue(queue.pop(value));
+				Assert::AreEqual(i, value);
+			}
+			Assert::IsFalse(queue.pop(value));
+		}
+
+		TEST_METHOD(ProducersUnderContention)
+		{
+			const int kProducers = 4;
+			const int kPerProducer = 100000;
+
+			// Small ring, so producers keep running into a full queue
+			CommandQueue<int> queue(256);
+			std::atomic<bool> start(false);
+
+			std::vector<std::thread> producers;
+			for (int p = 0; p < kProducers; ++p)
+			{
+				producers.emplace_back([&queue, &start, p, kPerProducer]()
+				{
+					while (!start.load())
+						std::this_thread::yield();
+
+					for (int i = 0; i < kPerProducer; ++i)
+						while (!queue.push(p * kPerProducer + i))
+							std::this_thread::yield();
+				});
+			}
+
+			start.store(true);
+
+			// Items of every producer come out in order of pushing
+			std::vector<int> next(kProducers, 0);
+			int popped = 0;
+			int value;
+			while (popped < kProducers * kPerProducer)
+			{
+				if (!queue.pop(value))
+				{
+					std::this_thread::yield();
+					continue;
+				}
+
+				const int producer = value / kPerProducer;
+				Assert::AreEqual(next[producer], value % kPerProducer);
+				++next[producer];
+				++popped;
+			}
+
+			for (auto& producer : producers)
+				producer.join();
+
+			Assert::IsFalse(queue.pop(value));
+			for (int p = 0; p < kProducers; ++p)
+				Assert::AreEqual(kPerProducer, next[p]);
+		}
+
+		TEST_METHOD(EngineAppliesPushedCommands)
+		{
+			EnginePtr engine = IEngine::Create();
+			engine->SetWorldConstants(0, 0, 0);
+
+			const int kThreads = 4;
+			const int kPerThread = 250;
+			std::vector<std::vector<BodyPtr>> bodies(kThreads);
+			std::vector<std::thread> threads;
+			for (int t = 0; t < kThreads; ++t)
+			{
+				threads.emplace_back([&engine, &bodies, t, kPerThread]()
+				{
+					for (int i = 0; i < kPerThread; ++i)
+					{
+						const Point position{ Scalar(20 + t * 400 + (i % 10) * 30), Scalar(20 + (i / 10) * 30) };
+						BodyPtr body = IBody::CreateBody(IShape::ShapeType::Circle, position, fVec2D{ 0, 0 }, 1);
+						bodies[t].push_back(body);
+						engine->PushCommand(BodyCommand{ BodyCommand::Type::Add, body, fVec2D{ 0, 0 } });
+						engine->PushCommand(BodyCommand{ BodyCommand::Type::SetVelocity, body, fVec2D{ 0, 60 } });
+					}
+				});
+			}
+
+			for (auto& thread : threads)
+				thread.join();
+
+			engine->Step(1.0 / 60);
+
+			std::vector<BodyState> states;
+			engine->GetBodyStates(states);
+			Assert::AreEqual(size_t(kThreads * kPerThread), states.size());
+			for (const auto& state : states)
+				Assert::AreEqual(60.f, static_cast<float>(state.velocity.y), 1e-3f);
+		}
+	};
+}
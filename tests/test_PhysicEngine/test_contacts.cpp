@@ -0,0 +1,147 @@
+#include "CppUnitTest.h"
+
+#include <phys_engine.h>
+
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace physic;
+
+namespace test_PhysicEngine
+{
+	namespace
+	{
+		class ContactRecorder : public IContactListener
+		{
+		public:
+			void OnContacts(const ContactEvent* events, size_t count) override
+			{
+				m_events.insert(m_events.end(), events, events + count);
+			}
+
+			size_t count(ContactEvent::Type type) const
+			{
+				size_t result = 0;
+				for (const auto& event : m_events)
+					if (event.type == type)
+						++result;
+				return result;
+			}
+
+			const std::vector<ContactEvent>& events() const
+			{
+				return m_events;
+			}
+
+		private:
+			std::vector<ContactEvent> m_events;
+		};
+
+		// Two bodies moving towards each other along x without gravity
+		struct HeadOn
+		{
+			HeadOn()
+				: engine(IEngine::Create())
+				, left(IBody::CreateBody(IShape::ShapeType::Circle, Point{ 100, 100 }, fVec2D{ 50, 0 }, 1))
+				, right(IBody::CreateBody(IShape::ShapeType::Circle, Point{ 150, 100 }, fVec2D{ -50, 0 }, 1))
+			{
+				engine->SetWorldConstants(0, 0, 0);
+				engine->SetContactListener(&recorder);
+			}
+
+			void run(int steps)
+			{
+				engine->AddBody(left);
+				engine->AddBody(right);
+				for (int i = 0; i < steps; ++i)
+					engine->Step(1.0 / 60);
+			}
+
+			EnginePtr engine;
+			BodyPtr left;
+			BodyPtr right;
+			ContactRecorder recorder;
+		};
+	}
+
+	TEST_CLASS(ContactTest)
+	{
+	public:
+
+		TEST_METHOD(BeginThenEnd)
+		{
+			HeadOn scene;
+			scene.run(60);
+
+			const auto& events = scene.recorder.events();
+			Assert::AreEqual(size_t(1), scene.recorder.count(ContactEvent::Type::Begin));
+			Assert::AreEqual(size_t(1), scene.recorder.count(ContactEvent::Type::End));
+			Assert::IsTrue(ContactEvent::Type::Begin == events.front().type);
+			Assert::IsTrue(ContactEvent::Type::End == events.back().type);
+
+			const ContactEvent& begin = events.front();
+			Assert::IsTrue(begin.first < begin.second);
+			Assert::IsFalse(begin.sensor);
+			// Normal points from first body to second one
+			const BodyPtr& first = begin.first == scene.left->GetId() ? scene.left : scene.right;
+			const BodyPtr& second = begin.first == scene.left->GetId() ? scene.right : scene.left;
+			Assert::IsTrue((second->GetPosition().x - first->GetPosition().x) * begin.normal.x > 0);
+
+			// Bodies bounced off each other
+			Assert::IsTrue(scene.left->GetVelocityVector().x < 0);
+			Assert::IsTrue(scene.right->GetVelocityVector().x > 0);
+		}
+
+		TEST_METHOD(SensorReportsButDoesNotCollide)
+		{
+			HeadOn scene;
+			scene.left->SetSensor(true);
+			scene.run(60);
+
+			Assert::AreEqual(size_t(1), scene.recorder.count(ContactEvent::Type::Begin));
+			Assert::AreEqual(size_t(1), scene.recorder.count(ContactEvent::Type::End));
+			for (const auto& event : scene.recorder.events())
+				Assert::IsTrue(event.sensor);
+
+			// Passed through each other
+			Assert::IsTrue(scene.left->GetPosition().x > scene.right->GetPosition().x);
+			Assert::AreEqual(50.f, static_cast<float>(scene.left->GetVelocityVector().x), 1e-3f);
+		}
+
+		TEST_METHOD(FilterRules)
+		{
+			const CollisionFilter first = { 0x0001, 0xFFFD, 0 };
+			const CollisionFilter second = { 0x0002, 0xFFFF, 0 };
+			Assert::IsFalse(ShouldCollide(first, second));
+			Assert::IsTrue(ShouldCollide(first, kDefaultCollisionFilter));
+
+			// Same positive group collides regardless of masks, same negative one never does
+			Assert::IsTrue(ShouldCollide({ 0x0001, 0x0000, 3 }, { 0x0001, 0x0000, 3 }));
+			Assert::IsFalse(ShouldCollide({ 0x0001, 0xFFFF, -3 }, { 0x0001, 0xFFFF, -3 }));
+			// Different groups fall back to masks
+			Assert::IsTrue(ShouldCollide({ 0x0001, 0xFFFF, -3 }, { 0x0001, 0xFFFF, -4 }));
+		}
+
+		TEST_METHOD(FilteredBodiesPassThrough)
+		{
+			HeadOn scene;
+			scene.left->SetCollisionFilter({ 0x0001, 0xFFFD, 0 });
+			scene.right->SetCollisionFilter({ 0x0002, 0xFFFF, 0 });
+			scene.run(60);
+
+			Assert::IsTrue(scene.recorder.events().empty());
+			Assert::IsTrue(scene.left->GetPosition().x > scene.right->GetPosition().x);
+		}
+
+		TEST_METHOD(NegativeGroupPassesThrough)
+		{
+			HeadOn scene;
+			scene.left->SetCollisionFilter({ 0x0001, 0xFFFF, -1 });
+			scene.right->SetCollisionFilter({ 0x0001, 0xFFFF, -1 });
+			scene.run(60);
+
+			Assert::IsTrue(scene.recorder.events().empty());
+			Assert::IsTrue(scene.left->GetPosition().x > scene.right->GetPosition().x);
+		}
+	};
+}
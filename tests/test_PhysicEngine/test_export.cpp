@@ -0,0 +1,107 @@
+#include "CppUnitTest.h"
+
+#include <phys_engine.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace physic;
+
+namespace test_PhysicEngine
+{
+	TEST_CLASS(ExportTest)
+	{
+	public:
+
+		TEST_METHOD(ExportBodiesCopiesEveryType)
+		{
+			EnginePtr engine = IEngine::Create();
+			engine->SetWorldConstants(0, 0, 0);
+
+			std::vector<BodyPtr> bodies;
+			bodies.push_back(IBody::CreateBody(IShape::ShapeType::Circle, Point{ 100, 100 }, fVec2D{ 10, 0 }, 1));
+			bodies.push_back(IBody::CreateBody(IShape::ShapeType::Circle, Point{ 200, 100 }, fVec2D{ 0, 10 }, 1));
+			bodies.push_back(IBody::CreateBody(IShape::ShapeType::Circle, Point{ 300, 100 }, fVec2D{ -5, 0 }, 1, IBody::BodyType::Kinematic));
+			bodies.push_back(IBody::CreateBody(IShape::ShapeType::Circle, Point{ 400, 100 }, fVec2D{ 0, 0 }, 1, IBody::BodyType::Static));
+			for (auto& body : bodies)
+				engine->AddBody(body);
+			engine->Step(1.0 / 60);
+
+			std::vector<ExportedBody> exported(8);
+			Assert::AreEqual(bodies.size(), engine->ExportBodies(exported.data(), exported.size()));
+			for (const auto& body : bodies)
+			{
+				auto found = std::find_if(std::begin(exported), std::begin(exported) + bodies.size(),
+					[&body](const ExportedBody& entry) { return entry.id == body->GetId(); });
+				Assert::IsTrue(found != std::begin(exported) + bodies.size());
+				Assert::IsTrue(found->position == body->GetPosition());
+				Assert::IsTrue(found->velocity == body->GetVelocityVector());
+			}
+		}
+
+		TEST_METHOD(ExportBodiesReportsOverflow)
+		{
+			EnginePtr engine = IEngine::Create();
+			for (int i = 0; i < 5; ++i)
+			{
+				BodyPtr body = IBody::CreateBody(IShape::ShapeType::Circle, Point{ Scalar(100 + i * 50), 100 }, fVec2D{ 0, 0 }, 1);
+				engine->AddBody(body);
+			}
+			engine->Step(1.0 / 60);
+
+			// Nothing is written past capacity, total is returned anyway
+			const BodyId sentinel = 0xFFFFFFFF;
+			std::vector<ExportedBody> exported(3);
+			exported[2].id = sentinel;
+			Assert::AreEqual(size_t(5), engine->ExportBodies(exported.data(), 2));
+			Assert::AreEqual(sentinel, exported[2].id);
+			Assert::AreEqual(size_t(5), engine->ExportBodies(nullptr, 0));
+		}
+
+		TEST_METHOD(ExportBodiesInRectMatchesBruteForce)
+		{
+			EnginePtr engine = IEngine::Create();
+			engine->SetWorldConstants(0, 0, 0);
+
+			std::vector<BodyPtr> bodies;
+			for (int i = 0; i < 400; ++i)
+			{
+				const Point position{ Scalar(20 + (i % 20) * 45), Scalar(20 + (i / 20) * 45) };
+				const IBody::BodyType type = 0 == i % 7 ? IBody::BodyType::Static : IBody::BodyType::Dynamic;
+				BodyPtr body = IBody::CreateBody(IShape::ShapeType::Circle, position, fVec2D{ 0, 0 }, 1, type);
+				engine->AddBody(body);
+				bodies.push_back(body);
+			}
+			engine->Step(1.0 / 60);
+
+			// Viewport edges cut through bodies, ones overlapping it by radius only are exported too
+			const Point bot_left{ 160, 250 };
+			const Point top_right{ 510, 600 };
+			std::vector<BodyId> expected;
+			for (const auto& body : bodies)
+			{
+				const Point position = body->GetPosition();
+				const Scalar radius = body->GetRadius();
+				const Scalar dx = std::max(std::max(bot_left.x - position.x, position.x - top_right.x), Scalar(0));
+				const Scalar dy = std::max(std::max(bot_left.y - position.y, position.y - top_right.y), Scalar(0));
+				if (dx * dx + dy * dy <= radius * radius)
+					expected.push_back(body->GetId());
+			}
+
+			std::vector<ExportedBody> exported(bodies.size());
+			const size_t count = engine->ExportBodiesInRect(bot_left, top_right, exported.data(), exported.size());
+			Assert::AreEqual(expected.size(), count);
+			std::vector<BodyId> ids;
+			for (size_t i = 0; i < count; ++i)
+				ids.push_back(exported[i].id);
+			std::sort(std::begin(expected), std::end(expected));
+			std::sort(std::begin(ids), std::end(ids));
+			Assert::IsTrue(expected == ids);
+
+			// Overflow is counted the same way as by ExportBodies
+			Assert::AreEqual(count, engine->ExportBodiesInRect(bot_left, top_right, exported.data(), 10));
+			Assert::AreEqual(count, engine->ExportBodiesInRect(bot_left, top_right, nullptr, 0));
+		}
+	};
+}
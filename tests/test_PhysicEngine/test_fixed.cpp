@@ -0,0 +1,84 @@
+#include "CppUnitTest.h"
+
+#include <phys_engine.h>
+#include <phys_fixed.h>
+
+#include <cmath>
+#include <stdexcept>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace physic;
+
+namespace test_PhysicEngine
+{
+	TEST_CLASS(FixedTest)
+	{
+	public:
+
+		TEST_METHOD(Arithmetic)
+		{
+			Assert::AreEqual(5.75, static_cast<double>(Fixed(2.5) + Fixed(3.25)));
+			Assert::AreEqual(-0.75, static_cast<double>(Fixed(2.5) - Fixed(3.25)));
+			Assert::AreEqual(-8.125, static_cast<double>(Fixed(-2.5) * Fixed(3.25)));
+			Assert::AreEqual(3.5, static_cast<double>(Fixed(7) / Fixed(2)));
+			Assert::AreEqual(-3.5, static_cast<double>(Fixed(-7) / Fixed(2)));
+			Assert::AreEqual(3.0, static_cast<double>(sqrt(Fixed(9))));
+		}
+
+		TEST_METHOD(DivisionByLargeDivisor)
+		{
+			// Divisor above 2^48 must not overflow when scaled
+			const Fixed big = Fixed::FromRaw(int64_t(1) << 60);
+			const Fixed divisor = Fixed::FromRaw((int64_t(1) << 60) / 3 * 2);
+
+			Assert::AreEqual(1.5, static_cast<double>(big / divisor));
+			Assert::AreEqual(-1.5, static_cast<double>(-big / divisor));
+		}
+
+		TEST_METHOD(RoundHalfAwayFromZero)
+		{
+			Assert::AreEqual(3.0, static_cast<double>(round(Fixed(2.5))));
+			Assert::AreEqual(-3.0, static_cast<double>(round(Fixed(-2.5))));
+			Assert::AreEqual(-2.0, static_cast<double>(round(Fixed(-2.4))));
+			Assert::AreEqual(-1.0, static_cast<double>(round(Fixed(-0.5))));
+			Assert::AreEqual(1.0, static_cast<double>(round(Fixed(1.49))));
+
+			// Conversion from floating point rounds the same way
+			Assert::IsTrue(Fixed::FromRaw(-2) == Fixed(-1.5 / Fixed::kOne));
+			Assert::IsTrue(Fixed::FromRaw(2) == Fixed(1.5 / Fixed::kOne));
+		}
+
+		TEST_METHOD(Trigonometry)
+		{
+			const double lsb = 1.0 / Fixed::kOne;
+			for (double angle = -50; angle <= 50; angle += 0.01)
+			{
+				const Fixed f(angle);
+				const double exact = static_cast<double>(f);
+				Assert::AreEqual(std::sin(exact), static_cast<double>(sin(f)), 2 * lsb);
+				Assert::AreEqual(std::cos(exact), static_cast<double>(cos(f)), 2 * lsb);
+			}
+
+			for (double c = -1; c <= 1; c += 0.001)
+			{
+				const Fixed f(c);
+				Assert::AreEqual(std::acos(static_cast<double>(f)), static_cast<double>(acos(f)), 8 * lsb);
+			}
+		}
+
+		TEST_METHOD(AcosClampsArgument)
+		{
+			Assert::AreEqual(0.0, static_cast<double>(acos(Fixed(1.2))), 1e-4);
+			Assert::AreEqual(std::acos(-1.0), static_cast<double>(acos(Fixed(-1.2))), 1e-4);
+		}
+
+		TEST_METHOD(EngineRejectsOtherScalarKind)
+		{
+			// Caller built with other phys_config.h than the engine
+			const ScalarKind other = kScalarKind == ScalarKind::Float ? ScalarKind::Double : ScalarKind::Float;
+			Assert::ExpectException<std::logic_error>([other]() { IEngine::Create(other); });
+			Assert::ExpectException<std::logic_error>([other]() { IEngine::Instance(other); });
+			Assert::IsTrue(IEngine::Create() != nullptr);
+		}
+	};
+}
@@ -0,0 +1,136 @@
+#include "CppUnitTest.h"
+
+#include <phys_engine.h>
+
+#include <cmath>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace physic;
+
+namespace test_PhysicEngine
+{
+	namespace
+	{
+		EnginePtr CreateEmptyWorld()
+		{
+			EnginePtr engine = IEngine::Create();
+			engine->SetWorldConstants(0, 0, 0);
+			return engine;
+		}
+
+		BodyPtr AddBody(EnginePtr& engine, const Point& position, const fVec2D& velocity, Scalar mass)
+		{
+			BodyPtr body = IBody::CreateBody(IShape::ShapeType::Circle, position, velocity, mass);
+			engine->AddBody(body);
+			return body;
+		}
+	}
+
+	TEST_CLASS(ForceFieldTest)
+	{
+	public:
+
+		TEST_METHOD(UniformFieldAcceleratesRegardlessOfMass)
+		{
+			EnginePtr engine = CreateEmptyWorld();
+			BodyPtr light = AddBody(engine, Point{ 100, 1000 }, fVec2D{ 0, 0 }, 1);
+			BodyPtr heavy = AddBody(engine, Point{ 200, 1000 }, fVec2D{ 0, 0 }, 5);
+
+			const ForceFieldPtr field = IForceField::CreateUniform(fVec2D{ 0, -10 });
+			engine->AddForceField(field);
+			engine->Step(0.5);
+			Assert::AreEqual(-5.f, static_cast<float>(light->GetVelocityVector().y), 1e-4f);
+			Assert::AreEqual(-5.f, static_cast<float>(heavy->GetVelocityVector().y), 1e-4f);
+
+			// Removed field doesn't act anymore
+			engine->RemoveForceField(field);
+			engine->Step(0.5);
+			Assert::AreEqual(-5.f, static_cast<float>(light->GetVelocityVector().y), 1e-4f);
+		}
+
+		TEST_METHOD(WorldConstantsReplaceGravityField)
+		{
+			EnginePtr engine = IEngine::Create();
+			engine->SetWorldConstants(20, 0, 0);
+			BodyPtr body = AddBody(engine, Point{ 100, 1000 }, fVec2D{ 0, 0 }, 1);
+
+			engine->Step(0.5);
+			Assert::AreEqual(-10.f, static_cast<float>(body->GetVelocityVector().y), 1e-3f);
+
+			engine->SetWorldConstants(0, 0, 0);
+			engine->Step(0.5);
+			Assert::AreEqual(-10.f, static_cast<float>(body->GetVelocityVector().y), 1e-3f);
+		}
+
+		TEST_METHOD(LocalFieldActsInsideBoundsOnly)
+		{
+			EnginePtr engine = CreateEmptyWorld();
+			BodyPtr inside = AddBody(engine, Point{ 150, 150 }, fVec2D{ 0, 0 }, 1);
+			BodyPtr outside = AddBody(engine, Point{ 500, 150 }, fVec2D{ 0, 0 }, 1);
+
+			engine->AddForceField(IForceField::CreateWind(Point{ 100, 100 }, Point{ 200, 200 }, fVec2D{ 10, 0 }, 2));
+			engine->Step(0.1);
+
+			// Drag towards wind velocity of factor 2 for 0.1 s from rest
+			Assert::AreEqual(2.f, static_cast<float>(inside->GetVelocityVector().x), 1e-3f);
+			Assert::IsTrue(fVec2D{ 0, 0 } == outside->GetVelocityVector());
+		}
+
+		TEST_METHOD(LocalFieldSkipsKinematicBodies)
+		{
+			EnginePtr engine = CreateEmptyWorld();
+			BodyPtr body = AddBody(engine, Point{ 150, 150 }, fVec2D{ 0, 0 }, 1);
+			BodyPtr kinematic = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 170, 150 }, fVec2D{ 0, 0 }, 1,
+				IBody::BodyType::Kinematic);
+			engine->AddBody(kinematic);
+
+			engine->AddForceField(IForceField::CreateWind(Point{ 100, 100 }, Point{ 200, 200 }, fVec2D{ 10, 0 }, 2));
+			engine->Step(0.1);
+
+			Assert::AreEqual(2.f, static_cast<float>(body->GetVelocityVector().x), 1e-3f);
+			Assert::IsTrue(fVec2D{ 0, 0 } == kinematic->GetVelocityVector());
+		}
+
+		TEST_METHOD(LocalFieldActsOnBodyMovedIntoBoundsOnSameStep)
+		{
+			// Body outside of world is put back on its border far from where it was indexed
+			EnginePtr engine = CreateEmptyWorld();
+			BodyPtr body = AddBody(engine, Point{ 3500, 150 }, fVec2D{ 0, 0 }, 1);
+
+			engine->AddForceField(IForceField::CreateWind(Point{ 1990, 100 }, Point{ 2100, 200 }, fVec2D{ 10, 0 }, 2));
+			engine->Step(0.1);
+
+			Assert::AreEqual(2.f, static_cast<float>(body->GetVelocityVector().x), 1e-3f);
+		}
+
+		TEST_METHOD(RadialFieldPushesAway)
+		{
+			EnginePtr engine = CreateEmptyWorld();
+			BodyPtr left = AddBody(engine, Point{ 450, 500 }, fVec2D{ 0, 0 }, 1);
+			BodyPtr right = AddBody(engine, Point{ 550, 500 }, fVec2D{ 0, 0 }, 1);
+			BodyPtr far_body = AddBody(engine, Point{ 900, 500 }, fVec2D{ 0, 0 }, 1);
+
+			// Explosion fading out at radius 200
+			engine->AddForceField(IForceField::CreateRadial(Point{ 500, 500 }, 200, -100));
+			engine->Step(0.1);
+
+			Assert::IsTrue(left->GetVelocityVector().x < Scalar(0));
+			Assert::IsTrue(right->GetVelocityVector().x > Scalar(0));
+			Assert::AreEqual(-static_cast<float>(left->GetVelocityVector().x), static_cast<float>(right->GetVelocityVector().x), 1e-4f);
+			Assert::IsTrue(fVec2D{ 0, 0 } == far_body->GetVelocityVector());
+		}
+
+		TEST_METHOD(DragSlowsBodiesDown)
+		{
+			EnginePtr engine = CreateEmptyWorld();
+			BodyPtr body = AddBody(engine, Point{ 100, 1000 }, fVec2D{ 100, 0 }, 1);
+
+			engine->AddForceField(IForceField::CreateDrag(1));
+			for (int i = 0; i < 10; ++i)
+				engine->Step(0.1);
+
+			// Each step takes a tenth of velocity
+			Assert::AreEqual(100 * std::pow(0.9f, 10.f), static_cast<float>(body->GetVelocityVector().x), 1e-2f);
+		}
+	};
+}
@@ -0,0 +1,105 @@
+#include "CppUnitTest.h"
+
+#include <phys_engine.h>
+
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace physic;
+
+namespace test_PhysicEngine
+{
+	TEST_CLASS(ForceTest)
+	{
+	public:
+
+		TEST_METHOD(ForcesAreSummedUntilStep)
+		{
+			EnginePtr engine = IEngine::Create();
+			engine->SetWorldConstants(0, 0, 0);
+
+			std::vector<BodyPtr> bodies;
+			for (int i = 0; i < 3; ++i)
+			{
+				BodyPtr body = IBody::CreateBody(IShape::ShapeType::Circle, Point{ Scalar(100 + 50 * i), 100 }, fVec2D{ 0, 0 }, 2);
+				engine->AddBody(body);
+				bodies.push_back(body);
+			}
+
+			const fVec2D forces[3] = { fVec2D{ 120, 0 }, fVec2D{ 0, -60 }, fVec2D{ 30, 30 } };
+			engine->ApplyForces(bodies.data(), forces, 3);
+			engine->ApplyForces(bodies.data(), forces, 1);
+
+			Assert::IsTrue(fVec2D{ 240, 0 } == bodies[0]->GetPendingForce());
+			Assert::IsTrue(forces[1] == bodies[1]->GetPendingForce());
+
+			// Velocity changes by force over mass for dt, pending forces are consumed by the step
+			engine->Step(0.5);
+			Assert::AreEqual(60.f, static_cast<float>(bodies[0]->GetVelocityVector().x), 1e-4f);
+			Assert::AreEqual(-15.f, static_cast<float>(bodies[1]->GetVelocityVector().y), 1e-4f);
+			Assert::AreEqual(7.5f, static_cast<float>(bodies[2]->GetVelocityVector().x), 1e-4f);
+			for (const auto& body : bodies)
+				Assert::IsTrue(fVec2D{ 0, 0 } == body->GetPendingForce());
+
+			// Without new forces velocity stays
+			engine->Step(0.5);
+			Assert::AreEqual(60.f, static_cast<float>(bodies[0]->GetVelocityVector().x), 1e-4f);
+		}
+
+		TEST_METHOD(ImpulseChangesVelocityAtOnce)
+		{
+			EnginePtr engine = IEngine::Create();
+			engine->SetWorldConstants(0, 0, 0);
+
+			BodyPtr body = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 100, 100 }, fVec2D{ 0, 0 }, 4);
+			engine->AddBody(body);
+			body->ApplyImpulse(fVec2D{ 8, 0 });
+			body->ApplyImpulse(fVec2D{ 0, 4 });
+			Assert::IsTrue(fVec2D{ 8, 4 } == body->GetPendingImpulse());
+
+			// Impulse doesn't depend on dt
+			engine->Step(0.01);
+			Assert::AreEqual(2.f, static_cast<float>(body->GetVelocityVector().x), 1e-4f);
+			Assert::AreEqual(1.f, static_cast<float>(body->GetVelocityVector().y), 1e-4f);
+			Assert::IsTrue(fVec2D{ 0, 0 } == body->GetPendingImpulse());
+		}
+
+		TEST_METHOD(BodyMovesAlongParabolaOfStep)
+		{
+			EnginePtr engine = IEngine::Create();
+			engine->SetWorldConstants(0, 0, 0);
+
+			BodyPtr pushed = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 100, 100 }, fVec2D{ 10, 0 }, 2);
+			BodyPtr kicked = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 100, 300 }, fVec2D{ 0, 0 }, 2);
+			engine->AddBody(pushed);
+			engine->AddBody(kicked);
+
+			// Position changes by v * dt + a * dt^2 / 2, impulse moves body only from next step
+			pushed->ApplyForce(fVec2D{ 120, 0 });
+			kicked->ApplyImpulse(fVec2D{ 40, 0 });
+			engine->Step(0.5);
+			Assert::AreEqual(112.5f, static_cast<float>(pushed->GetPosition().x), 1e-4f);
+			Assert::AreEqual(40.f, static_cast<float>(pushed->GetVelocityVector().x), 1e-4f);
+			Assert::AreEqual(100.f, static_cast<float>(kicked->GetPosition().x), 1e-4f);
+			Assert::AreEqual(20.f, static_cast<float>(kicked->GetVelocityVector().x), 1e-4f);
+
+			engine->Step(0.5);
+			Assert::AreEqual(132.5f, static_cast<float>(pushed->GetPosition().x), 1e-4f);
+			Assert::AreEqual(110.f, static_cast<float>(kicked->GetPosition().x), 1e-4f);
+		}
+
+		TEST_METHOD(GravityPullsStraightDown)
+		{
+			EnginePtr engine = IEngine::Create();
+			engine->SetWorldConstants(200, 0, 0);
+
+			BodyPtr body = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 100, 1000 }, fVec2D{ 0, 0 }, 1);
+			engine->AddBody(body);
+			for (int i = 0; i < 120; ++i)
+				engine->Step(1.0 / 60);
+
+			Assert::IsTrue(Scalar(100) == body->GetPosition().x);
+			Assert::IsTrue(body->GetPosition().y < 1000);
+		}
+	};
+}
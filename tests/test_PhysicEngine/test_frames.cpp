@@ -0,0 +1,109 @@
+#include "CppUnitTest.h"
+
+#include <phys_engine.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace physic;
+
+namespace
+{
+	// Wait for simulation thread to publish frame of at least step, nullptr on timeout
+	FramePtr WaitForFrame(const EnginePtr& engine, uint64_t step)
+	{
+		const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+		while (std::chrono::steady_clock::now() < deadline)
+		{
+			FramePtr frame = engine->GetFrame();
+			if (nullptr != frame && frame->step >= step)
+				return frame;
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		return nullptr;
+	}
+}
+
+namespace test_PhysicEngine
+{
+	TEST_CLASS(FrameTest)
+	{
+	public:
+
+		TEST_METHOD(SimulationPublishesFrames)
+		{
+			EnginePtr engine = IEngine::Create();
+			engine->SetWorldConstants(0, 0, 0);
+			BodyPtr body = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 100, 100 }, fVec2D{ 10, 0 }, 1);
+			engine->AddBody(body);
+			Assert::IsTrue(nullptr == engine->GetFrame());
+
+			engine->StartSimulation(0.002);
+			FramePtr first = WaitForFrame(engine, 1);
+			Assert::IsTrue(nullptr != first);
+			FramePtr later = WaitForFrame(engine, first->step + 5);
+			engine->StopSimulation();
+			Assert::IsTrue(nullptr != later);
+
+			// Frames are never changed once published
+			Assert::IsTrue(later->step > first->step);
+			Assert::AreEqual(size_t(1), first->bodies.size());
+			Assert::AreEqual(body->GetId(), first->bodies.front().id);
+			Assert::IsTrue(later->bodies.front().position.x > first->bodies.front().position.x);
+
+			// The last frame matches the stopped engine
+			FramePtr last = engine->GetFrame();
+			Assert::AreEqual(engine->GetStepIndex(), last->step);
+			Assert::IsTrue(body->GetPosition() == last->bodies.front().position);
+		}
+
+		TEST_METHOD(CommandsReachRunningSimulation)
+		{
+			EnginePtr engine = IEngine::Create();
+			engine->SetWorldConstants(0, 0, 0);
+			BodyPtr body = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 100, 100 }, fVec2D{ 0, 0 }, 1);
+			engine->AddBody(body);
+
+			engine->StartSimulation(0.002);
+			FramePtr before = WaitForFrame(engine, 1);
+			Assert::IsTrue(nullptr != before);
+			BodyCommand command = BodyCommand();
+			command.type = BodyCommand::Type::SetVelocity;
+			command.body = body;
+			command.value = fVec2D{ 0, 50 };
+			Assert::IsTrue(engine->PushCommand(command));
+
+			// Body starts moving on one of the next steps
+			FramePtr moved;
+			for (uint64_t step = before->step + 1; nullptr == moved || moved->bodies.front().position.y == 100; ++step)
+			{
+				moved = WaitForFrame(engine, step);
+				Assert::IsTrue(nullptr != moved);
+			}
+			engine->StopSimulation();
+			Assert::IsTrue(moved->bodies.front().velocity == (fVec2D{ 0, 50 }));
+		}
+
+		TEST_METHOD(FrameOutlivesEngine)
+		{
+			FramePtr frame;
+			{
+				EnginePtr engine = IEngine::Create();
+				for (int i = 0; i < 3; ++i)
+				{
+					BodyPtr body = IBody::CreateBody(IShape::ShapeType::Circle, Point{ Scalar(100 + 50 * i), 100 }, fVec2D{ 0, 0 }, 1);
+					engine->AddBody(body);
+				}
+				engine->StartSimulation(0.002);
+				frame = WaitForFrame(engine, 3);
+				engine->StopSimulation();
+			}
+
+			Assert::IsTrue(nullptr != frame);
+			Assert::AreEqual(size_t(3), frame->bodies.size());
+			frame.reset();
+		}
+	};
+}
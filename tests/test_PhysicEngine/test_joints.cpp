@@ -0,0 +1,147 @@
+#include "CppUnitTest.h"
+
+#include <phys_engine.h>
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace physic;
+
+namespace
+{
+	double Distance(const Point& a, const Point& b)
+	{
+		return std::hypot(static_cast<double>(a.x - b.x), static_cast<double>(a.y - b.y));
+	}
+
+	// Body of active first chunk jointed to body of the next chunk, which is frozen
+	struct FrozenPair
+	{
+		FrozenPair()
+			: engine(IEngine::Create())
+			, near(IBody::CreateBody(IShape::ShapeType::Circle, Point{ 950, 500 }, fVec2D{ -50, 0 }, 1))
+			, far(IBody::CreateBody(IShape::ShapeType::Circle, Point{ 1100, 500 }, fVec2D{ 0, 0 }, 1))
+		{
+			engine->SetWorldConstants(0, 0, 0);
+			engine->AddBody(near);
+			engine->AddBody(far);
+			engine->AddJoint(JointDef{ JointDef::Type::Rope, near, far, 150, 0, 0 });
+
+			const ActivityRegion region = { Point{ 0, 0 }, Point{ 900, 900 } };
+			engine->SetActivityRegions(&region, 1);
+		}
+
+		EnginePtr engine;
+		BodyPtr near;
+		BodyPtr far;
+	};
+}
+
+namespace test_PhysicEngine
+{
+	TEST_CLASS(JointTest)
+	{
+	public:
+
+		TEST_METHOD(JointsKeepDistance)
+		{
+			EnginePtr engine = IEngine::Create();
+			engine->SetWorldConstants(200, 0, 0);
+
+			BodyPtr anchor = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 1000, 1800 }, fVec2D{ 0, 0 }, 1, IBody::BodyType::Static);
+			engine->AddBody(anchor);
+
+			// Horizontal chain swinging down from static anchor
+			std::vector<BodyPtr> chain;
+			BodyPtr previous = anchor;
+			for (int i = 0; i < 10; ++i)
+			{
+				BodyPtr link = IBody::CreateBody(IShape::ShapeType::Circle, Point{ Scalar(1000 + 25 * (i + 1)), 1800 }, fVec2D{ 0, 0 }, 1);
+				engine->AddBody(link);
+				engine->AddJoint(JointDef{ JointDef::Type::Distance, previous, link, 25, 0, 0 });
+				chain.push_back(link);
+				previous = link;
+			}
+
+			BodyPtr rope_anchor = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 500, 1800 }, fVec2D{ 0, 0 }, 1, IBody::BodyType::Static);
+			BodyPtr rope_end = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 500, 1800 }, fVec2D{ 0, 0 }, 1);
+			engine->AddBody(rope_end);
+			engine->AddJoint(JointDef{ JointDef::Type::Rope, rope_anchor, rope_end, 100, 0, 0 });
+
+			BodyPtr spring_anchor = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 200, 1800 }, fVec2D{ 0, 0 }, 1, IBody::BodyType::Static);
+			BodyPtr spring_end = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 200, 1800 }, fVec2D{ 0, 0 }, 1);
+			engine->AddBody(spring_end);
+			const JointId spring = engine->AddJoint(JointDef{ JointDef::Type::Spring, spring_anchor, spring_end, 50, 100, 2 });
+
+			for (int step = 0; step < 600; ++step)
+			{
+				engine->Step(1.0 / 60);
+
+				double error = 0;
+				Point previous_position = anchor->GetPosition();
+				for (const auto& link : chain)
+				{
+					error = std::max(error, std::fabs(Distance(previous_position, link->GetPosition()) - 25));
+					previous_position = link->GetPosition();
+				}
+				// Whipping chain stretches a little, never by a tenth of a link
+				Assert::IsTrue(error < 2.5);
+				Assert::IsTrue(Distance(rope_anchor->GetPosition(), rope_end->GetPosition()) < 100.5);
+			}
+
+			// Chain fell below anchor, rope is taut, spring settled where it holds the weight
+			Assert::IsTrue(chain.back()->GetPosition().y < 1800);
+			Assert::AreEqual(1700., static_cast<double>(rope_end->GetPosition().y), 0.5);
+			Assert::AreEqual(1800. - 50 - 200. / 100, static_cast<double>(spring_end->GetPosition().y), 0.5);
+
+			Assert::IsTrue(engine->RemoveJoint(spring));
+			Assert::IsFalse(engine->RemoveJoint(spring));
+		}
+
+		TEST_METHOD(FrozenBodyHoldsJoint)
+		{
+			FrozenPair pair;
+			for (int i = 0; i < 60; ++i)
+				pair.engine->Step(1.0 / 60);
+
+			// Frozen body is neither moved nor pulled, it holds the rope like a body of infinite mass
+			Assert::IsTrue(Point{ 1100, 500 } == pair.far->GetPosition());
+			Assert::IsTrue(fVec2D{ 0, 0 } == pair.far->GetVelocityVector());
+			Assert::IsTrue(Distance(pair.near->GetPosition(), pair.far->GetPosition()) < 150.5);
+			Assert::IsTrue(pair.near->GetVelocityVector().x > -1);
+
+			// Woken body is pulled again
+			pair.engine->SetActivityRegions(nullptr, 0);
+			pair.near->SetVelocityVector(fVec2D{ -50, 0 });
+			for (int i = 0; i < 60; ++i)
+				pair.engine->Step(1.0 / 60);
+			Assert::IsTrue(pair.far->GetPosition().x < 1100);
+		}
+
+		TEST_METHOD(StreamedBodyIsNotWritten)
+		{
+			namespace fs = std::filesystem;
+			const fs::path directory = fs::temp_directory_path() / "phys_joint_streaming";
+			fs::remove_all(directory);
+			fs::create_directories(directory);
+
+			FrozenPair pair;
+			pair.engine->SetStreamingDirectory(directory.string());
+			for (int i = 0; i < 60; ++i)
+				pair.engine->Step(1.0 / 60);
+
+			// Released object is still held by joint, but it is not simulated anymore
+			Assert::IsTrue(Point{ 1100, 500 } == pair.far->GetPosition());
+			Assert::IsTrue(fVec2D{ 0, 0 } == pair.far->GetVelocityVector());
+			Assert::IsTrue(Distance(pair.near->GetPosition(), Point{ 1100, 500 }) < 150.5);
+
+			pair.engine->SetActivityRegions(nullptr, 0);
+			pair.engine->Step(1.0 / 60);
+			Assert::IsTrue(fs::is_empty(directory));
+			fs::remove_all(directory);
+		}
+	};
+}
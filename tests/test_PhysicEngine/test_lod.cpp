@@ -0,0 +1,66 @@
+#include "CppUnitTest.h"
+
+#include <phys_engine.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace physic;
+
+namespace test_PhysicEngine
+{
+	TEST_CLASS(LodTest)
+	{
+	public:
+
+		TEST_METHOD(FarBodiesFollowLodSchedule)
+		{
+			EnginePtr engine = IEngine::Create();
+			engine->SetWorldBorders(Point{ 0, 0 }, Point{ 4000, 4000 });
+			engine->SetWorldConstants(0, 0, 0);
+
+			BodyPtr near_body = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 100, 100 }, fVec2D{ 60, 0 }, 1);
+			BodyPtr far_body = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 2000, 2000 }, fVec2D{ 60, 0 }, 1);
+			engine->AddBody(near_body);
+			engine->AddBody(far_body);
+
+			const Point focus{ 0, 0 };
+			const LodTier tier = { 1000, 4 };
+			engine->SetFocusPoints(&focus, 1);
+			engine->SetLodTiers(&tier, 1);
+
+			// Tiers are assigned on the first step
+			engine->Step(1.0 / 60);
+
+			// Bodies of a tier are spread over steps by id, so the first move of far body may come
+			// before a whole interval has passed
+			int near_moves = 0;
+			int far_moves = 0;
+			int far_skipped = 0;
+			for (int step = 0; step < 12; ++step)
+			{
+				const Point near_position = near_body->GetPosition();
+				const Point far_position = far_body->GetPosition();
+				engine->Step(1.0 / 60);
+				++far_skipped;
+				if (near_body->GetPosition() != near_position)
+					++near_moves;
+				if (far_body->GetPosition() != far_position)
+				{
+					++far_moves;
+					// Skipped time is simulated at once
+					Assert::AreEqual(double(far_skipped), static_cast<double>(far_body->GetPosition().x - far_position.x), 0.05);
+					far_skipped = 0;
+				}
+			}
+
+			Assert::AreEqual(12, near_moves);
+			Assert::AreEqual(3, far_moves);
+
+			// Back to full rate without tiers, pending time is caught up on the next step
+			engine->SetLodTiers(nullptr, 0);
+			engine->Step(1.0 / 60);
+			engine->Step(1.0 / 60);
+			Assert::AreEqual(static_cast<double>(near_body->GetPosition().x - 100),
+				static_cast<double>(far_body->GetPosition().x - 2000), 0.05);
+		}
+	};
+}
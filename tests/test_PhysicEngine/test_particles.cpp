@@ -0,0 +1,111 @@
+#include "CppUnitTest.h"
+
+#include <phys_engine.h>
+
+#include <algorithm>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace physic;
+
+namespace
+{
+	EnginePtr CreateWorld()
+	{
+		EnginePtr engine = IEngine::Create();
+		engine->SetWorldBorders(Point{ -20000, -20000 }, Point{ 20000, 20000 });
+		engine->SetWorldConstants(200, 0, 0);
+		return engine;
+	}
+
+	void AddStatic(const EnginePtr& engine, const Point& position)
+	{
+		BodyPtr body = IBody::CreateBody(IShape::ShapeType::Circle, position, fVec2D{ 0, 0 }, 1, IBody::BodyType::Static);
+		engine->AddBody(body);
+	}
+}
+
+namespace test_PhysicEngine
+{
+	TEST_CLASS(ParticleTest)
+	{
+	public:
+
+		TEST_METHOD(ParticlesFallAndExpire)
+		{
+			EnginePtr engine = CreateWorld();
+			ParticleSystemPtr particles = IParticleSystem::Create(2, 1, Scalar(0.5), false);
+			engine->AddParticleSystem(particles);
+
+			Assert::IsTrue(particles->Emit(Point{ 0, 0 }, fVec2D{ 10, 0 }, Scalar(0.5)));
+			Assert::IsTrue(particles->Emit(Point{ 0, 0 }, fVec2D{ 0, 0 }, Scalar(1.5)));
+			Assert::IsFalse(particles->Emit(Point{ 0, 0 }, fVec2D{ 0, 0 }, 1));
+			Assert::AreEqual(size_t(2), particles->GetParticles().count);
+
+			engine->Step(0.25);
+			ParticleData data = particles->GetParticles();
+			Assert::AreEqual(2.5f, static_cast<float>(data.x[0]), 1e-3f);
+			Assert::IsTrue(data.y[0] < 0 && data.velocity_y[0] < 0);
+
+			// Expired particle gives its place to a new one
+			engine->Step(0.25);
+			Assert::AreEqual(size_t(1), particles->GetParticles().count);
+			Assert::IsTrue(particles->Emit(Point{ 0, 0 }, fVec2D{ 0, 0 }, 1));
+
+			engine->RemoveParticleSystem(particles);
+			engine->Step(0.25);
+			Assert::AreEqual(size_t(2), particles->GetParticles().count);
+		}
+
+		TEST_METHOD(ParticlesBounceOffStaticBodies)
+		{
+			EnginePtr engine = CreateWorld();
+			AddStatic(engine, Point{ 100, 100 });
+
+			// Far statics in many other chunks must not change the result
+			for (int i = 1; i <= 10; ++i)
+				for (int j = 1; j <= 10; ++j)
+					AddStatic(engine, Point{ Scalar(-i * 1500), Scalar(j * 1500) });
+
+			ParticleSystemPtr bouncing = IParticleSystem::Create(1, 1, Scalar(0.5), true);
+			ParticleSystemPtr passing = IParticleSystem::Create(1, 1, Scalar(0.5), false);
+			engine->AddParticleSystem(bouncing);
+			engine->AddParticleSystem(passing);
+			bouncing->Emit(Point{ 100, 130 }, fVec2D{ 0, 0 }, 10);
+			passing->Emit(Point{ 100, 130 }, fVec2D{ 0, 0 }, 10);
+
+			Scalar lowest = 130;
+			for (int i = 0; i < 60; ++i)
+			{
+				engine->Step(1.0 / 60);
+				lowest = std::min(lowest, bouncing->GetParticles().y[0]);
+			}
+
+			// Particle never sank into the body, the other one fell through it
+			Assert::IsTrue(lowest > Scalar(108));
+			Assert::IsTrue(bouncing->GetParticles().y[0] < Scalar(115));
+			Assert::IsTrue(passing->GetParticles().y[0] < Scalar(50));
+		}
+
+		TEST_METHOD(ParticlesBounceOffMovedStaticBody)
+		{
+			EnginePtr engine = CreateWorld();
+			BodyPtr body = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 400, 100 }, fVec2D{ 0, 0 }, 1, IBody::BodyType::Static);
+			engine->AddBody(body);
+			engine->Step(1.0 / 60);
+
+			body->SetPosition(Point{ 100, 100 });
+			ParticleSystemPtr particles = IParticleSystem::Create(1, 1, Scalar(0.5), true);
+			engine->AddParticleSystem(particles);
+			particles->Emit(Point{ 100, 130 }, fVec2D{ 0, 0 }, 10);
+
+			Scalar lowest = 130;
+			for (int i = 0; i < 60; ++i)
+			{
+				engine->Step(1.0 / 60);
+				lowest = std::min(lowest, particles->GetParticles().y[0]);
+			}
+
+			Assert::IsTrue(lowest > Scalar(108));
+		}
+	};
+}
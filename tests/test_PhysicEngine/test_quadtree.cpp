@@ -0,0 +1,162 @@
+#include "CppUnitTest.h"
+
+#include <phys_engine.h>
+#include <phys_linear_quadtree.h>
+#include <phys_quadtree.h>
+#include <phys_workers.h>
+
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace physic;
+
+namespace test_PhysicEngine
+{
+	namespace
+	{
+		using Pair = std::pair<BodyId, BodyId>;
+
+		bool Overlap(const Point& a, Scalar radius_a, const Point& b, Scalar radius_b)
+		{
+			const fVec2D offset = b - a;
+			const Scalar reach = radius_a + radius_b;
+			return SquaredNorm(offset) <= reach * reach;
+		}
+
+		// Overlapping pairs found by looking up every body in tree by its bounding box
+		template <class Tree>
+		std::set<Pair> CollectPairs(const Tree& tree, const std::vector<BodyPtr>& bodies)
+		{
+			std::set<Pair> pairs;
+			for (const auto& body : bodies)
+			{
+				const Point position = body->GetPosition();
+				const Scalar reach = body->GetRadius();
+				const Point bot_left{ position.x - reach, position.y - reach };
+				const Point top_right{ position.x + reach, position.y + reach };
+
+				auto accept = [&](const Point& node_bot_left, const Point& node_top_right)
+				{
+					return node_bot_left.x <= top_right.x && bot_left.x <= node_top_right.x &&
+						node_bot_left.y <= top_right.y && bot_left.y <= node_top_right.y;
+				};
+				auto visit = [&](const typename Tree::Entry& entry)
+				{
+					const BodyId self = body->GetId();
+					const BodyId other = entry.object->GetId();
+					if (self < other && Overlap(position, reach, entry.position, entry.radius))
+						pairs.insert(Pair(self, other));
+					return true;
+				};
+				tree.traverse(accept, visit);
+			}
+			return pairs;
+		}
+	}
+
+	TEST_CLASS(QuadTreeTest)
+	{
+	public:
+
+		TEST_METHOD(LinearTreeFindsSamePairs)
+		{
+			const Point bot_left{ 0, 0 };
+			const Point top_right{ 2048, 2048 };
+
+			// Bodies of different sizes, so nodes grow by different radii
+			const ShapeId shapes[3] = { kDefaultShapeId, IShape::RegisterCircle(4), IShape::RegisterCircle(40) };
+
+			std::mt19937 random(7);
+			std::vector<BodyPtr> bodies;
+			for (int i = 0; i < 3000; ++i)
+			{
+				const Point position{ Scalar(random() % 2000 + 20), Scalar(random() % 2000 + 20) };
+				bodies.push_back(IBody::CreateBody(shapes[random() % 3], position, fVec2D{ 0, 0 }, 1));
+			}
+
+			Workers workers(4);
+			QuadTree<BodyPtr> tree(0, bot_left, top_right);
+			LinearQuadTree<BodyPtr> linear(0, bot_left, top_right, &workers);
+			for (const auto& body : bodies)
+			{
+				Assert::IsTrue(tree.insert(body));
+				Assert::IsTrue(linear.insert(body));
+			}
+			tree.build();
+			linear.build();
+
+			std::set<Pair> brute;
+			for (size_t i = 0; i < bodies.size(); ++i)
+				for (size_t j = 0; j < bodies.size(); ++j)
+				{
+					const BodyPtr& a = bodies[i];
+					const BodyPtr& b = bodies[j];
+					if (a->GetId() < b->GetId() && Overlap(a->GetPosition(), a->GetRadius(), b->GetPosition(), b->GetRadius()))
+						brute.insert(Pair(a->GetId(), b->GetId()));
+				}
+
+			const std::set<Pair> pairs = CollectPairs(tree, bodies);
+			const std::set<Pair> linear_pairs = CollectPairs(linear, bodies);
+			Assert::IsFalse(brute.empty());
+			Assert::IsTrue(brute == pairs);
+			Assert::IsTrue(brute == linear_pairs);
+		}
+
+		TEST_METHOD(LinearTreeFindsSamePairsWhenSplitBetweenThreads)
+		{
+			const Point bot_left{ 0, 0 };
+			const Point top_right{ 16384, 16384 };
+
+			// Enough bodies for sorting to be split between threads. Stacked and crowded bodies
+			// make nodes down to the last level and codes repeat.
+			std::mt19937 random(11);
+			std::vector<BodyPtr> bodies;
+			for (int i = 0; i < 70000; ++i)
+			{
+				const Point position{ Scalar(random() % 16000 + 100), Scalar(random() % 16000 + 100) };
+				bodies.push_back(IBody::CreateBody(kDefaultShapeId, position, fVec2D{ 0, 0 }, 1));
+			}
+			for (int i = 0; i < 100; ++i)
+				bodies.push_back(IBody::CreateBody(kDefaultShapeId, Point{ 5000, 5000 }, fVec2D{ 0, 0 }, 1));
+			for (int i = 0; i < 100; ++i)
+			{
+				const Point position{ Scalar(7000) + Scalar(random() % 8) / 8, Scalar(7000) + Scalar(random() % 8) / 8 };
+				bodies.push_back(IBody::CreateBody(kDefaultShapeId, position, fVec2D{ 0, 0 }, 1));
+			}
+
+			QuadTree<BodyPtr> tree(0, bot_left, top_right);
+			LinearQuadTree<BodyPtr> linear(0, bot_left, top_right);
+			for (const auto& body : bodies)
+			{
+				Assert::IsTrue(tree.insert(body));
+				Assert::IsTrue(linear.insert(body));
+			}
+			tree.build();
+			linear.build();
+
+			const std::set<Pair> pairs = CollectPairs(tree, bodies);
+			Assert::IsTrue(pairs.size() > 100 * 99);
+			Assert::IsTrue(pairs == CollectPairs(linear, bodies));
+
+			// Second build reuses buffers and threads of the first one
+			linear.clear();
+			for (const auto& body : bodies)
+				Assert::IsTrue(linear.insert(body));
+			linear.build();
+			Assert::IsTrue(pairs == CollectPairs(linear, bodies));
+		}
+
+		TEST_METHOD(TreesRejectBodiesOutside)
+		{
+			QuadTree<BodyPtr> tree(0, Point{ 0, 0 }, Point{ 100, 100 });
+			LinearQuadTree<BodyPtr> linear(0, Point{ 0, 0 }, Point{ 100, 100 });
+
+			BodyPtr outside = IBody::CreateBody(kDefaultShapeId, Point{ 150, 50 }, fVec2D{ 0, 0 }, 1);
+			Assert::IsFalse(tree.insert(outside));
+			Assert::IsFalse(linear.insert(outside));
+		}
+	};
+}
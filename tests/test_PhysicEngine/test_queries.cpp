@@ -0,0 +1,213 @@
+#include "CppUnitTest.h"
+
+#include <phys_engine.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace physic;
+
+namespace
+{
+	struct BodyCollector : public IQueryCallback
+	{
+		std::vector<BodyPtr> bodies;
+		size_t limit = SIZE_MAX;
+
+		bool OnBody(const BodyPtr& body) override
+		{
+			bodies.push_back(body);
+			return bodies.size() < limit;
+		}
+
+		bool Found(const BodyPtr& body) const
+		{
+			return std::find(std::begin(bodies), std::end(bodies), body) != std::end(bodies);
+		}
+	};
+
+	struct HitCollector : public IRaycastCallback
+	{
+		std::vector<RaycastHit> hits;
+		size_t limit = SIZE_MAX;
+
+		bool OnHit(const RaycastHit& hit) override
+		{
+			hits.push_back(hit);
+			return hits.size() < limit;
+		}
+	};
+
+	// Three resting bodies in a row along y = 100 and one above the middle one
+	std::vector<BodyPtr> AddScene(const EnginePtr& engine)
+	{
+		engine->SetWorldConstants(0, 0, 0);
+
+		const Point positions[] = { Point{ 100, 100 }, Point{ 200, 100 }, Point{ 300, 100 }, Point{ 200, 300 } };
+		std::vector<BodyPtr> bodies;
+		for (const Point& position : positions)
+		{
+			BodyPtr body = IBody::CreateBody(IShape::ShapeType::Circle, position, fVec2D{ 0, 0 }, 1);
+			engine->AddBody(body);
+			bodies.push_back(body);
+		}
+
+		// Queries see bodies of the last step
+		engine->Step(0.01);
+		return bodies;
+	}
+}
+
+namespace test_PhysicEngine
+{
+	TEST_CLASS(QueryTest)
+	{
+	public:
+
+		TEST_METHOD(RaycastHitsClosestBody)
+		{
+			EnginePtr engine = IEngine::Create();
+			std::vector<BodyPtr> bodies = AddScene(engine);
+
+			RaycastHit hit;
+			Assert::IsTrue(engine->Raycast(Point{ 0, 100 }, Point{ 400, 100 }, hit));
+			Assert::IsTrue(bodies[0] == hit.body);
+			Assert::AreEqual(90.f, static_cast<float>(hit.point.x), 1e-2f);
+			Assert::AreEqual(-1.f, static_cast<float>(hit.normal.x), 1e-3f);
+			Assert::AreEqual(90.f / 400.f, static_cast<float>(hit.fraction), 1e-4f);
+
+			// Ray from the other side hits the last body
+			Assert::IsTrue(engine->Raycast(Point{ 400, 100 }, Point{ 0, 100 }, hit));
+			Assert::IsTrue(bodies[2] == hit.body);
+
+			// Segment ending before the body misses it
+			Assert::IsFalse(engine->Raycast(Point{ 0, 100 }, Point{ 80, 100 }, hit));
+			Assert::IsTrue(nullptr == hit.body);
+			Assert::IsFalse(engine->Raycast(Point{ 0, 200 }, Point{ 400, 200 }, hit));
+		}
+
+		TEST_METHOD(RaycastAllReportsEveryCrossedBody)
+		{
+			EnginePtr engine = IEngine::Create();
+			std::vector<BodyPtr> bodies = AddScene(engine);
+
+			HitCollector all;
+			engine->RaycastAll(Point{ 0, 100 }, Point{ 400, 100 }, all);
+			Assert::AreEqual(size_t(3), all.hits.size());
+			for (const RaycastHit& hit : all.hits)
+				Assert::IsTrue(hit.body != bodies[3]);
+
+			// Callback returning false stops the query
+			HitCollector first;
+			first.limit = 1;
+			engine->RaycastAll(Point{ 0, 100 }, Point{ 400, 100 }, first);
+			Assert::AreEqual(size_t(1), first.hits.size());
+
+			// Vertical ray crosses the middle body and the one above it
+			HitCollector vertical;
+			engine->RaycastAll(Point{ 200, 0 }, Point{ 200, 400 }, vertical);
+			Assert::AreEqual(size_t(2), vertical.hits.size());
+		}
+
+		TEST_METHOD(RaycastBatchMatchesRaycast)
+		{
+			EnginePtr engine = IEngine::Create();
+			AddScene(engine);
+
+			// Enough rays to be split between worker threads
+			std::vector<RaycastRequest> rays;
+			for (int i = 0; i < 1000; ++i)
+				rays.push_back(RaycastRequest{ Point{ 0, Scalar(i % 400) }, Point{ 400, Scalar(400 - i % 400) } });
+
+			std::vector<RaycastHit> hits(rays.size());
+			engine->RaycastBatch(rays.data(), hits.data(), rays.size());
+
+			size_t hit_count = 0;
+			for (size_t i = 0; i < rays.size(); ++i)
+			{
+				RaycastHit expected;
+				const bool found = engine->Raycast(rays[i].from, rays[i].to, expected);
+				Assert::IsTrue(expected.body == hits[i].body);
+				if (found)
+				{
+					Assert::IsTrue(expected.point == hits[i].point);
+					++hit_count;
+				}
+			}
+			Assert::IsTrue(hit_count > 0);
+		}
+
+		TEST_METHOD(RectAndCircleFindOverlappingBodies)
+		{
+			EnginePtr engine = IEngine::Create();
+			std::vector<BodyPtr> bodies = AddScene(engine);
+
+			BodyCollector rect;
+			engine->QueryRect(Point{ 150, 50 }, Point{ 250, 350 }, rect);
+			Assert::AreEqual(size_t(2), rect.bodies.size());
+			Assert::IsTrue(rect.Found(bodies[1]) && rect.Found(bodies[3]));
+
+			// Body overlapping the rectangle only by its radius is found
+			BodyCollector edge;
+			engine->QueryRect(Point{ 305, 0 }, Point{ 400, 400 }, edge);
+			Assert::AreEqual(size_t(1), edge.bodies.size());
+			Assert::IsTrue(edge.Found(bodies[2]));
+
+			BodyCollector circle;
+			engine->QueryCircle(Point{ 200, 200 }, 95, circle);
+			Assert::AreEqual(size_t(2), circle.bodies.size());
+			Assert::IsTrue(circle.Found(bodies[1]) && circle.Found(bodies[3]));
+
+			BodyCollector empty;
+			engine->QueryCircle(Point{ 100, 300 }, 50, empty);
+			Assert::IsTrue(empty.bodies.empty());
+
+			// Callback returning false stops the query
+			BodyCollector first;
+			first.limit = 1;
+			engine->QueryRect(Point{ 0, 0 }, Point{ 400, 400 }, first);
+			Assert::AreEqual(size_t(1), first.bodies.size());
+		}
+
+		TEST_METHOD(NearestAreSortedByDistance)
+		{
+			EnginePtr engine = IEngine::Create();
+			std::vector<BodyPtr> bodies = AddScene(engine);
+
+			NearestHit hits[8];
+			Assert::AreEqual(size_t(2), engine->QueryNearest(Point{ 0, 100 }, 2, hits));
+			Assert::IsTrue(bodies[0] == hits[0].body);
+			Assert::IsTrue(bodies[1] == hits[1].body);
+			Assert::AreEqual(100.f, static_cast<float>(hits[0].distance), 1e-2f);
+			Assert::AreEqual(200.f, static_cast<float>(hits[1].distance), 1e-2f);
+
+			// Less bodies than asked for
+			Assert::AreEqual(size_t(4), engine->QueryNearest(Point{ 200, 280 }, 8, hits));
+			Assert::IsTrue(bodies[3] == hits[0].body);
+			for (size_t i = 1; i < 4; ++i)
+				Assert::IsTrue(hits[i - 1].distance <= hits[i].distance);
+
+			Assert::AreEqual(size_t(0), engine->QueryNearest(Point{ 0, 0 }, 0, hits));
+		}
+
+		TEST_METHOD(QueriesSeeLastStep)
+		{
+			EnginePtr engine = IEngine::Create();
+			AddScene(engine);
+
+			BodyPtr late = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 600, 600 }, fVec2D{ 0, 0 }, 1);
+			engine->AddBody(late);
+
+			BodyCollector before;
+			engine->QueryCircle(Point{ 600, 600 }, 20, before);
+			Assert::IsTrue(before.bodies.empty());
+
+			engine->Step(0.01);
+			BodyCollector after;
+			engine->QueryCircle(Point{ 600, 600 }, 20, after);
+			Assert::IsTrue(after.Found(late));
+		}
+	};
+}
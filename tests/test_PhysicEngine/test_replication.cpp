@@ -0,0 +1,208 @@
+#include "CppUnitTest.h"
+
+#include <phys_engine.h>
+#include <phys_replication.h>
+
+#include <cmath>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace physic;
+
+namespace test_PhysicEngine
+{
+	namespace
+	{
+		EnginePtr CreateServer(std::vector<BodyPtr>& bodies)
+		{
+			EnginePtr server = IEngine::Create();
+			server->SetWorldConstants(0, 0, 0);
+			for (int i = 0; i < 200; ++i)
+			{
+				const Point position{ Scalar(20 + (i % 20) * 45), Scalar(20 + (i / 20) * 45) };
+				const fVec2D velocity = 0 == i % 10 ? fVec2D{ 3, 2 } : fVec2D{ 0, 0 };
+				BodyPtr body = IBody::CreateBody(IShape::ShapeType::Circle, position, velocity, 1);
+				server->AddBody(body);
+				bodies.push_back(body);
+			}
+			return server;
+		}
+	}
+
+	TEST_CLASS(ReplicationTest)
+	{
+	public:
+
+		TEST_METHOD(MirrorFollowsServerDespiteLostPackets)
+		{
+			std::vector<BodyPtr> bodies;
+			EnginePtr server = CreateServer(bodies);
+			EnginePtr mirror = IEngine::Create();
+
+			ReplicationEncoderPtr encoder = IReplicationEncoder::Create();
+			ReplicationDecoderPtr decoder = IReplicationDecoder::Create();
+
+			std::vector<BodyState> states;
+			std::vector<uint8_t> packet;
+			for (int step = 0; step < 64; ++step)
+			{
+				server->Step(0.02);
+				if (30 == step)
+				{
+					server->RemoveBody(bodies[5]);
+					BodyPtr body = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 5, 5 }, fVec2D{ 0, 0 }, 2);
+					server->AddBody(body);
+				}
+
+				server->GetBodyStates(states);
+				packet.clear();
+				encoder->Encode(states.data(), states.size(), packet);
+
+				// Every 7th packet is lost, every 3rd acknowledgement too
+				if (3 == step % 7)
+					continue;
+
+				uint32_t sequence = 0;
+				Assert::IsTrue(decoder->Decode(packet.data(), packet.size(), *mirror, sequence));
+				if (0 != step % 3)
+					encoder->Acknowledge(sequence);
+			}
+
+			// Last packet was delivered, mirror holds the same bodies within precision
+			std::vector<BodyState> mirrored;
+			mirror->GetBodyStates(mirrored);
+			Assert::AreEqual(states.size(), mirrored.size());
+
+			const float tolerance = static_cast<float>(kDefaultReplicationConfig.position_precision) / 2 + 1e-3f;
+			for (const auto& state : states)
+			{
+				bool found = false;
+				for (const auto& copy : mirrored)
+				{
+					if (copy.id != state.id)
+						continue;
+
+					found = true;
+					Assert::AreEqual(static_cast<float>(state.position.x), static_cast<float>(copy.position.x), tolerance);
+					Assert::AreEqual(static_cast<float>(state.position.y), static_cast<float>(copy.position.y), tolerance);
+				}
+				Assert::IsTrue(found);
+			}
+		}
+
+		TEST_METHOD(RejectsForeignAndStalePackets)
+		{
+			std::vector<BodyPtr> bodies;
+			EnginePtr server = CreateServer(bodies);
+			EnginePtr mirror = IEngine::Create();
+
+			ReplicationEncoderPtr encoder = IReplicationEncoder::Create();
+			ReplicationDecoderPtr decoder = IReplicationDecoder::Create();
+
+			std::vector<BodyState> states;
+			server->GetBodyStates(states);
+			std::vector<uint8_t> packet;
+			encoder->Encode(states.data(), states.size(), packet);
+
+			// Format byte of encoder built with other Scalar type
+			std::vector<uint8_t> foreign = packet;
+			foreign[0] ^= 0x03;
+			uint32_t sequence = 0;
+			Assert::IsFalse(decoder->Decode(foreign.data(), foreign.size(), *mirror, sequence));
+
+			// Truncated packet
+			Assert::IsFalse(decoder->Decode(packet.data(), packet.size() / 2, *mirror, sequence));
+
+			Assert::IsTrue(decoder->Decode(packet.data(), packet.size(), *mirror, sequence));
+			// Same packet delivered twice
+			Assert::IsFalse(decoder->Decode(packet.data(), packet.size(), *mirror, sequence));
+		}
+
+		TEST_METHOD(SteppedMirrorIsCorrected)
+		{
+			std::vector<BodyPtr> bodies;
+			EnginePtr server = CreateServer(bodies);
+
+			// Mirror predicts motion with gravity server doesn't have
+			EnginePtr mirror = IEngine::Create();
+			mirror->SetWorldConstants(200, 0, 0);
+
+			ReplicationEncoderPtr encoder = IReplicationEncoder::Create();
+			ReplicationDecoderPtr decoder = IReplicationDecoder::Create();
+
+			std::vector<BodyState> states;
+			std::vector<uint8_t> packet;
+			for (int step = 0; step < 10; ++step)
+			{
+				server->Step(0.02);
+				server->GetBodyStates(states);
+				packet.clear();
+				encoder->Encode(states.data(), states.size(), packet);
+
+				uint32_t sequence = 0;
+				Assert::IsTrue(decoder->Decode(packet.data(), packet.size(), *mirror, sequence));
+				encoder->Acknowledge(sequence);
+
+				// Resting bodies are not in the packet after the first one, yet mirror must not keep falling
+				std::vector<BodyState> mirrored;
+				mirror->GetBodyStates(mirrored);
+				Assert::AreEqual(states.size(), mirrored.size());
+				for (const auto& copy : mirrored)
+				{
+					const BodyPtr& body = bodies[copy.id - bodies.front()->GetId()];
+					const float tolerance = static_cast<float>(kDefaultReplicationConfig.position_precision) / 2 + 1e-3f;
+					Assert::AreEqual(static_cast<float>(body->GetPosition().y), static_cast<float>(copy.position.y), tolerance);
+					Assert::AreEqual(static_cast<float>(body->GetVelocityVector().y), static_cast<float>(copy.velocity.y), tolerance);
+				}
+
+				mirror->Step(0.02);
+			}
+		}
+
+		TEST_METHOD(LostBaselineFallsBackToFullState)
+		{
+			std::vector<BodyPtr> bodies;
+			EnginePtr server = CreateServer(bodies);
+			EnginePtr mirror = IEngine::Create();
+
+			ReplicationEncoderPtr encoder = IReplicationEncoder::Create();
+			ReplicationDecoderPtr decoder = IReplicationDecoder::Create();
+
+			std::vector<BodyState> states;
+			server->GetBodyStates(states);
+			std::vector<uint8_t> full;
+			uint32_t sequence = 0;
+			encoder->Encode(states.data(), states.size(), full);
+			Assert::IsTrue(decoder->Decode(full.data(), full.size(), *mirror, sequence));
+			encoder->Acknowledge(sequence);
+
+			// Next packet holds only moving bodies and can't be decoded without its baseline
+			server->Step(0.02);
+			server->GetBodyStates(states);
+			std::vector<uint8_t> delta;
+			encoder->Encode(states.data(), states.size(), delta);
+			Assert::IsTrue(delta.size() < full.size() / 4);
+
+			EnginePtr late_mirror = IEngine::Create();
+			ReplicationDecoderPtr late_decoder = IReplicationDecoder::Create();
+			Assert::IsFalse(late_decoder->Decode(delta.data(), delta.size(), *late_mirror, sequence));
+			Assert::IsTrue(decoder->Decode(delta.data(), delta.size(), *mirror, sequence));
+
+			// Without acknowledgements encoder gives up on the old baseline and sends full state
+			std::vector<uint8_t> packet;
+			for (int step = 0; step < 40; ++step)
+			{
+				server->Step(0.02);
+				server->GetBodyStates(states);
+				packet.clear();
+				encoder->Encode(states.data(), states.size(), packet);
+			}
+			Assert::IsTrue(packet.size() > full.size() / 2);
+			Assert::IsTrue(late_decoder->Decode(packet.data(), packet.size(), *late_mirror, sequence));
+
+			std::vector<BodyState> mirrored;
+			late_mirror->GetBodyStates(mirrored);
+			Assert::AreEqual(states.size(), mirrored.size());
+		}
+	};
+}
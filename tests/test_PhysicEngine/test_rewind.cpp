@@ -0,0 +1,118 @@
+#include "CppUnitTest.h"
+
+#include <phys_engine.h>
+
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace physic;
+
+namespace test_PhysicEngine
+{
+	TEST_CLASS(RewindTest)
+	{
+	public:
+
+		TEST_METHOD(RewindReplaysSameSteps)
+		{
+			EnginePtr engine = IEngine::Create();
+			engine->SetCheckpointCount(16);
+			for (int i = 0; i < 400; ++i)
+			{
+				const Point position{ Scalar(20 + (i % 20) * 25), Scalar(20 + (i / 20) * 25) };
+				BodyPtr body = IBody::CreateBody(IShape::ShapeType::Circle, position, fVec2D{ Scalar(i % 7 * 3), Scalar(i % 5 * 4) }, 1);
+				engine->AddBody(body);
+			}
+
+			// Body added in the middle of replayed steps has to be added again
+			auto replay = [&engine]()
+			{
+				for (int i = 0; i < 10; ++i)
+				{
+					if (4 == i)
+					{
+						BodyPtr body = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 250, 600 }, fVec2D{ 0, 0 }, 1);
+						engine->AddBody(body);
+					}
+					engine->Step(0.02);
+				}
+			};
+
+			for (int i = 0; i < 30; ++i)
+				engine->Step(0.02);
+			replay();
+
+			std::vector<BodyState> expected;
+			engine->GetBodyStates(expected);
+
+			Assert::IsTrue(engine->Rewind(30));
+			Assert::AreEqual(uint64_t(30), engine->GetStepIndex());
+			std::vector<BodyState> rewound;
+			engine->GetBodyStates(rewound);
+			Assert::AreEqual(size_t(400), rewound.size());
+
+			replay();
+			std::vector<BodyState> replayed;
+			engine->GetBodyStates(replayed);
+			Assert::AreEqual(expected.size(), replayed.size());
+			for (size_t i = 0; i < 400; ++i)
+				Assert::IsTrue(expected[i].position == replayed[i].position && expected[i].velocity == replayed[i].velocity);
+
+			// Steps not done yet and steps older than kept checkpoints can't be returned to
+			Assert::IsFalse(engine->Rewind(10));
+			Assert::IsFalse(engine->Rewind(45));
+		}
+
+		TEST_METHOD(RemovedBodyComesBack)
+		{
+			EnginePtr engine = IEngine::Create();
+			engine->SetWorldConstants(0, 0, 0);
+
+			// Nothing is kept by default
+			engine->Step(0.02);
+			Assert::IsFalse(engine->Rewind(1));
+
+			engine->SetCheckpointCount(4);
+			BodyPtr body = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 100, 100 }, fVec2D{ 10, 0 }, 1);
+			engine->AddBody(body);
+			engine->Step(0.5);
+			const Point kept = body->GetPosition();
+
+			engine->RemoveBody(body);
+			engine->Step(0.5);
+			std::vector<BodyState> states;
+			engine->GetBodyStates(states);
+			Assert::IsTrue(states.empty());
+
+			Assert::IsTrue(engine->Rewind(2));
+			engine->GetBodyStates(states);
+			Assert::AreEqual(size_t(1), states.size());
+			Assert::AreEqual(body->GetId(), states.front().id);
+			Assert::IsTrue(kept == states.front().position);
+		}
+
+		TEST_METHOD(RemovedBodyGetsItsJointBack)
+		{
+			EnginePtr engine = IEngine::Create();
+			engine->SetWorldConstants(0, 0, 0);
+			engine->SetCheckpointCount(4);
+
+			BodyPtr first = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 100, 100 }, fVec2D{ 0, 0 }, 1);
+			BodyPtr second = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 200, 100 }, fVec2D{ 0, 0 }, 1);
+			engine->AddBody(first);
+			engine->AddBody(second);
+			const JointId joint = engine->AddJoint(JointDef{ JointDef::Type::Distance, first, second, 100, 0, 0 });
+			engine->Step(0.1);
+
+			engine->RemoveBody(second);
+			engine->Step(0.1);
+
+			// Joint holds again after rewinding
+			Assert::IsTrue(engine->Rewind(1));
+			second->SetVelocityVector(fVec2D{ 50, 0 });
+			engine->Step(0.1);
+			Assert::AreEqual(100.f, static_cast<float>(second->GetPosition().x - first->GetPosition().x), 0.5f);
+			Assert::IsTrue(engine->RemoveJoint(joint));
+		}
+	};
+}
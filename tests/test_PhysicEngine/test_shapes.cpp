@@ -0,0 +1,69 @@
+#include "CppUnitTest.h"
+
+#include <phys_constants.h>
+#include <phys_engine.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace physic;
+
+namespace test_PhysicEngine
+{
+	TEST_CLASS(ShapeTest)
+	{
+	public:
+
+		TEST_METHOD(SameGeometryIsRegisteredOnce)
+		{
+			const ShapeId shape = IShape::RegisterCircle(23);
+			Assert::AreEqual(shape, IShape::RegisterCircle(23));
+			Assert::AreNotEqual(shape, IShape::RegisterCircle(24));
+			Assert::AreEqual(kDefaultShapeId, IShape::RegisterCircle(kDefaultBodyRadius));
+
+			Assert::IsTrue(IShape::GetShape(shape) == IShape::GetShape(shape));
+			Assert::AreEqual(23, IShape::GetShape(shape)->GetRadius());
+			Assert::IsTrue(nullptr == IShape::GetShape(ShapeId(1000000)));
+		}
+
+		TEST_METHOD(BodiesShareShape)
+		{
+			const ShapeId shape = IShape::RegisterCircle(30);
+			BodyPtr first = IBody::CreateBody(shape, Point{ 100, 100 }, fVec2D{ 0, 0 }, 1);
+			BodyPtr second = IBody::CreateBody(shape, Point{ 200, 100 }, fVec2D{ 0, 0 }, 1);
+
+			Assert::IsTrue(first->GetShape() == second->GetShape());
+			Assert::IsTrue(IShape::GetShape(shape) == first->GetShape());
+			Assert::AreEqual(30.f, static_cast<float>(first->GetRadius()));
+
+			// Body of unknown shape gets the default one
+			BodyPtr unknown = IBody::CreateBody(ShapeId(1000000), Point{ 300, 100 }, fVec2D{ 0, 0 }, 1);
+			Assert::AreEqual(kDefaultShapeId, unknown->GetShapeId());
+			Assert::AreEqual(static_cast<float>(kDefaultBodyRadius), static_cast<float>(unknown->GetRadius()));
+		}
+
+		TEST_METHOD(StateKeepsShape)
+		{
+			const ShapeId shape = IShape::RegisterCircle(30);
+			BodyPtr body = IBody::CreateBody(shape, Point{ 100, 100 }, fVec2D{ 0, 0 }, 1);
+
+			const BodyState state = body->GetState();
+			Assert::AreEqual(shape, state.shape_id);
+			BodyPtr restored = IBody::CreateBody(state);
+			Assert::IsTrue(body->GetShape() == restored->GetShape());
+			Assert::AreEqual(30.f, static_cast<float>(restored->GetRadius()));
+		}
+
+		TEST_METHOD(EngineUsesRadiusOfShape)
+		{
+			EnginePtr engine = IEngine::Create();
+			engine->SetWorldConstants(0, 0, 0);
+			BodyPtr body = IBody::CreateBody(IShape::RegisterCircle(40), Point{ 200, 100 }, fVec2D{ 0, 0 }, 1);
+			engine->AddBody(body);
+			engine->Step(1.0 / 60);
+
+			RaycastHit hit;
+			Assert::IsTrue(engine->Raycast(Point{ 0, 100 }, Point{ 400, 100 }, hit));
+			Assert::IsTrue(body == hit.body);
+			Assert::AreEqual(160.f, static_cast<float>(hit.point.x), 0.01f);
+		}
+	};
+}
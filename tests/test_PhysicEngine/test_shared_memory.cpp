@@ -0,0 +1,151 @@
+#include "CppUnitTest.h"
+
+#include <phys_engine.h>
+#include <phys_export.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace physic;
+
+namespace
+{
+	// Every body of snapshot gets the same id, so torn reads are seen as mixed ids
+	void Publish(const StateExporterPtr& exporter, uint64_t step, size_t count)
+	{
+		size_t capacity = 0;
+		ExportedBody* bodies = exporter->BeginWrite(capacity);
+		const size_t written = std::min(count, capacity);
+		for (size_t i = 0; i < written; ++i)
+			bodies[i] = ExportedBody{ static_cast<BodyId>(step), Point{ Scalar(int(i)), 0 }, fVec2D{ 0, 0 } };
+		exporter->EndWrite(step, written, count);
+	}
+}
+
+namespace test_PhysicEngine
+{
+	TEST_CLASS(SharedMemoryTest)
+	{
+	public:
+
+		TEST_METHOD(ReaderSeesLatestSnapshot)
+		{
+			StateExporterPtr exporter = IStateExporter::Create("phys_test_latest", 16);
+			Assert::IsTrue(nullptr != exporter);
+			StateReaderPtr reader = IStateReader::Open("phys_test_latest");
+			Assert::IsTrue(nullptr != reader);
+
+			StateView view;
+			Assert::IsFalse(reader->Acquire(view));
+
+			Publish(exporter, 7, 3);
+			std::vector<ExportedBody> bodies;
+			uint64_t step = 0;
+			Assert::IsTrue(reader->Read(bodies, step));
+			Assert::AreEqual(uint64_t(7), step);
+			Assert::AreEqual(size_t(3), bodies.size());
+			Assert::IsTrue(Point{ 2, 0 } == bodies[2].position);
+
+			// View points into the region and stays valid until writer comes back to its buffer
+			Assert::IsTrue(reader->Acquire(view));
+			Assert::AreEqual(uint64_t(7), view.step);
+			Assert::AreEqual(size_t(3), view.count);
+			Assert::AreEqual(BodyId(7), view.bodies[0].id);
+			Assert::IsTrue(reader->Validate(view));
+
+			for (uint64_t next = 8; next < 12; ++next)
+				Publish(exporter, next, 3);
+			Assert::IsFalse(reader->Validate(view));
+
+			// Snapshot above capacity keeps the total count
+			Publish(exporter, 12, 20);
+			Assert::IsTrue(reader->Acquire(view));
+			Assert::AreEqual(size_t(16), view.count);
+			Assert::AreEqual(size_t(20), view.total);
+		}
+
+		TEST_METHOD(MissingRegionIsNotOpened)
+		{
+			Assert::IsTrue(nullptr == IStateReader::Open("phys_test_missing"));
+		}
+
+		TEST_METHOD(ReadsAreNeverTorn)
+		{
+			StateExporterPtr exporter = IStateExporter::Create("phys_test_torn", 1024);
+			StateReaderPtr reader = IStateReader::Open("phys_test_torn");
+			Assert::IsTrue(nullptr != exporter && nullptr != reader);
+			Publish(exporter, 1, 1024);
+
+			std::atomic<bool> done(false);
+			std::thread writer([&] {
+				for (uint64_t step = 2; step < 2000; ++step)
+					Publish(exporter, step, 1024);
+				done = true;
+			});
+
+			// Every copy holds bodies of one snapshot only
+			std::vector<ExportedBody> bodies;
+			uint64_t step = 0;
+			uint64_t last = 0;
+			while (!done)
+			{
+				Assert::IsTrue(reader->Read(bodies, step));
+				Assert::IsTrue(step >= last);
+				for (const auto& body : bodies)
+					Assert::AreEqual(static_cast<BodyId>(step), body.id);
+				last = step;
+			}
+			writer.join();
+		}
+
+		TEST_METHOD(EngineExportsEveryStep)
+		{
+			StateExporterPtr exporter = IStateExporter::Create("phys_test_engine", 4);
+			StateReaderPtr reader = IStateReader::Open("phys_test_engine");
+			Assert::IsTrue(nullptr != exporter && nullptr != reader);
+
+			EnginePtr engine = IEngine::Create();
+			engine->SetWorldConstants(0, 0, 0);
+			engine->SetStateExporter(exporter);
+
+			std::vector<BodyPtr> bodies;
+			for (int i = 0; i < 6; ++i)
+			{
+				BodyPtr body = IBody::CreateBody(IShape::ShapeType::Circle, Point{ Scalar(100 + 50 * i), 100 }, fVec2D{ 10, 0 }, 1);
+				engine->AddBody(body);
+				bodies.push_back(body);
+			}
+
+			engine->Step(0.5);
+
+			// Exporter keeps what fits and counts the rest
+			StateView view;
+			Assert::IsTrue(reader->Acquire(view));
+			Assert::AreEqual(engine->GetStepIndex(), view.step);
+			Assert::AreEqual(size_t(4), view.count);
+			Assert::AreEqual(size_t(6), view.total);
+			for (size_t i = 0; i < view.count; ++i)
+			{
+				const ExportedBody& exported = view.bodies[i];
+				bool found = false;
+				for (const auto& body : bodies)
+					if (body->GetId() == exported.id)
+					{
+						Assert::IsTrue(body->GetPosition() == exported.position);
+						Assert::IsTrue(body->GetVelocityVector() == exported.velocity);
+						found = true;
+					}
+				Assert::IsTrue(found);
+			}
+			Assert::IsTrue(reader->Validate(view));
+
+			engine->SetStateExporter(nullptr);
+			engine->Step(0.5);
+			Assert::IsTrue(reader->Acquire(view));
+			Assert::AreEqual(uint64_t(1), view.step);
+		}
+	};
+}
@@ -0,0 +1,219 @@
+#include "CppUnitTest.h"
+
+#include <phys_engine.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace physic;
+
+namespace
+{
+	namespace fs = std::filesystem;
+
+	class ChunkRecorder : public IChunkListener
+	{
+	public:
+		void OnBodiesUnloaded(const BodyPtr* bodies, size_t count) override
+		{
+			unloaded.insert(unloaded.end(), bodies, bodies + count);
+		}
+
+		void OnBodiesLoaded(const BodyPtr* bodies, size_t count) override
+		{
+			loaded.insert(loaded.end(), bodies, bodies + count);
+			for (size_t i = 0; i < count; ++i)
+				loaded_states.push_back(bodies[i]->GetState());
+		}
+
+		void OnChunkDamaged(const std::string& path) override
+		{
+			damaged.push_back(path);
+		}
+
+		std::vector<BodyPtr> unloaded;
+		std::vector<BodyPtr> loaded;
+		// States as read, before loaded bodies are stepped
+		std::vector<BodyState> loaded_states;
+		std::vector<std::string> damaged;
+	};
+
+	// Empty directory of its own for every test
+	fs::path MakeDirectory(const std::string& name)
+	{
+		const fs::path directory = fs::temp_directory_path() / name;
+		fs::remove_all(directory);
+		fs::create_directories(directory);
+		return directory;
+	}
+
+	std::vector<fs::path> ListFiles(const fs::path& directory)
+	{
+		std::vector<fs::path> files;
+		for (const auto& entry : fs::directory_iterator(directory))
+			files.push_back(entry.path());
+		return files;
+	}
+
+	// Region of the first chunk only, body far from it is streamed out
+	const ActivityRegion kNearRegion = { Point{ 0, 0 }, Point{ 500, 500 } };
+	const ActivityRegion kFarRegion = { Point{ 5000, 5000 }, Point{ 5500, 5500 } };
+}
+
+namespace test_PhysicEngine
+{
+	TEST_CLASS(StreamingTest)
+	{
+	public:
+
+		TEST_METHOD(ChunkRoundTrip)
+		{
+			const fs::path directory = MakeDirectory("phys_streaming_round_trip");
+			ChunkRecorder recorder;
+
+			EnginePtr engine = IEngine::Create();
+			engine->SetWorldConstants(0, 0, 0);
+			engine->SetStreamingDirectory(directory.string());
+			engine->SetChunkListener(&recorder);
+			engine->SetActivityRegions(&kNearRegion, 1);
+
+			BodyPtr body = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 5200, 5200 }, fVec2D{ 3, -4 }, 2);
+			body->SetBounceFactor(Scalar(0.5));
+			body->SetSensor(true);
+			body->SetCollisionFilter({ 0x0004, 0x00F0, -2 });
+			engine->AddBody(body);
+			const BodyState saved = body->GetState();
+
+			engine->Step(0.01);
+			Assert::AreEqual(size_t(1), recorder.unloaded.size());
+			Assert::IsTrue(body == recorder.unloaded.front());
+			Assert::AreEqual(size_t(1), ListFiles(directory).size());
+
+			engine->SetActivityRegions(&kFarRegion, 1);
+			engine->Step(0.01);
+			Assert::AreEqual(size_t(1), recorder.loaded.size());
+			Assert::IsTrue(recorder.damaged.empty());
+			Assert::IsTrue(ListFiles(directory).empty());
+
+			// Loaded body is a new object with all fields of the saved one
+			const BodyState& state = recorder.loaded_states.front();
+			Assert::IsTrue(body != recorder.loaded.front());
+			Assert::AreEqual(saved.id, state.id);
+			Assert::IsTrue(saved.type == state.type);
+			Assert::AreEqual(saved.shape_id, state.shape_id);
+			Assert::IsTrue(saved.position == state.position);
+			Assert::IsTrue(saved.velocity == state.velocity);
+			Assert::IsTrue(saved.mass == state.mass);
+			Assert::IsTrue(saved.bounce_factor == state.bounce_factor);
+			Assert::IsTrue(state.sensor);
+			Assert::AreEqual(saved.filter.category, state.filter.category);
+			Assert::AreEqual(saved.filter.mask, state.filter.mask);
+			Assert::AreEqual(saved.filter.group, state.filter.group);
+
+			fs::remove_all(directory);
+		}
+
+		TEST_METHOD(TruncatedChunkKeepsValidBodies)
+		{
+			const fs::path directory = MakeDirectory("phys_streaming_truncated");
+			ChunkRecorder recorder;
+
+			EnginePtr engine = IEngine::Create();
+			engine->SetWorldConstants(0, 0, 0);
+			engine->SetStreamingDirectory(directory.string());
+			engine->SetChunkListener(&recorder);
+			engine->SetActivityRegions(&kNearRegion, 1);
+
+			BodyPtr first = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 5150, 5150 }, fVec2D{ 0, 0 }, 1);
+			BodyPtr second = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 5250, 5250 }, fVec2D{ 0, 0 }, 1);
+			engine->AddBody(first);
+			engine->AddBody(second);
+			engine->Step(0.01);
+			Assert::AreEqual(size_t(2), recorder.unloaded.size());
+
+			// Cut the last record in half
+			const std::vector<fs::path> files = ListFiles(directory);
+			Assert::AreEqual(size_t(1), files.size());
+			const uintmax_t size = fs::file_size(files.front());
+			fs::resize_file(files.front(), size - size / 4);
+
+			engine->SetActivityRegions(&kFarRegion, 1);
+			for (int i = 0; i < 5; ++i)
+				engine->Step(0.01);
+
+			// The whole record came back, the damaged file is reported once and kept aside
+			Assert::AreEqual(size_t(1), recorder.loaded.size());
+			Assert::AreEqual(recorder.unloaded.front()->GetId(), recorder.loaded.front()->GetId());
+			Assert::AreEqual(size_t(1), recorder.damaged.size());
+			Assert::IsTrue(files.front().string() == recorder.damaged.front());
+			Assert::IsFalse(fs::exists(files.front()));
+			Assert::IsTrue(fs::exists(files.front().string() + ".bad"));
+
+			fs::remove_all(directory);
+		}
+
+		TEST_METHOD(RewindAcrossStreamOut)
+		{
+			const fs::path directory = MakeDirectory("phys_streaming_rewind");
+
+			EnginePtr engine = IEngine::Create();
+			engine->SetWorldConstants(0, 0, 0);
+			engine->SetStreamingDirectory(directory.string());
+			engine->SetCheckpointCount(8);
+
+			BodyPtr near = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 100, 100 }, fVec2D{ 0, 0 }, 1);
+			BodyPtr far = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 5200, 5200 }, fVec2D{ 10, 0 }, 1);
+			engine->AddBody(near);
+			engine->AddBody(far);
+			const JointId joint = engine->AddJoint(JointDef{ JointDef::Type::Rope, near, far, 8000, 0, 0 });
+			engine->Step(0.5);
+			const Point kept = far->GetPosition();
+
+			auto countBodies = [&engine]()
+			{
+				std::vector<BodyState> states;
+				engine->GetBodyStates(states);
+				return states.size();
+			};
+
+			// Body streamed out after the checkpoint is back in memory and its file is gone
+			engine->SetActivityRegions(&kNearRegion, 1);
+			engine->Step(0.5);
+			Assert::AreEqual(size_t(1), countBodies());
+			Assert::AreEqual(size_t(1), ListFiles(directory).size());
+
+			Assert::IsTrue(engine->Rewind(1));
+			Assert::AreEqual(size_t(2), countBodies());
+			Assert::IsTrue(kept == far->GetPosition());
+			Assert::IsTrue(ListFiles(directory).empty());
+
+			// Regions still hold, so it is streamed out again, but only once
+			engine->Step(0.5);
+			Assert::AreEqual(size_t(1), countBodies());
+			Assert::AreEqual(size_t(1), ListFiles(directory).size());
+			engine->Step(0.5);
+
+			// Body read back after the checkpoint is on disk again
+			engine->SetActivityRegions(nullptr, 0);
+			engine->Step(0.5);
+			Assert::AreEqual(size_t(2), countBodies());
+			Assert::IsTrue(engine->Rewind(3));
+			Assert::AreEqual(size_t(1), countBodies());
+			Assert::AreEqual(size_t(1), ListFiles(directory).size());
+
+			engine->Step(0.5);
+			std::vector<BodyState> states;
+			engine->GetBodyStates(states);
+			Assert::AreEqual(size_t(2), states.size());
+			Assert::AreNotEqual(states[0].id, states[1].id);
+			Assert::IsTrue(engine->RemoveJoint(joint));
+
+			// File kept for checkpoints goes with the engine
+			engine.reset();
+			Assert::IsTrue(ListFiles(directory).empty());
+			fs::remove_all(directory);
+		}
+	};
+}
@@ -0,0 +1,83 @@
+#include "CppUnitTest.h"
+
+#include <phys_engine.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace physic;
+
+namespace test_PhysicEngine
+{
+	TEST_CLASS(TerrainTest)
+	{
+	public:
+
+		TEST_METHOD(BodyRestsOnHeightfield)
+		{
+			EnginePtr engine = IEngine::Create();
+			engine->SetWorldConstants(200, 0, 0);
+
+			const Scalar heights[9] = { 100, 100, 100, 100, 100, 100, 100, 100, 100 };
+			const TerrainId ground = engine->AddHeightfield(Point{ 0, 0 }, 50, heights, 9);
+
+			BodyPtr body = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 200, 300 }, fVec2D{ 0, 0 }, 1);
+			body->SetBounceFactor(Scalar(0.2));
+			engine->AddBody(body);
+			for (int i = 0; i < 600; ++i)
+				engine->Step(1.0 / 60);
+
+			// Resting on the ground, not sunk into it
+			const Scalar rest = 100 + body->GetRadius();
+			Assert::AreEqual(static_cast<float>(rest), static_cast<float>(body->GetPosition().y), 2.f);
+			Assert::AreEqual(200.f, static_cast<float>(body->GetPosition().x), 1.f);
+
+			Assert::IsTrue(engine->RemoveTerrain(ground));
+			Assert::IsFalse(engine->RemoveTerrain(ground));
+			for (int i = 0; i < 60; ++i)
+				engine->Step(1.0 / 60);
+
+			Assert::IsTrue(body->GetPosition().y < 100);
+		}
+
+		TEST_METHOD(BodyRestsOnChainCorner)
+		{
+			EnginePtr engine = IEngine::Create();
+			engine->SetWorldConstants(200, 0, 0);
+
+			const Point ground[3] = { Point{ 0, 100 }, Point{ 200, 100 }, Point{ 400, 100 } };
+			engine->AddSegmentChain(ground, 3, false);
+
+			// Dropped right onto the point joining two flat segments
+			BodyPtr body = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 200, 300 }, fVec2D{ 0, 0 }, 1);
+			body->SetBounceFactor(Scalar(0.2));
+			engine->AddBody(body);
+			for (int i = 0; i < 600; ++i)
+				engine->Step(1.0 / 60);
+
+			const Scalar rest = 100 + body->GetRadius();
+			Assert::AreEqual(static_cast<float>(rest), static_cast<float>(body->GetPosition().y), 2.f);
+			Assert::AreEqual(200.f, static_cast<float>(body->GetPosition().x), 0.5f);
+		}
+
+		TEST_METHOD(ClosedChainKeepsBodyInside)
+		{
+			EnginePtr engine = IEngine::Create();
+			engine->SetWorldConstants(0, 0, 0);
+
+			const Point box[4] = { Point{ 100, 100 }, Point{ 500, 100 }, Point{ 500, 500 }, Point{ 100, 500 } };
+			engine->AddSegmentChain(box, 4, true);
+
+			BodyPtr body = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 300, 300 }, fVec2D{ 300, 170 }, 1);
+			engine->AddBody(body);
+			bool bounced = false;
+			for (int i = 0; i < 600; ++i)
+			{
+				engine->Step(1.0 / 60);
+
+				const Point position = body->GetPosition();
+				Assert::IsTrue(position.x > 100 && position.x < 500 && position.y > 100 && position.y < 500);
+				bounced = bounced || body->GetVelocityVector().x < 0;
+			}
+			Assert::IsTrue(bounced);
+		}
+	};
+}
@@ -0,0 +1,157 @@
+#include "CppUnitTest.h"
+
+#include <phys_engine.h>
+#include <phys_region.h>
+#include <phys_transport.h>
+
+#include <cstring>
+#include <future>
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace physic;
+
+namespace
+{
+	bool SendValue(const TransportPtr& transport, int peer, int value)
+	{
+		return transport->Send(peer, &value, sizeof(value));
+	}
+
+	int ReadValue(const std::vector<uint8_t>& message)
+	{
+		int value = 0;
+		Assert::AreEqual(sizeof(value), message.size());
+		std::memcpy(&value, message.data(), sizeof(value));
+		return value;
+	}
+}
+
+namespace test_PhysicEngine
+{
+	TEST_CLASS(TransportTest)
+	{
+	public:
+
+		TEST_METHOD(LocalMessagesKeepOrderOfPeer)
+		{
+			std::vector<TransportPtr> nodes = ITransport::CreateLocal(3);
+			Assert::AreEqual(size_t(3), nodes.size());
+			for (int i = 0; i < 3; ++i)
+			{
+				Assert::AreEqual(i, nodes[i]->GetSelf());
+				Assert::AreEqual(3, nodes[i]->GetPeerCount());
+			}
+
+			for (int value = 0; value < 10; ++value)
+			{
+				Assert::IsTrue(SendValue(nodes[1], 0, value));
+				Assert::IsTrue(SendValue(nodes[2], 0, 100 + value));
+			}
+
+			int next[3] = { 0, 0, 100 };
+			for (int i = 0; i < 20; ++i)
+			{
+				int peer = -1;
+				std::vector<uint8_t> message;
+				Assert::IsTrue(nodes[0]->Receive(peer, message));
+				Assert::IsTrue(1 == peer || 2 == peer);
+				Assert::AreEqual(next[peer]++, ReadValue(message));
+			}
+
+			// Empty message is delivered as well
+			Assert::IsTrue(nodes[0]->Send(1, nullptr, 0));
+			int peer = -1;
+			std::vector<uint8_t> message(4);
+			Assert::IsTrue(nodes[1]->Receive(peer, message));
+			Assert::AreEqual(0, peer);
+			Assert::IsTrue(message.empty());
+		}
+
+		TEST_METHOD(SocketNodesExchangeMessages)
+		{
+			const std::vector<std::string> addresses = { "127.0.0.1:47651", "127.0.0.1:47652" };
+
+			// Creation blocks until all nodes are connected
+			auto second = std::async(std::launch::async, [&addresses] { return ITransport::CreateSocket(addresses, 1); });
+			TransportPtr first = ITransport::CreateSocket(addresses, 0);
+			TransportPtr other = second.get();
+			Assert::IsTrue(nullptr != first && nullptr != other);
+			Assert::AreEqual(1, other->GetSelf());
+			Assert::AreEqual(2, first->GetPeerCount());
+
+			for (int value = 0; value < 100; ++value)
+				Assert::IsTrue(SendValue(first, 1, value));
+			Assert::IsTrue(SendValue(other, 0, -1));
+
+			for (int value = 0; value < 100; ++value)
+			{
+				int peer = -1;
+				std::vector<uint8_t> message;
+				Assert::IsTrue(other->Receive(peer, message));
+				Assert::AreEqual(0, peer);
+				Assert::AreEqual(value, ReadValue(message));
+			}
+
+			int peer = -1;
+			std::vector<uint8_t> message;
+			Assert::IsTrue(first->Receive(peer, message));
+			Assert::AreEqual(1, peer);
+			Assert::AreEqual(-1, ReadValue(message));
+		}
+
+		TEST_METHOD(RegionNodesHandOffBody)
+		{
+			const RegionGrid grid = { Point{ 0, 0 }, Point{ 2000, 1000 }, 2, 1, 40 };
+			std::vector<TransportPtr> transports = ITransport::CreateLocal(2);
+
+			EnginePtr engines[2] = { IEngine::Create(), IEngine::Create() };
+			RegionNodePtr nodes[2];
+			for (int i = 0; i < 2; ++i)
+			{
+				engines[i]->SetWorldConstants(0, 0, 0);
+				nodes[i] = IRegionNode::Create(*engines[i], transports[i], grid);
+				Assert::AreEqual(i, nodes[i]->GetRegion());
+			}
+
+			// Body crosses the border between regions at x = 1000
+			BodyPtr body = IBody::CreateBody(IShape::ShapeType::Circle, Point{ 900, 500 }, fVec2D{ 100, 0 }, 1);
+			const BodyId id = body->GetId();
+			nodes[0]->AddBody(body);
+
+			// Every node blocks until its neighbour finishes the same step
+			for (int i = 0; i < 120; ++i)
+			{
+				auto other = std::async(std::launch::async, [&nodes] { return nodes[1]->Step(1.0 / 60); });
+				Assert::IsTrue(nodes[0]->Step(1.0 / 60));
+				Assert::IsTrue(other.get());
+			}
+
+			Assert::IsTrue(nodes[0]->GetOwnedBodies().empty());
+			Assert::AreEqual(size_t(1), nodes[1]->GetOwnedBodies().size());
+
+			const BodyPtr& received = nodes[1]->GetOwnedBodies().front();
+			Assert::AreEqual(id, received->GetId());
+			Assert::AreEqual(1100.f, static_cast<float>(received->GetPosition().x), 0.5f);
+			Assert::AreEqual(100.f, static_cast<float>(received->GetVelocityVector().x), 1e-3f);
+		}
+
+		TEST_METHOD(RegionNodeRejectsTruncatedMessage)
+		{
+			const RegionGrid grid = { Point{ 0, 0 }, Point{ 2000, 1000 }, 2, 1, 40 };
+			std::vector<TransportPtr> transports = ITransport::CreateLocal(2);
+
+			EnginePtr engine = IEngine::Create();
+			RegionNodePtr node = IRegionNode::Create(*engine, transports[0], grid);
+
+			// Little endian header of first step announcing one handoff, cut inside the state
+			const uint8_t message[] = { 1, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 7, 0, 0 };
+			Assert::IsTrue(transports[1]->Send(0, message, sizeof(message)));
+
+			Assert::IsFalse(node->Step(1.0 / 60));
+			Assert::IsTrue(node->GetOwnedBodies().empty());
+			Assert::AreEqual(size_t(0), engine->ExportBodies(nullptr, 0));
+		}
+	};
+}